@@ -0,0 +1,280 @@
+// Standard drive-cycle benchmark: throughput, per-function cost and energy use of the VMU, EV and
+// IEC models over a fixed set of synthetic cycles that together take every path of the control law.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "../common/clock.h"
+#include "../ev/ev_model.h"
+#include "../iec/iec_model.h"
+
+#define BENCH_MIN_CALLS 200000 // Calls per timed pass of a single function
+
+const DriveCycle drive_cycles[] = {
+    {"urban", "Stop-and-go city traffic below the hybrid threshold", MAX_BATTERY, MAX_FUEL,
+     "1:8,0:3,2:4,0:5,1:12,2:6,0:4", 20},
+    {"highway", "Merge, cruise in hybrid mode and exit", MAX_BATTERY, MAX_FUEL,
+     "1:60,0:8,1:12,0:8,1:12,0:8,1:12,0:30,2:10,0:2", 3},
+    {"low_battery", "City driving from a nearly flat battery, charging from the IEC", 8.0, MAX_FUEL,
+     "1:30,0:20,2:10,0:20,1:30,2:15,0:15", 4},
+    {"low_fuel", "Highway run on the last of the fuel, until the battery is flat too", 16.0, 6.0,
+     "1:120,0:10,1:60,2:15,0:5", 8},
+    {"sustained_braking", "Long descents held on the brake from speed", MAX_BATTERY, MAX_FUEL,
+     "1:45,2:25,0:3,1:30,2:40,0:5", 6},
+};
+const int drive_cycle_count = sizeof(drive_cycles) / sizeof(drive_cycles[0]);
+
+static const char *branch_names[BRANCH_COUNT] = {
+    "accelerate_ev", "accelerate_hybrid", "accelerate_iec_only", "accelerate_low_fuel",
+    "accelerate_low_fuel_limit", "accelerate_no_propulsion", "regen_brake", "coast",
+    "coast_charge", "stopped", "stopped_charge",
+};
+
+static const char *function_names[BENCH_FN_COUNT] = {
+    "vmu_control_model", "speed_model", "ev_engine_model", "iec_engine_model",
+};
+
+static volatile double bench_sink; // Keeps the timed results alive
+
+const char *control_branch_name(ControlBranch branch) {
+    return branch_names[branch];
+}
+
+const char *bench_function_name(BenchFunction function) {
+    return function_names[function];
+}
+
+// Path vmu_control_model() takes from `vehicle`, using the same conditions in the same order
+ControlBranch control_branch(const VehicleState *vehicle) {
+    bool battery_ok = vehicle->battery > BATTERY_CRITICAL_THRESHOLD;
+    bool fuel_ok = vehicle->fuel > FUEL_CRITICAL_THRESHOLD;
+
+    if (vehicle->accelerator) {
+        if (battery_ok && fuel_ok) {
+            return vehicle->speed < ELECTRIC_ONLY_SPEED_THRESHOLD ? BRANCH_ACCEL_EV : BRANCH_ACCEL_HYBRID;
+        } else if (!battery_ok && fuel_ok) {
+            return BRANCH_ACCEL_IEC_ONLY;
+        } else if (battery_ok && !fuel_ok) {
+            return vehicle->speed < EV_ONLY_SPEED_LIMIT ? BRANCH_ACCEL_LOW_FUEL : BRANCH_ACCEL_LOW_FUEL_LIMIT;
+        }
+        return BRANCH_ACCEL_NO_PROPULSION;
+    }
+
+    bool charge = !battery_ok && fuel_ok && !vehicle->brake;
+    if (vehicle->brake && vehicle->speed > MIN_SPEED) {
+        return BRANCH_REGEN_BRAKE;
+    } else if (vehicle->speed > MIN_SPEED) {
+        return charge ? BRANCH_COAST_CHARGE : BRANCH_COAST;
+    }
+    return charge ? BRANCH_STOPPED_CHARGE : BRANCH_STOPPED;
+}
+
+const DriveCycle *find_drive_cycle(const char *name) {
+    for (int i = 0; i < drive_cycle_count; i++) {
+        if (strcmp(drive_cycles[i].name, name) == 0) {
+            return &drive_cycles[i];
+        }
+    }
+    return NULL;
+}
+
+// Sets up `sim` at the start of `cycle` and parses its script. Returns 1 on success, 0 if the
+// script is malformed.
+int bench_cycle_start(Simulation *sim, const DriveCycle *cycle, PedalScript *script) {
+    sim_init(sim, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    sim->vehicle.battery = cycle->battery;
+    sim->vehicle.fuel = cycle->fuel;
+    return parse_pedal_script(cycle->script, script);
+}
+
+// What record_cycle() keeps of each step
+typedef struct {
+    VehicleState *vmu_inputs;
+    VehicleState *engine_inputs;
+    unsigned long *branches;
+} CycleRecording;
+
+// Step hook of record_cycle(): the state the step starts from, and the control path of VMU steps
+static void record_step(Simulation *sim, SimStep step, void *context) {
+    CycleRecording *recording = (CycleRecording *)context;
+    if (step == SIM_STEP_ENGINE) {
+        recording->engine_inputs[sim->engine_steps] = sim->vehicle;
+    } else {
+        recording->vmu_inputs[sim->vmu_steps] = sim->vehicle;
+        recording->branches[control_branch(&sim->vehicle)]++;
+    }
+}
+
+// Plays the cycle once with sim_run_script(), counting the control paths taken and keeping the
+// state every model call starts from so each function can be timed alone on realistic inputs
+static int record_cycle(const DriveCycle *cycle, CycleResult *result, VehicleState **vmu_inputs,
+                        VehicleState **engine_inputs) {
+    Simulation sim;
+    PedalScript script;
+    if (!bench_cycle_start(&sim, cycle, &script)) {
+        return -1;
+    }
+
+    double duration_s = 0.0;
+    for (int i = 0; i < script.count; i++) {
+        duration_s += script.segments[i].duration_s;
+    }
+    // One spare step per segment for the rounding of the segment ends
+    size_t max_vmu = (size_t)(duration_s * 1e9 / sim.vmu_period_ns + script.count + 1) * cycle->repeat;
+    size_t max_engine = (size_t)(duration_s * 1e9 / sim.engine_period_ns + script.count + 1) * cycle->repeat;
+    *vmu_inputs = malloc(max_vmu * sizeof(VehicleState));
+    *engine_inputs = malloc(max_engine * sizeof(VehicleState));
+    if (*vmu_inputs == NULL || *engine_inputs == NULL) {
+        free(*vmu_inputs);
+        free(*engine_inputs);
+        return -1;
+    }
+
+    memset(result->branches, 0, sizeof(result->branches));
+    CycleRecording recording = { *vmu_inputs, *engine_inputs, result->branches };
+    sim.step_hook = record_step;
+    sim.step_hook_context = &recording;
+    sim_run_script(&sim, &script, cycle->repeat, NULL);
+
+    result->simulated_s = sim.time_ns / 1e9;
+    result->vmu_steps = sim.vmu_steps;
+    result->engine_steps = sim.engine_steps;
+    result->commands = sim.commands;
+    result->battery = sim.vehicle.battery;
+    result->fuel = sim.vehicle.fuel;
+    result->speed = sim.vehicle.speed;
+    result->distance_km = sim.distance_km;
+    return 0;
+}
+
+// Mean cost in nanoseconds of one call of `function` over the recorded inputs, best of `runs`
+// passes. Each call includes copying its recorded input out of the array.
+static double time_function(BenchFunction function, const VehicleState *inputs, size_t count, int runs) {
+    size_t passes = (BENCH_MIN_CALLS + count - 1) / count;
+    double best = 0.0;
+
+    for (int run = 0; run < runs; run++) {
+        double sink = 0.0;
+        unsigned long long start = monotonic_ns();
+        for (size_t pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i < count; i++) {
+                const VehicleState *input = &inputs[i];
+                switch (function) {
+                    case BENCH_FN_CONTROL: {
+                        VehicleState vehicle = *input;
+                        ControlCommands commands;
+                        vmu_control_model(&vehicle, &commands);
+                        sink += vehicle.battery + commands.send_ev;
+                        break;
+                    }
+                    case BENCH_FN_SPEED:
+                        sink += speed_model(input);
+                        break;
+                    case BENCH_FN_EV: {
+                        int rpm = input->rpm_ev;
+                        double temp = input->temp_ev;
+                        ev_engine_model(input->ev_on, input->ev_power_level, &rpm, &temp);
+                        sink += rpm + temp;
+                        break;
+                    }
+                    default: {
+                        int rpm = input->rpm_iec;
+                        double temp = input->temp_iec;
+                        iec_engine_model(input->iec_on, input->iec_power_level, &rpm, &temp);
+                        sink += rpm + temp;
+                        break;
+                    }
+                }
+            }
+        }
+        double ns = (double)(monotonic_ns() - start) / (double)(passes * count);
+        bench_sink = sink;
+        if (run == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+// Measures `cycle`, keeping the best of `runs` timed runs. Returns 0 on success, -1 on error.
+int bench_run_cycle(const DriveCycle *cycle, int runs, CycleResult *result) {
+    VehicleState *vmu_inputs, *engine_inputs;
+
+    memset(result, 0, sizeof(*result));
+    result->cycle = cycle;
+    if (record_cycle(cycle, result, &vmu_inputs, &engine_inputs) != 0) {
+        return -1;
+    }
+
+    // Whole cycles exactly as bin/sim plays them
+    for (int run = 0; run < runs; run++) {
+        Simulation sim;
+        PedalScript script;
+        bench_cycle_start(&sim, cycle, &script);
+        unsigned long long start = monotonic_ns();
+        sim_run_script(&sim, &script, cycle->repeat, NULL);
+        double wall_s = (monotonic_ns() - start) / 1e9;
+        if (run == 0 || wall_s < result->wall_s) {
+            result->wall_s = wall_s;
+        }
+    }
+    result->ticks_per_second = result->wall_s > 0.0 ? (result->vmu_steps + result->engine_steps) / result->wall_s : 0.0;
+
+    result->function_ns[BENCH_FN_CONTROL] = time_function(BENCH_FN_CONTROL, vmu_inputs, result->vmu_steps, runs);
+    result->function_ns[BENCH_FN_SPEED] = time_function(BENCH_FN_SPEED, vmu_inputs, result->vmu_steps, runs);
+    result->function_ns[BENCH_FN_EV] = time_function(BENCH_FN_EV, engine_inputs, result->engine_steps, runs);
+    result->function_ns[BENCH_FN_IEC] = time_function(BENCH_FN_IEC, engine_inputs, result->engine_steps, runs);
+
+    free(vmu_inputs);
+    free(engine_inputs);
+    return 0;
+}
+
+// Writes the results as one JSON document, stable in field order so reports diff cleanly
+void bench_write_json(FILE *out, const CycleResult *results, int count, int runs) {
+    unsigned long covered[BRANCH_COUNT] = {0};
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"drive-cycles\",\n");
+    fprintf(out, "  \"format_version\": %d,\n", BENCH_FORMAT_VERSION);
+    fprintf(out, "  \"vmu_period_ms\": %.1f,\n", VMU_PERIOD_NS / 1e6);
+    fprintf(out, "  \"engine_period_ms\": %.1f,\n", ENGINE_PERIOD_NS / 1e6);
+    fprintf(out, "  \"runs\": %d,\n", runs);
+    fprintf(out, "  \"cycles\": [\n");
+    for (int c = 0; c < count; c++) {
+        const CycleResult *r = &results[c];
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"name\": \"%s\",\n", r->cycle->name);
+        fprintf(out, "      \"simulated_s\": %.3f,\n", r->simulated_s);
+        fprintf(out, "      \"vmu_ticks\": %lu,\n", r->vmu_steps);
+        fprintf(out, "      \"engine_ticks\": %lu,\n", r->engine_steps);
+        fprintf(out, "      \"commands\": %lu,\n", r->commands);
+        fprintf(out, "      \"wall_s\": %.9f,\n", r->wall_s);
+        fprintf(out, "      \"ticks_per_second\": %.0f,\n", r->ticks_per_second);
+        fprintf(out, "      \"ns_per_call\": {");
+        for (int f = 0; f < BENCH_FN_COUNT; f++) {
+            fprintf(out, "%s\"%s\": %.2f", f ? ", " : "", function_names[f], r->function_ns[f]);
+        }
+        fprintf(out, "},\n");
+        fprintf(out, "      \"end\": {\"battery\": %.4f, \"fuel\": %.4f, \"speed\": %.4f, \"distance_km\": %.4f},\n",
+                r->battery, r->fuel, r->speed, r->distance_km);
+        fprintf(out, "      \"branches\": {");
+        for (int b = 0; b < BRANCH_COUNT; b++) {
+            fprintf(out, "%s\"%s\": %lu", b ? ", " : "", branch_names[b], r->branches[b]);
+            covered[b] += r->branches[b];
+        }
+        fprintf(out, "}\n");
+        fprintf(out, "    }%s\n", c + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+    fprintf(out, "  \"uncovered_branches\": [");
+    int uncovered = 0;
+    for (int b = 0; b < BRANCH_COUNT; b++) {
+        if (covered[b] == 0) {
+            fprintf(out, "%s\"%s\"", uncovered++ ? ", " : "", branch_names[b]);
+        }
+    }
+    fprintf(out, "]\n");
+    fprintf(out, "}\n");
+}
@@ -0,0 +1,72 @@
+// bench.h
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include "../sim/sim.h"
+
+#define BENCH_FORMAT_VERSION 1 // Bumped whenever the JSON report changes incompatibly
+
+// Paths through the VMU control law, told apart by the state it starts the step from
+typedef enum {
+    BRANCH_ACCEL_EV,             // Accelerating below the hybrid threshold: EV only
+    BRANCH_ACCEL_HYBRID,         // Accelerating above the hybrid threshold: EV and IEC
+    BRANCH_ACCEL_IEC_ONLY,       // Accelerating on a critical battery: IEC only
+    BRANCH_ACCEL_LOW_FUEL,       // Accelerating on critical fuel below the EV-only speed limit
+    BRANCH_ACCEL_LOW_FUEL_LIMIT, // Accelerating on critical fuel at or above the EV-only speed limit
+    BRANCH_ACCEL_NO_PROPULSION,  // Accelerating with both battery and fuel critical
+    BRANCH_REGEN_BRAKE,          // Braking while moving
+    BRANCH_COAST,                // Moving with neither pedal pressed
+    BRANCH_COAST_CHARGE,         // Coasting on a critical battery: IEC kept on to charge
+    BRANCH_STOPPED,              // Standing still, engines winding down
+    BRANCH_STOPPED_CHARGE,       // Standing still on a critical battery: IEC idling to charge
+    BRANCH_COUNT
+} ControlBranch;
+
+// Functions timed in isolation by the benchmark
+typedef enum {
+    BENCH_FN_CONTROL, // vmu_control_model()
+    BENCH_FN_SPEED,   // speed_model()
+    BENCH_FN_EV,      // ev_engine_model()
+    BENCH_FN_IEC,     // iec_engine_model()
+    BENCH_FN_COUNT
+} BenchFunction;
+
+// Synthetic drive cycle: a pedal script played from the given battery and fuel levels
+typedef struct {
+    const char *name;
+    const char *description;
+    double battery;
+    double fuel;
+    const char *script; // PEDAL:SECONDS segments, as for bin/sim
+    int repeat;
+} DriveCycle;
+
+typedef struct {
+    const DriveCycle *cycle;
+    double simulated_s;
+    unsigned long vmu_steps;
+    unsigned long engine_steps;
+    unsigned long commands;
+    double wall_s;            // Best whole-cycle run
+    double ticks_per_second;  // VMU plus engine steps per wall second, best run
+    double function_ns[BENCH_FN_COUNT]; // Mean cost of one call, best run
+    double battery;           // End of cycle
+    double fuel;
+    double speed;
+    double distance_km;
+    unsigned long branches[BRANCH_COUNT]; // VMU steps taken down each path
+} CycleResult;
+
+extern const DriveCycle drive_cycles[];
+extern const int drive_cycle_count;
+
+const char *control_branch_name(ControlBranch branch);
+const char *bench_function_name(BenchFunction function);
+ControlBranch control_branch(const VehicleState *vehicle);
+const DriveCycle *find_drive_cycle(const char *name);
+int bench_cycle_start(Simulation *sim, const DriveCycle *cycle, PedalScript *script);
+int bench_run_cycle(const DriveCycle *cycle, int runs, CycleResult *result);
+void bench_write_json(FILE *out, const CycleResult *results, int count, int runs);
+
+#endif
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "bench.c"
+
+#define DEFAULT_RUNS 5
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--cycle=NAME] [--runs=N] [--output=FILE] [--list]\n", program);
+    fprintf(stderr, "  --cycle=NAME   Run only this drive cycle (default all, see --list)\n");
+    fprintf(stderr, "  --runs=N       Timed runs per measurement, the best one is reported (default %d)\n", DEFAULT_RUNS);
+    fprintf(stderr, "  --output=FILE  Write the JSON report to FILE instead of stdout\n");
+    fprintf(stderr, "  --list         List the drive cycles and exit\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"cycle", required_argument, NULL, 'c'},
+        {"runs", required_argument, NULL, 'r'},
+        {"output", required_argument, NULL, 'o'},
+        {"list", no_argument, NULL, 'l'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    const DriveCycle *only = NULL;
+    const char *output_path = NULL;
+    int runs = DEFAULT_RUNS;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "c:r:o:lh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'c':
+                only = find_drive_cycle(optarg);
+                if (only == NULL) {
+                    fprintf(stderr, "Unknown drive cycle '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'r':
+                runs = atoi(optarg);
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'l':
+                for (int i = 0; i < drive_cycle_count; i++) {
+                    printf("%-18s %s\n", drive_cycles[i].name, drive_cycles[i].description);
+                }
+                return 0;
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (runs < 1) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    const DriveCycle *cycles = only != NULL ? only : drive_cycles;
+    int count = only != NULL ? 1 : drive_cycle_count;
+    CycleResult results[count];
+    unsigned long covered[BRANCH_COUNT] = {0};
+
+    // The human-readable summary goes to stderr so stdout can carry the report
+    fprintf(stderr, "%-18s %9s %14s %10s %10s %10s %10s %9s %9s\n", "cycle", "sim_s", "ticks/s",
+            "control_ns", "speed_ns", "ev_ns", "iec_ns", "battery%", "fuel%");
+    for (int i = 0; i < count; i++) {
+        CycleResult *r = &results[i];
+        if (bench_run_cycle(&cycles[i], runs, r) != 0) {
+            fprintf(stderr, "[BENCH] Error running drive cycle '%s'\n", cycles[i].name);
+            exit(EXIT_FAILURE);
+        }
+        fprintf(stderr, "%-18s %9.1f %14.0f %10.2f %10.2f %10.2f %10.2f %9.2f %9.2f\n", r->cycle->name,
+                r->simulated_s, r->ticks_per_second, r->function_ns[BENCH_FN_CONTROL], r->function_ns[BENCH_FN_SPEED],
+                r->function_ns[BENCH_FN_EV], r->function_ns[BENCH_FN_IEC], r->battery, r->fuel);
+        for (int b = 0; b < BRANCH_COUNT; b++) {
+            covered[b] += r->branches[b];
+        }
+    }
+
+    FILE *out = stdout;
+    if (output_path != NULL && (out = fopen(output_path, "w")) == NULL) {
+        perror("[BENCH] Error opening output file");
+        exit(EXIT_FAILURE);
+    }
+    bench_write_json(out, results, count, runs);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    // The full suite is meant to take every path of the control law; say so when it no longer does
+    int status = 0;
+    for (int b = 0; b < BRANCH_COUNT && only == NULL; b++) {
+        if (covered[b] == 0) {
+            fprintf(stderr, "[BENCH] No drive cycle takes the %s path of the control law\n", control_branch_name(b));
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,49 @@
+// clock.h
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <time.h>
+
+#define NSEC_PER_SEC 1000000000L
+
+// Monotonic time helpers used by the module main loops
+
+// CLOCK_MONOTONIC in nanoseconds; comparable between processes on the same machine
+static inline unsigned long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * NSEC_PER_SEC + (unsigned long long)ts.tv_nsec;
+}
+
+static inline void timespec_add_ns(struct timespec *ts, long ns) {
+    ts->tv_nsec += ns % NSEC_PER_SEC;
+    ts->tv_sec += ns / NSEC_PER_SEC;
+    if (ts->tv_nsec >= NSEC_PER_SEC) {
+        ts->tv_nsec -= NSEC_PER_SEC;
+        ts->tv_sec++;
+    }
+}
+
+// Returns <0, 0 or >0 like strcmp()
+static inline int timespec_cmp(const struct timespec *a, const struct timespec *b) {
+    if (a->tv_sec != b->tv_sec) {
+        return a->tv_sec < b->tv_sec ? -1 : 1;
+    }
+    return (a->tv_nsec > b->tv_nsec) - (a->tv_nsec < b->tv_nsec);
+}
+
+// Returns to - from, clamped to zero if `to` is already in the past
+static inline struct timespec timespec_until(const struct timespec *to, const struct timespec *from) {
+    struct timespec d = { 0, 0 };
+    if (timespec_cmp(to, from) > 0) {
+        d.tv_sec = to->tv_sec - from->tv_sec;
+        d.tv_nsec = to->tv_nsec - from->tv_nsec;
+        if (d.tv_nsec < 0) {
+            d.tv_nsec += NSEC_PER_SEC;
+            d.tv_sec--;
+        }
+    }
+    return d;
+}
+
+#endif
@@ -0,0 +1,76 @@
+// Shared-memory command rings used as an alternative to the POSIX message queues
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "cmd_ring.h"
+
+// The doorbell lives in a MAP_SHARED segment, so the process-shared futex operations are used
+static long futex(unsigned int *uaddr, int op, unsigned int val, const struct timespec *timeout) {
+    return syscall(SYS_futex, uaddr, op, val, timeout, NULL, 0);
+}
+
+// Rings the doorbell and wakes the consumer blocked in cmd_ring_wait()
+void cmd_ring_wake(CommandRing *ring) {
+    __atomic_fetch_add(&ring->doorbell, 1, __ATOMIC_RELEASE);
+    futex(&ring->doorbell, FUTEX_WAKE, 1, NULL);
+}
+
+// Blocks until a command is pending or `timeout` (relative, NULL = forever) expires.
+// Returns 1 if a command is pending, 0 on timeout or signal.
+int cmd_ring_wait(CommandRing *ring, const struct timespec *timeout) {
+    unsigned int bell = __atomic_load_n(&ring->doorbell, __ATOMIC_ACQUIRE);
+
+    __atomic_store_n(&ring->sleeping, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!cmd_ring_pending(ring)) {
+        // Returns at once with EAGAIN if the producer rang the doorbell after we sampled it
+        futex(&ring->doorbell, FUTEX_WAIT, bell, timeout);
+    }
+    __atomic_store_n(&ring->sleeping, 0, __ATOMIC_RELAXED);
+
+    return cmd_ring_pending(ring) ? 1 : 0;
+}
+
+// Opens (creating it if needed) the command ring segment `name` and maps it.
+// The producer passes reset = true to discard commands left over from a previous run.
+// Returns NULL on failure with errno set.
+CommandRing *open_command_ring(const char *name, bool reset) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0666);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    if (ftruncate(fd, sizeof(CommandRing)) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    CommandRing *ring = (CommandRing *)mmap(NULL, sizeof(CommandRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring == MAP_FAILED) {
+        return NULL;
+    }
+
+    if (reset) {
+        memset(ring, 0, sizeof(CommandRing));
+    }
+    return ring;
+}
+
+// Maps an empty ring in anonymous memory, for a producer and consumer in the same process.
+// Returns NULL on failure with errno set.
+CommandRing *open_private_command_ring(void) {
+    CommandRing *ring = (CommandRing *)mmap(NULL, sizeof(CommandRing), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    return ring == MAP_FAILED ? NULL : ring; // Zero-filled: empty, nobody sleeping
+}
+
+// Unmaps a ring returned by open_command_ring() or open_private_command_ring(). The segment itself is unlinked by its creator.
+void close_command_ring(CommandRing *ring) {
+    if (ring != NULL) {
+        munmap(ring, sizeof(CommandRing));
+    }
+}
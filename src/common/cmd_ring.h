@@ -0,0 +1,80 @@
+// cmd_ring.h
+#ifndef CMD_RING_H
+#define CMD_RING_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <time.h>
+#include "../vmu/vmu.h"
+
+#define CMD_RING_CAPACITY 16 // Number of command slots per ring (must be a power of two)
+
+/*
+Single-producer/single-consumer ring of engine commands placed in shared memory.
+The VMU is the only producer and the engine module the only consumer, so `head` and `tail`
+each have a single writer and live on separate cache lines. Delivering a command costs a
+few cache-line transfers instead of an mq_send()/mq_receive() syscall pair.
+A consumer with nothing to do can block in cmd_ring_wait(); the producer only pays for a
+futex wake-up when the consumer has announced that it is sleeping.
+*/
+typedef struct {
+    struct {
+        _Alignas(CACHE_LINE_SIZE) unsigned int head; // Next slot to fill (written by the producer)
+        unsigned int doorbell;                       // Futex word bumped by the producer to wake the consumer
+    };
+    struct {
+        _Alignas(CACHE_LINE_SIZE) unsigned int tail; // Next slot to consume (written by the consumer)
+        unsigned int sleeping;                       // Non-zero while the consumer waits on the doorbell
+    };
+    _Alignas(CACHE_LINE_SIZE) EngineCommand slots[CMD_RING_CAPACITY];
+} CommandRing;
+
+void cmd_ring_wake(CommandRing *ring);
+
+// Non-blocking push. Fails with EAGAIN when the ring is full, like mq_send() on an O_NONBLOCK queue.
+// Wakes the consumer if it is blocked in cmd_ring_wait().
+static inline int cmd_ring_push(CommandRing *ring, const EngineCommand *cmd) {
+    unsigned int head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    unsigned int tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= CMD_RING_CAPACITY) {
+        errno = EAGAIN;
+        return -1;
+    }
+    ring->slots[head & (CMD_RING_CAPACITY - 1)] = *cmd;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    // Pairs with the fence in cmd_ring_wait(): either the consumer sees the new head
+    // before sleeping, or we see its sleeping flag and ring the doorbell
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->sleeping, __ATOMIC_RELAXED)) {
+        cmd_ring_wake(ring);
+    }
+    return 0;
+}
+
+// Non-blocking pop. Fails with EAGAIN when the ring is empty, like mq_receive() on an O_NONBLOCK queue.
+static inline int cmd_ring_pop(CommandRing *ring, EngineCommand *cmd) {
+    unsigned int tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    unsigned int head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    if (tail == head) {
+        errno = EAGAIN;
+        return -1;
+    }
+    *cmd = ring->slots[tail & (CMD_RING_CAPACITY - 1)];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// True if the ring holds at least one unread command
+static inline bool cmd_ring_pending(CommandRing *ring) {
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) != __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+}
+
+int cmd_ring_wait(CommandRing *ring, const struct timespec *timeout);
+CommandRing *open_command_ring(const char *name, bool reset);
+CommandRing *open_private_command_ring(void);
+void close_command_ring(CommandRing *ring);
+
+#endif
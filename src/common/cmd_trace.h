@@ -0,0 +1,52 @@
+// cmd_trace.h
+#ifndef CMD_TRACE_H
+#define CMD_TRACE_H
+
+#include <stdbool.h>
+#include "../vmu/vmu.h"
+#include "histogram.h"
+
+// Records the VMU-decision-to-now latency of a traced command into `page`.
+// `applied` selects the applied stage instead of the received stage.
+static inline void cmd_trace_page(StatsPage *page, CommandType type, unsigned long long sent_ns, bool applied) {
+    StatId id;
+    if (page == NULL || sent_ns == 0) {
+        return;
+    }
+    switch (type) {
+        case CMD_START:
+            id = applied ? STAT_START_APPLIED : STAT_START_RECEIVED;
+            break;
+        case CMD_STOP:
+            id = applied ? STAT_STOP_APPLIED : STAT_STOP_RECEIVED;
+            break;
+        case CMD_SET_POWER:
+            id = applied ? STAT_POWER_APPLIED : STAT_POWER_RECEIVED;
+            break;
+        default:
+            return;
+    }
+    unsigned long long now = monotonic_ns();
+    stats_page_record(page, id, now > sent_ns ? now - sent_ns : 0);
+}
+
+// cmd_trace_page() on the statistics page of the process
+static inline void cmd_trace(CommandType type, unsigned long long sent_ns, bool applied) {
+    cmd_trace_page(stats_page, type, sent_ns, applied);
+}
+
+// Tracks the per-engine sequence numbers and returns how many commands were skipped
+// since the previous one (dropped by the VMU because the transport was full).
+static inline unsigned int cmd_trace_seq(unsigned int *last_seq, unsigned int seq) {
+    unsigned int lost = 0;
+    if (seq == 0) {
+        return 0; // Untraced (e.g. CMD_END sent during VMU shutdown)
+    }
+    if (*last_seq != 0 && seq > *last_seq + 1) {
+        lost = seq - *last_seq - 1;
+    }
+    *last_seq = seq; // A smaller value means the VMU restarted; resynchronize
+    return lost;
+}
+
+#endif
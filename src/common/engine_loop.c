@@ -0,0 +1,260 @@
+// Engine module main loop, shared by the EV and IEC executables and by their threads in the VMU process
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include "engine_loop.h"
+#include "cmd_trace.h"
+#include "../ev/ev_model.h"
+#include "../iec/iec_model.h"
+
+static EngineBlock ev_block(SystemState *state) {
+    return (EngineBlock){ &state->ev_seq, &state->ev_on, &state->rpm_ev, &state->temp_ev, &state->ev_mailbox };
+}
+
+static EngineBlock iec_block(SystemState *state) {
+    return (EngineBlock){ &state->iec_seq, &state->iec_on, &state->rpm_iec, &state->temp_iec, &state->iec_mailbox };
+}
+
+const EngineOps ev_engine_ops = {
+    .kind = ENGINE_EV,
+    .name = "EV",
+    .motor = "Motor Elétrico",
+    .stats_name = EV_STATS_NAME,
+    .stats_module = "ev",
+    .role = TRANSPORT_ROLE_EV,
+    .block = ev_block,
+    .apply_command = ev_apply_command,
+    .model = ev_engine_model,
+};
+
+const EngineOps iec_engine_ops = {
+    .kind = ENGINE_IEC,
+    .name = "IEC",
+    .motor = "Motor a Combustão",
+    .stats_name = IEC_STATS_NAME,
+    .stats_module = "iec",
+    .role = TRANSPORT_ROLE_IEC,
+    .block = iec_block,
+    .apply_command = iec_apply_command,
+    .model = iec_engine_model,
+};
+
+// --- Statistics trace: a page of its own, or the page of the process when the context is NULL ---
+
+static StatsPage *trace_page(void *context) {
+    return context != NULL ? (StatsPage *)context : stats_page;
+}
+
+static unsigned long long stats_trace_start(void *context) {
+    return trace_page(context) != NULL ? monotonic_ns() : 0;
+}
+
+static void stats_trace_record(void *context, StatId id, unsigned long long value_ns) {
+    stats_page_record(trace_page(context), id, value_ns);
+}
+
+static void stats_trace_command(void *context, CommandType type, unsigned long long sent_ns, bool applied) {
+    cmd_trace_page(trace_page(context), type, sent_ns, applied);
+}
+
+// Trace that records into `page`, or into the page of the process (stats_page, looked up on every
+// sample so it may be opened after the loop is set up) when `page` is NULL
+EngineTrace engine_stats_trace(StatsPage *page) {
+    return (EngineTrace){ stats_trace_start, stats_trace_record, stats_trace_command, page };
+}
+
+static unsigned long long trace_start(const EngineLoop *loop) {
+    return loop->trace.start != NULL ? loop->trace.start(loop->trace.context) : 0;
+}
+
+static void trace_record(const EngineLoop *loop, StatId id, unsigned long long value_ns) {
+    if (loop->trace.record != NULL) {
+        loop->trace.record(loop->trace.context, id, value_ns);
+    }
+}
+
+// Records the time elapsed since `start_ns`, taken by trace_start()
+static void trace_since(const EngineLoop *loop, StatId id, unsigned long long start_ns) {
+    if (start_ns != 0) {
+        trace_record(loop, id, monotonic_ns() - start_ns);
+    }
+}
+
+static void trace_command(const EngineLoop *loop, CommandType type, unsigned long long sent_ns, bool applied) {
+    if (loop->trace.command != NULL) {
+        loop->trace.command(loop->trace.context, type, sent_ns, applied);
+    }
+}
+
+// --- Loop ---
+
+// Sets up a loop over `transport` with the default period and the statistics of the process.
+// The transport is opened by the caller, before the loop runs.
+void engine_loop_init(EngineLoop *loop, const EngineOps *ops, Transport *transport,
+                      volatile sig_atomic_t *running, volatile sig_atomic_t *paused) {
+    *loop = (EngineLoop){
+        .ops = ops,
+        .transport = transport,
+        .trace = engine_stats_trace(NULL),
+        .running = running,
+        .paused = paused,
+        .period_ns = ENGINE_PERIOD_NS,
+        .tick_policy = TICK_CATCH_UP,
+    };
+}
+
+// Returns the next command: ordered events first, then (in mailbox mode) the freshest power setpoint.
+// Like a queued CMD_SET_POWER, a mailbox setpoint only announces a new level: the physics step reads
+// the level itself from the VMU block (see cmd_mailbox_post()).
+static int next_command(EngineLoop *loop, const EngineBlock *block, EngineCommand *cmd) {
+    if (transport_receive(loop->transport, cmd) != -1) {
+        return 0;
+    }
+    if (loop->power_mailbox && cmd_mailbox_take(block->mailbox, &loop->mailbox_version, &cmd->power_level, &cmd->sent_ns)) {
+        cmd->type = CMD_SET_POWER;
+        cmd->seq = 0; // Coalesced setpoints are not sequenced
+        return 0;
+    }
+    return -1;
+}
+
+// Drains the pending commands and publishes the resulting on/off state once
+void engine_receive_commands(EngineLoop *loop) {
+    const EngineOps *ops = loop->ops;
+    SystemState *state = loop->transport->state;
+    EngineBlock block = ops->block(state);
+    EngineCommand cmd;
+    bool on = *block.on; // The block is owned by this engine: work on local copies
+    int rpm = *block.rpm;
+    bool state_change = false;  // True if a START or STOP was received in this batch
+    bool end_requested = false; // True if CMD_END was received
+    CommandType state_cmd = CMD_UNKNOWN; // Last START/STOP, whose state gets published
+    unsigned long long state_sent_ns = 0;
+    int received = 0;
+
+    // Drain every pending command from the transport (non-blocking)
+    // and collapse them into the final effective state
+    while (received < MAX_COMMANDS_PER_BATCH && next_command(loop, &block, &cmd) != -1) {
+        received++;
+        loop->commands_lost += cmd_trace_seq(&loop->last_command_seq, cmd.seq);
+        trace_command(loop, cmd.type, cmd.sent_ns, false);
+        ops->apply_command(cmd.type, &on, &rpm);
+        switch (cmd.type) {
+            case CMD_START:
+            case CMD_STOP:
+                state_change = true;
+                state_cmd = cmd.type;
+                state_sent_ns = cmd.sent_ns;
+                printf("[%s] %s: %s command received.\n", ops->name, ops->motor, cmd.type == CMD_START ? "START" : "STOP");
+                break;
+            case CMD_SET_POWER:
+                // The VMU publishes the power level *before* sending this message;
+                // the next physics step uses the value from the shared state
+                if (loop->pending_power_sent_ns == 0) {
+                    loop->pending_power_sent_ns = cmd.sent_ns;
+                }
+                break;
+            case CMD_END:
+                end_requested = true;
+                printf("[%s] %s: END command received.\n", ops->name, ops->motor);
+                break;
+            default:
+                fprintf(stderr, "[%s] Comando desconhecido recebido (%d)\n", ops->name, cmd.type);
+                break;
+        }
+    }
+    loop->commands += (unsigned long)received;
+
+    // Apply the collapsed result in a single write section of the engine block
+    if (state_change) {
+        bool locked = state_write_begin(state, block.seq);
+        *block.on = on;
+        *block.rpm = rpm;
+        state_write_end(state, block.seq, locked);
+        trace_command(loop, state_cmd, state_sent_ns, true);
+    }
+
+    if (end_requested) {
+        *loop->running = 0; // Terminate the main loop
+    }
+}
+
+// One physics step on the power level the VMU commanded
+void engine_physics_step(EngineLoop *loop) {
+    SystemState *state = loop->transport->state;
+    EngineBlock block = loop->ops->block(state);
+    bool on = *block.on;
+    int rpm = *block.rpm;
+    double temp = *block.temp;
+    double ev_power_level, iec_power_level;
+
+    // The power level is a lock-free snapshot of the VMU block
+    unsigned long long start = trace_start(loop);
+    snapshot_power_levels(state, &ev_power_level, &iec_power_level);
+    trace_since(loop, STAT_SNAPSHOT, start);
+
+    loop->ops->model(on, loop->ops->kind == ENGINE_EV ? ev_power_level : iec_power_level, &rpm, &temp);
+
+    bool locked = state_write_begin(state, block.seq);
+    *block.rpm = rpm;
+    *block.temp = temp;
+    state_write_end(state, block.seq, locked);
+
+    // This step acted on the power level announced by the pending CMD_SET_POWER
+    if (loop->pending_power_sent_ns != 0) {
+        trace_command(loop, CMD_SET_POWER, loop->pending_power_sent_ns, true);
+        loop->pending_power_sent_ns = 0;
+    }
+}
+
+// Runs until *running is cleared: physics on absolute deadlines, commands handled as soon as they
+// arrive instead of waiting for the next step
+void engine_loop_run(EngineLoop *loop) {
+    struct timespec now, timeout;
+    unsigned long long start;
+
+    tick_init(&loop->physics, loop->period_ns, loop->tick_policy);
+    while (*loop->running) {
+        if (loop->paused != NULL && *loop->paused) {
+            sleep(1); // Sleep for 1 second if paused
+            tick_restart(&loop->physics);
+            continue;
+        }
+
+        start = trace_start(loop);
+        engine_receive_commands(loop);
+        trace_since(loop, STAT_RECEIVE_CMD, start);
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (tick_due(&loop->physics, &now)) {
+            start = trace_start(loop);
+            engine_physics_step(loop);
+            trace_since(loop, STAT_ENGINE, start);
+            long long late_ns = tick_advance(&loop->physics, &now);
+            if (start != 0) {
+                trace_record(loop, STAT_WAKEUP_LATENESS, (unsigned long long)late_ns);
+            }
+        }
+
+        // Sleep until the next physics step or the next command, whichever comes first
+        timeout = tick_timeout(&loop->physics, &now);
+        if (*loop->running) {
+            transport_wait(loop->transport, &timeout);
+        }
+    }
+}
+
+// Publishes the engine as off, as it is once the module stops
+void engine_loop_shutdown(EngineLoop *loop) {
+    SystemState *state = loop->transport->state;
+    EngineBlock block = loop->ops->block(state);
+    bool locked = state_write_begin(state, block.seq);
+    *block.on = false;
+    *block.rpm = 0;
+    state_write_end(state, block.seq, locked);
+}
+
+void engine_loop_report(const EngineLoop *loop) {
+    printf("[%s] %lu physics steps, %lu overruns, %lu skipped, %lu commands lost\n", loop->ops->name,
+           loop->physics.ticks, loop->physics.overruns, loop->physics.skipped, loop->commands_lost);
+}
@@ -0,0 +1,89 @@
+// engine_loop.h
+#ifndef ENGINE_LOOP_H
+#define ENGINE_LOOP_H
+
+#include <stdbool.h>
+#include <signal.h>
+#include "../vmu/vmu.h"
+#include "transport.h"
+#include "tick.h"
+#include "histogram.h"
+
+typedef enum {
+    ENGINE_EV,
+    ENGINE_IEC
+} EngineKind;
+
+// The block of SystemState an engine owns
+typedef struct {
+    seqcount_t *seq;
+    bool *on;
+    int *rpm;
+    double *temp;
+    CommandMailbox *mailbox;
+} EngineBlock;
+
+// What differs between the EV and the IEC: their block, model and names
+typedef struct {
+    EngineKind kind;
+    const char *name;         // "EV" or "IEC", prefix of the messages
+    const char *motor;        // Motor named in the command messages
+    const char *stats_name;   // Statistics segment of the module
+    const char *stats_module; // Module name stored in that page
+    TransportRole role;       // End of the transport the engine opens
+    EngineBlock (*block)(SystemState *state);
+    void (*apply_command)(CommandType type, bool *on, int *rpm);
+    void (*model)(bool on, double power_level, int *rpm, double *temp);
+} EngineOps;
+
+extern const EngineOps ev_engine_ops;
+extern const EngineOps iec_engine_ops;
+
+/*
+Tracing hooks of the loop. start() returns a timestamp, 0 when nothing is recorded; record() takes
+a measured duration or lateness, command() a traced command at its received or applied stage.
+Any hook may be NULL.
+*/
+typedef struct {
+    unsigned long long (*start)(void *context);
+    void (*record)(void *context, StatId id, unsigned long long value_ns);
+    void (*command)(void *context, CommandType type, unsigned long long sent_ns, bool applied);
+    void *context;
+} EngineTrace;
+
+/*
+Main loop of an engine module, the same whether it runs as its own executable (ev/iec main) or as a
+thread of the VMU process (engine_thread.h); only the transport, the flags and the trace differ.
+Pending commands are drained in batches of MAX_COMMANDS_PER_BATCH and collapsed into one publication
+of the engine block, power setpoints come from the mailbox in mailbox mode, physics steps run on
+absolute deadlines and the loop sleeps on its channel until the next step or command. CMD_END
+clears *running; while *paused is set the loop idles and re-anchors its schedule on resume.
+*/
+typedef struct {
+    const EngineOps *ops;
+    Transport *transport;              // Endpoint of the engine, opened before the loop runs
+    bool power_mailbox;                // Power setpoints arrive through the mailbox
+    EngineTrace trace;
+    volatile sig_atomic_t *running;    // Cleared by CMD_END or by the owner to stop the loop
+    volatile sig_atomic_t *paused;     // NULL if the loop cannot be paused
+    long period_ns;                    // Physics step period
+    TickPolicy tick_policy;
+    // Maintained by the loop
+    TickScheduler physics;
+    unsigned int mailbox_version;      // Last power setpoint version taken from the mailbox
+    unsigned int last_command_seq;     // Sequence number of the last traced command received
+    unsigned long commands;            // Commands received
+    unsigned long commands_lost;       // Commands the VMU issued but that never arrived
+    unsigned long long pending_power_sent_ns; // Issue time of the oldest setpoint no step has acted on yet
+} EngineLoop;
+
+EngineTrace engine_stats_trace(StatsPage *page);
+void engine_loop_init(EngineLoop *loop, const EngineOps *ops, Transport *transport,
+                      volatile sig_atomic_t *running, volatile sig_atomic_t *paused);
+void engine_receive_commands(EngineLoop *loop);
+void engine_physics_step(EngineLoop *loop);
+void engine_loop_run(EngineLoop *loop);
+void engine_loop_shutdown(EngineLoop *loop);
+void engine_loop_report(const EngineLoop *loop);
+
+#endif
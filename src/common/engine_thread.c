@@ -0,0 +1,96 @@
+// EV and IEC modules as threads of the VMU process, over the in-process transport
+#define _GNU_SOURCE // pthread_timedjoin_np()
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "engine_thread.h"
+#include "rt.h"
+#include "clock.h"
+
+void engine_thread_init(EngineThread *engine, EngineKind kind, long period_ns, TickPolicy tick_policy, int rt_priority, bool stats) {
+    memset(engine, 0, sizeof(*engine));
+    engine->ops = kind == ENGINE_EV ? &ev_engine_ops : &iec_engine_ops;
+    engine->period_ns = period_ns;
+    engine->tick_policy = tick_policy;
+    engine->rt_priority = rt_priority;
+    engine->stats = stats;
+    transport_init(&engine->transport, &inproc_transport, engine->ops->role, TRANSPORT_RING, engine->ops->name);
+}
+
+// Attaches the engine to the in-process transport the VMU opened and sets up its loop, which pauses
+// with `paused` (may be NULL). Returns 0 on success, -1 on error.
+int engine_thread_attach(EngineThread *engine, bool power_mailbox, volatile sig_atomic_t *paused) {
+    if (transport_open(&engine->transport) != 0) {
+        return -1;
+    }
+    engine->running = 1;
+    engine_loop_init(&engine->loop, engine->ops, &engine->transport, &engine->running, paused);
+    engine->loop.power_mailbox = power_mailbox;
+    engine->loop.period_ns = engine->period_ns;
+    engine->loop.tick_policy = engine->tick_policy;
+
+    engine->page = NULL;
+    if (engine->stats) {
+        engine->page = stats_page_create(engine->ops->stats_name, engine->ops->stats_module);
+        if (engine->page == NULL) {
+            fprintf(stderr, "[%s] Error creating statistics segment: %s\n", engine->ops->name, strerror(errno));
+        }
+    }
+    // Never the page of the process: that one is written by the VMU loop only
+    engine->loop.trace = engine->page != NULL ? engine_stats_trace(engine->page) : (EngineTrace){ 0 };
+    return 0;
+}
+
+// Releases what engine_thread_attach() set up
+static void engine_thread_detach(EngineThread *engine) {
+    transport_close(&engine->transport);
+    stats_page_destroy(engine->page, engine->ops->stats_name);
+    engine->page = NULL;
+}
+
+static void *engine_thread_main(void *arg) {
+    EngineThread *engine = (EngineThread *)arg;
+
+    if (engine->rt_priority > 0 && rt_thread_enter(engine->rt_priority) != 0) {
+        fprintf(stderr, "[%s] Error setting real-time priority: %s\n", engine->ops->name, strerror(errno));
+    }
+    engine_loop_run(&engine->loop);
+    engine_loop_shutdown(&engine->loop); // As on shutdown of the process: the engine is off
+    return NULL;
+}
+
+// Starts the thread of an attached engine. Returns 0 on success, -1 on error (the engine is detached).
+int engine_thread_launch(EngineThread *engine) {
+    int error = pthread_create(&engine->thread, NULL, engine_thread_main, engine);
+    if (error != 0) {
+        engine_thread_detach(engine);
+        errno = error;
+        return -1;
+    }
+    engine->started = true;
+    return 0;
+}
+
+// Attaches the engine and starts its thread. Returns 0 on success, -1 on error.
+int engine_thread_start(EngineThread *engine, bool power_mailbox, volatile sig_atomic_t *paused) {
+    if (engine_thread_attach(engine, power_mailbox, paused) != 0) {
+        return -1;
+    }
+    return engine_thread_launch(engine);
+}
+
+// Waits for the thread started by engine_thread_start() to end and detaches the engine. The VMU sends
+// CMD_END first and the thread gets one physics step to handle it, as the process would; then clearing
+// the running flag ends it at its next wakeup, in case that command was dropped because the channel
+// was full or the loop is paused.
+void engine_thread_stop(EngineThread *engine) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    timespec_add_ns(&deadline, engine->period_ns);
+    if (pthread_timedjoin_np(engine->thread, NULL, &deadline) != 0) {
+        engine->running = 0;
+        pthread_join(engine->thread, NULL);
+    }
+    engine_thread_detach(engine);
+    engine->started = false;
+}
@@ -0,0 +1,41 @@
+// engine_thread.h
+#ifndef ENGINE_THREAD_H
+#define ENGINE_THREAD_H
+
+#include <stdbool.h>
+#include <signal.h>
+#include <pthread.h>
+#include "../vmu/vmu.h"
+#include "transport.h"
+#include "tick.h"
+#include "histogram.h"
+#include "engine_loop.h"
+
+/*
+EV or IEC module running as a thread of the VMU process (--runtime=threads) instead of as its own
+executable, on its end of the in-process transport. The thread runs the loop of the engine
+executables (engine_loop.h): the same commands, messages, pause and statistics. The statistics page
+of the process belongs to the VMU loop, so with statistics on each thread writes a page of its own,
+under the name the engine process would use.
+*/
+typedef struct {
+    const EngineOps *ops;
+    long period_ns;             // Physics step period
+    TickPolicy tick_policy;
+    int rt_priority;            // SCHED_FIFO priority of the thread, 0 for the normal scheduler
+    bool stats;                 // Record latencies into a page of the engine's own
+    Transport transport;        // Endpoint of the engine, attached to the VMU's in-process transport
+    EngineLoop loop;            // Set up by engine_thread_attach()
+    StatsPage *page;            // Statistics page of the thread, NULL when not recorded
+    volatile sig_atomic_t running;
+    bool started;               // The thread is running: engine_thread_stop() must be called
+    pthread_t thread;
+} EngineThread;
+
+void engine_thread_init(EngineThread *engine, EngineKind kind, long period_ns, TickPolicy tick_policy, int rt_priority, bool stats);
+int engine_thread_attach(EngineThread *engine, bool power_mailbox, volatile sig_atomic_t *paused);
+int engine_thread_launch(EngineThread *engine);
+int engine_thread_start(EngineThread *engine, bool power_mailbox, volatile sig_atomic_t *paused);
+void engine_thread_stop(EngineThread *engine);
+
+#endif
@@ -0,0 +1,150 @@
+// Latency histograms and the per-process statistics page
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "histogram.h"
+
+StatsPage *stats_page = NULL;
+
+// Index of the bucket holding `value_ns`
+unsigned int hist_bucket(unsigned long long value_ns) {
+    if (value_ns >= (1ULL << HIST_MAX_BITS)) {
+        return HIST_BUCKETS - 1;
+    }
+    if (value_ns < HIST_SUB_COUNT) {
+        return (unsigned int)value_ns;
+    }
+    unsigned int msb = 63 - __builtin_clzll(value_ns);
+    unsigned int shift = msb - HIST_SUB_BITS;
+    unsigned int sub = (unsigned int)(value_ns >> shift) & (HIST_SUB_COUNT - 1);
+    return (shift + 1) * HIST_SUB_COUNT + sub;
+}
+
+// Largest value that falls into `bucket`
+unsigned long long hist_bucket_upper(unsigned int bucket) {
+    unsigned int group = bucket / HIST_SUB_COUNT;
+    unsigned int sub = bucket % HIST_SUB_COUNT;
+    if (group == 0) {
+        return sub;
+    }
+    unsigned int shift = group - 1;
+    return (((unsigned long long)(HIST_SUB_COUNT + sub)) << shift) + (1ULL << shift) - 1;
+}
+
+void hist_add(LatencyHistogram *hist, unsigned long long value_ns) {
+    hist->buckets[hist_bucket(value_ns)]++;
+    hist->count++;
+    hist->sum_ns += value_ns;
+    if (value_ns > hist->max_ns) {
+        hist->max_ns = value_ns;
+    }
+}
+
+// Upper bound of the bucket containing the given percentile (0-100), capped at the exact maximum
+unsigned long long hist_percentile(const LatencyHistogram *hist, double percentile) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    unsigned long long rank = (unsigned long long)(percentile / 100.0 * (double)hist->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    unsigned long long seen = 0;
+    for (unsigned int i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            unsigned long long upper = hist_bucket_upper(i);
+            return upper < hist->max_ns ? upper : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
+
+// Creates and maps the statistics segment `name` of `module`. Returns NULL on failure.
+StatsPage *stats_page_create(const char *name, const char *module) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd == -1) {
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(StatsPage)) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    StatsPage *page = (StatsPage *)mmap(NULL, sizeof(StatsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        return NULL;
+    }
+
+    memset(page, 0, sizeof(StatsPage));
+    strncpy(page->module, module, STATS_MODULE_NAME_LEN - 1);
+    return page;
+}
+
+// Unmaps a page created by stats_page_create() and removes its segment
+void stats_page_destroy(StatsPage *page, const char *name) {
+    if (page != NULL) {
+        munmap(page, sizeof(StatsPage));
+        shm_unlink(name);
+    }
+}
+
+// Adds a sample to `page`; nothing is recorded when it is NULL
+void stats_page_record(StatsPage *page, StatId id, unsigned long long value_ns) {
+    if (page == NULL) {
+        return;
+    }
+    seqlock_write_begin(&page->seq);
+    hist_add(&page->hist[id], value_ns);
+    seqlock_write_end(&page->seq);
+}
+
+// Creates and maps the statistics segment `name` for this process and makes it the active page.
+// Returns NULL on failure, in which case statistics stay disabled.
+StatsPage *stats_open(const char *name, const char *module) {
+    StatsPage *page = stats_page_create(name, module);
+    if (page != NULL) {
+        stats_page = page;
+    }
+    return page;
+}
+
+// Disables statistics and removes the segment
+void stats_close(const char *name) {
+    stats_page_destroy(stats_page, name);
+    stats_page = NULL;
+}
+
+void stats_record(StatId id, unsigned long long value_ns) {
+    stats_page_record(stats_page, id, value_ns);
+}
+
+void stats_record_since(StatId id, unsigned long long start_ns) {
+    if (stats_page != NULL) {
+        stats_record(id, monotonic_ns() - start_ns);
+    }
+}
+
+const char *stats_name(StatId id) {
+    static const char *names[STAT_COUNT] = {
+        "wakeup_lateness",
+        "control_engines",
+        "calculate_speed",
+        "display_status",
+        "receive_cmd",
+        "engine",
+        "snapshot",
+        "start_received",
+        "start_applied",
+        "stop_received",
+        "stop_applied",
+        "power_received",
+        "power_applied",
+        "publish",
+    };
+    return (id >= 0 && id < STAT_COUNT) ? names[id] : "unknown";
+}
@@ -0,0 +1,75 @@
+// histogram.h
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdbool.h>
+#include "seqlock.h"
+#include "clock.h"
+
+#define HIST_SUB_BITS 4                          // Linear sub-buckets per power of two (2^4 = 16, ~6% resolution)
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 40                         // Values are clamped below 2^40 ns (~18 minutes)
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+
+#define STATS_MODULE_NAME_LEN 8
+
+// Log-linear latency histogram in nanoseconds: exact below 16 ns, then 16 buckets per power of two
+typedef struct {
+    unsigned long long count;
+    unsigned long long sum_ns;
+    unsigned long long max_ns;
+    unsigned long long buckets[HIST_BUCKETS];
+} LatencyHistogram;
+
+// Quantities recorded by the module main loops (each module uses a subset)
+typedef enum {
+    STAT_WAKEUP_LATENESS, // Time between a tick deadline and the tick actually starting
+    STAT_CONTROL_ENGINES, // vmu_control_engines()
+    STAT_CALCULATE_SPEED, // calculate_speed()
+    STAT_DISPLAY_STATUS,  // Drawing one snapshot on the VMU status screen (display observer thread)
+    STAT_RECEIVE_CMD,     // receive_cmd()
+    STAT_ENGINE,          // engine()
+    STAT_SNAPSHOT,        // Consistent snapshot of another module's block (seqlock read incl. retries)
+    STAT_START_RECEIVED,  // CMD_START: VMU decision to dequeue by the engine
+    STAT_START_APPLIED,   // CMD_START: VMU decision to engine on/off state published
+    STAT_STOP_RECEIVED,   // CMD_STOP: VMU decision to dequeue by the engine
+    STAT_STOP_APPLIED,    // CMD_STOP: VMU decision to engine on/off state published
+    STAT_POWER_RECEIVED,  // CMD_SET_POWER: VMU decision to dequeue by the engine
+    STAT_POWER_APPLIED,   // CMD_SET_POWER: VMU decision to the first engine() step using the new level
+    STAT_PUBLISH,         // Building and publishing the snapshot of a VMU tick to the observers
+    STAT_COUNT
+} StatId;
+
+/*
+Per-module statistics page. Each module owns one page in its own shared-memory segment and is
+its only writer (the page of the process, or a page of its own for an engine running as a thread); readers map it read-only and copy it under the seqlock, so reading never
+blocks or slows down the simulation.
+*/
+typedef struct {
+    seqcount_t seq;
+    char module[STATS_MODULE_NAME_LEN];
+    LatencyHistogram hist[STAT_COUNT];
+} StatsPage;
+
+extern StatsPage *stats_page; // Page of this process, NULL when statistics are disabled
+
+// Timestamp to pass to stats_record_since(); free when statistics are disabled
+static inline unsigned long long stats_start(void) {
+    return stats_page != NULL ? monotonic_ns() : 0;
+}
+
+unsigned int hist_bucket(unsigned long long value_ns);
+unsigned long long hist_bucket_upper(unsigned int bucket);
+void hist_add(LatencyHistogram *hist, unsigned long long value_ns);
+unsigned long long hist_percentile(const LatencyHistogram *hist, double percentile);
+
+StatsPage *stats_page_create(const char *name, const char *module);
+void stats_page_destroy(StatsPage *page, const char *name);
+void stats_page_record(StatsPage *page, StatId id, unsigned long long value_ns);
+StatsPage *stats_open(const char *name, const char *module);
+void stats_close(const char *name);
+void stats_record(StatId id, unsigned long long value_ns);
+void stats_record_since(StatId id, unsigned long long start_ns);
+const char *stats_name(StatId id);
+
+#endif
@@ -0,0 +1,121 @@
+// Snapshot stream from the control loop to observer threads (display, recorder, exporters)
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "observer.h"
+#include "clock.h"
+#include "rt.h"
+
+void snapshot_stream_init(SnapshotStream *stream) {
+    memset(stream, 0, sizeof(*stream));
+}
+
+// Publishes the snapshot of one tick. Single writer: only the control loop calls it.
+void snapshot_publish(SnapshotStream *stream, const TelemetryRecord *record) {
+    uint64_t head = stream->head;
+    SnapshotSlot *slot = &stream->slots[head % SNAPSHOT_RING_SIZE];
+
+    seqlock_write_begin(&slot->seq);
+    slot->index = head;
+    slot->record = *record;
+    seqlock_write_end(&slot->seq);
+    __atomic_store_n(&stream->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Copies snapshot `index` into `record`. Returns false if it has already been overwritten.
+bool snapshot_read(const SnapshotStream *stream, uint64_t index, TelemetryRecord *record) {
+    const SnapshotSlot *slot = &stream->slots[index % SNAPSHOT_RING_SIZE];
+    seqcount_t seq;
+    uint64_t slot_index;
+
+    do {
+        seq = seqlock_read_begin(&slot->seq);
+        slot_index = slot->index;
+        *record = slot->record;
+    } while (seqlock_read_retry(&slot->seq, seq));
+    return slot_index == index;
+}
+
+// Delivers the snapshots published since the last poll. Returns the number delivered.
+int observer_poll(Observer *observer) {
+    const SnapshotStream *stream = observer->stream;
+    uint64_t head = __atomic_load_n(&stream->head, __ATOMIC_ACQUIRE);
+    TelemetryRecord snapshot;
+    int delivered = 0;
+
+    if (head == observer->next) {
+        return 0;
+    }
+    if (observer->latest_only) {
+        observer->next = head - 1;
+    } else if (head - observer->next > SNAPSHOT_RING_SIZE) {
+        observer->dropped += (unsigned long)(head - observer->next - SNAPSHOT_RING_SIZE);
+        observer->next = head - SNAPSHOT_RING_SIZE;
+    }
+    for (; observer->next < head; observer->next++) {
+        if (!snapshot_read(stream, observer->next, &snapshot)) {
+            observer->dropped++; // Overwritten while we were catching up
+            continue;
+        }
+        observer->on_snapshot(observer, &snapshot);
+        observer->delivered++;
+        delivered++;
+    }
+    return delivered;
+}
+
+static void *observer_thread(void *arg) {
+    Observer *observer = (Observer *)arg;
+    struct timespec next;
+
+    // Below the control loop: the thread only gets the CPU the loop leaves over
+    if (observer->rt_priority > 0 && rt_thread_enter(observer->rt_priority) != 0) {
+        fprintf(stderr, "[%s] Error setting real-time priority, running at nice %d: %s\n", observer->name, observer->nice, strerror(errno));
+        observer->rt_priority = 0;
+    }
+    if (observer->rt_priority == 0) {
+        setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), observer->nice);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!observer->stop) {
+        observer_poll(observer);
+        timespec_add_ns(&next, observer->poll_interval_ns);
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (timespec_cmp(&next, &now) < 0) {
+            next = now; // A slow callback delays the next poll instead of causing a burst of them
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR && !observer->stop) {
+        }
+    }
+    observer_poll(observer); // Whatever was published before the stop
+    return NULL;
+}
+
+// Starts delivering the snapshots published from now on. Returns 0 on success, -1 on error.
+int observer_start(Observer *observer, SnapshotStream *stream) {
+    observer->stream = stream;
+    observer->next = __atomic_load_n(&stream->head, __ATOMIC_ACQUIRE);
+    observer->delivered = 0;
+    observer->dropped = 0;
+    observer->stop = false;
+    errno = pthread_create(&observer->thread, NULL, observer_thread, observer);
+    observer->started = errno == 0;
+    return observer->started ? 0 : -1;
+}
+
+// Stops the thread after a last poll, so every snapshot published before the call is delivered.
+// Nothing to do for an observer whose thread was never started.
+void observer_stop(Observer *observer) {
+    if (!observer->started) {
+        return;
+    }
+    observer->stop = true;
+    pthread_join(observer->thread, NULL);
+    observer->started = false;
+}
@@ -0,0 +1,66 @@
+// observer.h
+#ifndef OBSERVER_H
+#define OBSERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "seqlock.h"
+#include "telemetry.h"
+
+#define SNAPSHOT_RING_SIZE 1024 // Snapshots kept for observers that consume every tick (power of two)
+#define OBSERVER_NICE 10        // Default niceness of observer threads, below the control loop
+
+// One published tick. `index` tells a reader whether the slot has been reused since it was published.
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) seqcount_t seq;
+    uint64_t index;
+    TelemetryRecord record;
+} SnapshotSlot;
+
+/*
+Stream of per-tick snapshots from the control loop to any number of observer threads in the same
+process. The control loop publishes each tick into the next slot of a ring under the slot's
+sequence counter: a copy and a few stores, with no lock, no system call and no wait for readers.
+Observers poll at their own pace and never slow the publisher down; one that falls more than
+SNAPSHOT_RING_SIZE snapshots behind loses the oldest ones and counts them as dropped.
+*/
+typedef struct {
+    SnapshotSlot slots[SNAPSHOT_RING_SIZE];
+    _Alignas(CACHE_LINE_SIZE) uint64_t head; // Snapshots published so far
+} SnapshotStream;
+
+typedef struct Observer Observer;
+typedef void (*ObserverCallback)(Observer *observer, const TelemetryRecord *snapshot);
+
+/*
+Consumer of a snapshot stream on its own thread. Every `poll_interval_ns` the thread hands the
+snapshots published since its last poll to `on_snapshot`: all of them in order, or only the newest
+one when `latest_only` is set (a display has no use for frames it cannot show).
+*/
+struct Observer {
+    const char *name;
+    ObserverCallback on_snapshot;
+    void *context;
+    bool latest_only;
+    long poll_interval_ns;
+    int nice;        // Niceness of the thread
+    int rt_priority; // SCHED_FIFO priority of the thread instead, 0 to run it at `nice`
+    // Maintained by the observer thread
+    SnapshotStream *stream;
+    uint64_t next;           // Index of the next snapshot to deliver
+    unsigned long delivered; // Snapshots handed to on_snapshot
+    unsigned long dropped;   // Snapshots overwritten before they were read (not counting skipped ones with latest_only)
+    volatile bool stop;
+    bool started; // The thread is running: observer_stop() must be called
+    pthread_t thread;
+};
+
+void snapshot_stream_init(SnapshotStream *stream);
+void snapshot_publish(SnapshotStream *stream, const TelemetryRecord *record);
+bool snapshot_read(const SnapshotStream *stream, uint64_t index, TelemetryRecord *record);
+int observer_poll(Observer *observer);
+int observer_start(Observer *observer, SnapshotStream *stream);
+void observer_stop(Observer *observer);
+
+#endif
@@ -0,0 +1,190 @@
+// Command line parsing shared by the module executables
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "options.h"
+#include "telemetry.h"
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--transport=mq|ring] [--mailbox] [--period=MS] [--tick-policy=catch-up|skip] [--no-stats] [--pedal-trace=FILE] [--telemetry=FILE] [--telemetry-records=N] [--display-rate=HZ] [--rt] [--rt-priority=LOOP[,INPUT[,OBSERVER]]] [--cpus=LIST] [--state-lock=sem|mutex] [--runtime=processes|threads] [--engine-period=MS]\n", program);
+    fprintf(stderr, "  --transport=mq    POSIX message queues (default)\n");
+    fprintf(stderr, "  --transport=ring  Lock-free command rings in shared memory\n");
+    fprintf(stderr, "  --mailbox         Send power setpoints through a latest-value mailbox\n");
+    fprintf(stderr, "  --period=MS       Main loop period in milliseconds (default: 200 for the VMU, 70 for the engines)\n");
+    fprintf(stderr, "  --tick-policy=P   Late ticks: catch-up (run them back-to-back, default) or skip\n");
+    fprintf(stderr, "  --no-stats        Do not publish latency histograms (see bin/stats)\n");
+    fprintf(stderr, "  --pedal-trace=F   VMU only: play the timestamped pedal events in F instead of reading the terminal, then exit\n");
+    fprintf(stderr, "  --telemetry=F     VMU only: record every control tick in the ring file F (see bin/telemetry)\n");
+    fprintf(stderr, "  --telemetry-records=N  Ticks kept in the telemetry ring (default %d)\n", TELEMETRY_DEFAULT_RECORDS);
+    fprintf(stderr, "  --display-rate=HZ VMU only: refresh the status screen at most HZ times per second (default %.0f, 0 = every tick)\n", DISPLAY_RATE_HZ);
+    fprintf(stderr, "  --rt              Real-time profile: lock and prefault memory, run under SCHED_FIFO\n");
+    fprintf(stderr, "  --rt-priority=L[,I[,O]]  SCHED_FIFO priorities of the main loop, VMU input thread and VMU observers\n");
+    fprintf(stderr, "                    (default %d,%d,%d, 0 = normal scheduling), implies --rt\n", RT_LOOP_PRIORITY, RT_INPUT_PRIORITY, RT_OBSERVER_PRIORITY);
+    fprintf(stderr, "  --cpus=LIST       Pin the process to CPUs, e.g. 2 or 0,2-3\n");
+    fprintf(stderr, "  --state-lock=L    VMU only: sem (lock-free writers, default) or mutex (robust priority-inheriting\n");
+    fprintf(stderr, "                    mutex around every write section, with recovery from dead writers)\n");
+    fprintf(stderr, "  --runtime=R       VMU only: processes (EV and IEC are separate executables, default) or threads\n");
+    fprintf(stderr, "                    (EV and IEC run as threads of the VMU on in-memory command rings)\n");
+    fprintf(stderr, "  --engine-period=MS  With --runtime=threads: physics step period of the engine threads (default 70)\n");
+}
+
+// Parses argv into `options`, starting from the defaults. Returns 1 on success, 0 on invalid usage.
+int parse_runtime_options(int argc, char *argv[], RuntimeOptions *options) {
+    static const struct option long_options[] = {
+        {"transport", required_argument, NULL, 't'},
+        {"mailbox", no_argument, NULL, 'm'},
+        {"period", required_argument, NULL, 'p'},
+        {"tick-policy", required_argument, NULL, 'P'},
+        {"no-stats", no_argument, NULL, 'S'},
+        {"pedal-trace", required_argument, NULL, 'T'},
+        {"telemetry", required_argument, NULL, 'R'},
+        {"telemetry-records", required_argument, NULL, 'N'},
+        {"display-rate", required_argument, NULL, 'D'},
+        {"rt", no_argument, NULL, 'r'},
+        {"rt-priority", required_argument, NULL, 'F'},
+        {"cpus", required_argument, NULL, 'c'},
+        {"state-lock", required_argument, NULL, 'L'},
+        {"runtime", required_argument, NULL, 'M'},
+        {"engine-period", required_argument, NULL, 'E'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+
+    options->transport = TRANSPORT_MQ;
+    options->power_mailbox = false;
+    options->period_ns = 0;
+    options->tick_policy = TICK_CATCH_UP;
+    options->stats = true;
+    options->pedal_trace = NULL;
+    options->telemetry = NULL;
+    options->telemetry_records = TELEMETRY_DEFAULT_RECORDS;
+    options->display_rate_hz = DISPLAY_RATE_HZ;
+    options->state_lock = STATE_LOCK_SEM;
+    options->runtime = RUNTIME_PROCESSES;
+    options->engine_period_ns = 0;
+    rt_profile_default(&options->rt);
+
+    optind = 1; // Allow repeated parsing (unit tests)
+    while ((opt = getopt_long(argc, argv, "t:mp:P:ST:R:N:D:rF:c:L:M:E:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 't':
+                if (strcmp(optarg, "mq") == 0) {
+                    options->transport = TRANSPORT_MQ;
+                } else if (strcmp(optarg, "ring") == 0) {
+                    options->transport = TRANSPORT_RING;
+                } else {
+                    fprintf(stderr, "Unknown transport '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'm':
+                options->power_mailbox = true;
+                break;
+            case 'p':
+            case 'E': {
+                char *end;
+                double period_ms = strtod(optarg, &end);
+                if (*end != '\0' || !(period_ms > 0.0 && period_ms <= 10000.0)) {
+                    fprintf(stderr, "Invalid period '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    return 0;
+                }
+                if (opt == 'p') {
+                    options->period_ns = (long)(period_ms * 1000000.0);
+                } else {
+                    options->engine_period_ns = (long)(period_ms * 1000000.0);
+                }
+                break;
+            }
+            case 'S':
+                options->stats = false;
+                break;
+            case 'T':
+                options->pedal_trace = optarg;
+                break;
+            case 'R':
+                options->telemetry = optarg;
+                break;
+            case 'N': {
+                char *end;
+                unsigned long records = strtoul(optarg, &end, 10);
+                if (*end != '\0' || records == 0 || optarg[0] == '-') {
+                    fprintf(stderr, "Invalid telemetry record count '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    return 0;
+                }
+                options->telemetry_records = records;
+                break;
+            }
+            case 'D': {
+                char *end;
+                double rate_hz = strtod(optarg, &end);
+                if (*end != '\0' || !(rate_hz >= 0.0 && rate_hz <= 1000.0)) {
+                    fprintf(stderr, "Invalid display rate '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    return 0;
+                }
+                options->display_rate_hz = rate_hz;
+                break;
+            }
+            case 'r':
+                options->rt.enabled = true;
+                break;
+            case 'F':
+                if (!rt_parse_priorities(optarg, &options->rt)) {
+                    fprintf(stderr, "Invalid real-time priorities '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    return 0;
+                }
+                options->rt.enabled = true;
+                break;
+            case 'c':
+                if (!rt_parse_cpus(optarg, &options->rt.cpu_mask)) {
+                    fprintf(stderr, "Invalid CPU list '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'L':
+                if (strcmp(optarg, "sem") == 0) {
+                    options->state_lock = STATE_LOCK_SEM;
+                } else if (strcmp(optarg, "mutex") == 0) {
+                    options->state_lock = STATE_LOCK_MUTEX;
+                } else {
+                    fprintf(stderr, "Unknown state lock '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'M':
+                if (strcmp(optarg, "processes") == 0) {
+                    options->runtime = RUNTIME_PROCESSES;
+                } else if (strcmp(optarg, "threads") == 0) {
+                    options->runtime = RUNTIME_THREADS;
+                } else {
+                    fprintf(stderr, "Unknown runtime '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'P':
+                if (strcmp(optarg, "catch-up") == 0) {
+                    options->tick_policy = TICK_CATCH_UP;
+                } else if (strcmp(optarg, "skip") == 0) {
+                    options->tick_policy = TICK_SKIP;
+                } else {
+                    fprintf(stderr, "Unknown tick policy '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    return 0;
+                }
+                break;
+            default:
+                print_usage(argv[0]);
+                return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,29 @@
+// options.h
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "../vmu/vmu.h"
+#include "tick.h"
+#include "rt.h"
+
+// Runtime options shared by the VMU, EV and IEC executables.
+// All three processes must be started with the same transport.
+typedef struct {
+    CommandTransport transport; // How EngineCommand messages are delivered
+    bool power_mailbox;         // Coalesce CMD_SET_POWER in a latest-value mailbox
+    long period_ns;             // Main loop period, 0 for the module default
+    TickPolicy tick_policy;     // Handling of late ticks
+    bool stats;                 // Publish latency histograms in a statistics segment
+    const char *pedal_trace;    // VMU pedal input read from this trace file instead of the terminal, or NULL
+    const char *telemetry;      // VMU telemetry ring file, or NULL for no recording
+    unsigned long telemetry_records; // Capacity of the telemetry ring in ticks
+    double display_rate_hz;     // VMU status screen refresh cap, 0 for no limit
+    StateLockMode state_lock;   // VMU only: lock of the shared segment, which the engines follow
+    ModuleRuntime runtime;      // VMU only: engines as separate processes or as threads of the VMU
+    long engine_period_ns;      // VMU only: physics step period of the engine threads, 0 for the default
+    RtProfile rt;               // Real-time execution profile (memory locking, pinning, SCHED_FIFO)
+} RuntimeOptions;
+
+int parse_runtime_options(int argc, char *argv[], RuntimeOptions *options);
+
+#endif
@@ -0,0 +1,149 @@
+// Scripted pedal input read from a trace file
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pedal_trace.h"
+
+// Parses one line into `event`. Returns 1 for an event, 0 for a blank or comment line, -1 if invalid.
+static int parse_line(const char *line, PedalEvent *event) {
+    double values[3];
+    int count = 0;
+    const char *p = line;
+
+    while (count < 3) {
+        while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+        if (*p == '\0' || *p == '#') break;
+        char *end;
+        values[count] = strtod(p, &end);
+        if (end == p) return -1;
+        count++;
+        p = end;
+    }
+    while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+    if (*p != '\0' && *p != '#') return -1; // Trailing garbage or a fourth column
+
+    if (count == 0) return 0;
+    if (count == 1 || !(values[0] >= 0.0)) return -1;
+    // Also rejects inf: the time must fit in nanoseconds (the comparison is false for NaN)
+    if (!(values[0] < (double)ULLONG_MAX / 1e9)) return -1;
+    event->time_ns = (unsigned long long)(values[0] * 1e9 + 0.5);
+
+    bool accelerator, brake;
+    if (count == 2) {
+        if (values[1] != 0.0 && values[1] != 1.0 && values[1] != 2.0) return -1;
+        accelerator = values[1] == 1.0;
+        brake = values[1] == 2.0;
+    } else {
+        if (!(values[1] >= 0.0 && values[1] <= 1.0 && values[2] >= 0.0 && values[2] <= 1.0)) return -1;
+        accelerator = values[1] > PEDAL_TRACE_PRESSED;
+        brake = values[2] > PEDAL_TRACE_PRESSED;
+    }
+    event->brake = brake;
+    event->accelerator = accelerator && !brake;
+    return 1;
+}
+
+// Parses `length` bytes of trace text (not necessarily NUL terminated). Returns 0 on success, -1 on
+// an invalid or empty trace, after printing the offending line.
+int pedal_trace_parse(const char *text, size_t length, PedalTrace *trace) {
+    memset(trace, 0, sizeof(*trace));
+
+    // One event per line at most
+    size_t lines = 1;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '\n') lines++;
+    }
+    trace->events = malloc(lines * sizeof(PedalEvent));
+    if (trace->events == NULL) {
+        perror("Error allocating pedal trace");
+        return -1;
+    }
+
+    size_t start = 0;
+    int line_number = 0;
+    while (start < length) {
+        size_t end = start;
+        while (end < length && text[end] != '\n') end++;
+        line_number++;
+
+        char line[PEDAL_TRACE_MAX_LINE];
+        size_t line_length = end - start;
+        PedalEvent event;
+        int parsed = -1;
+        if (line_length < sizeof(line)) {
+            memcpy(line, text + start, line_length);
+            line[line_length] = '\0';
+            parsed = parse_line(line, &event);
+        }
+        if (parsed < 0 || (parsed > 0 && trace->count > 0 && event.time_ns < trace->events[trace->count - 1].time_ns)) {
+            fprintf(stderr, "Invalid pedal trace line %d: %.*s\n", line_number, (int)(line_length < 80 ? line_length : 80), text + start);
+            pedal_trace_free(trace);
+            return -1;
+        }
+        if (parsed > 0) {
+            trace->events[trace->count++] = event;
+        }
+        start = end + 1;
+    }
+
+    if (trace->count == 0) {
+        fprintf(stderr, "Pedal trace has no events\n");
+        pedal_trace_free(trace);
+        return -1;
+    }
+    return 0;
+}
+
+// Maps the trace file and parses it once, up front. Returns 0 on success, -1 on error.
+int pedal_trace_load(const char *path, PedalTrace *trace) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror("Error opening pedal trace");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror("Error reading pedal trace");
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return pedal_trace_parse("", 0, trace);
+    }
+    const char *text = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        perror("Error mapping pedal trace");
+        return -1;
+    }
+    int result = pedal_trace_parse(text, (size_t)st.st_size, trace);
+    munmap((void *)text, (size_t)st.st_size);
+    return result;
+}
+
+void pedal_trace_free(PedalTrace *trace) {
+    free(trace->events);
+    memset(trace, 0, sizeof(*trace));
+}
+
+// Delivers every event due at `time_ns`. Returns the latest of them, which holds the pedal state
+// to apply, or NULL if no new event is due.
+const PedalEvent *pedal_trace_due(PedalTrace *trace, unsigned long long time_ns) {
+    const PedalEvent *due = NULL;
+    while (trace->next < trace->count && trace->events[trace->next].time_ns <= time_ns) {
+        due = &trace->events[trace->next++];
+    }
+    return due;
+}
+
+// True once the last event has been delivered
+bool pedal_trace_done(const PedalTrace *trace) {
+    return trace->next >= trace->count;
+}
+
@@ -0,0 +1,37 @@
+// pedal_trace.h
+#ifndef PEDAL_TRACE_H
+#define PEDAL_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PEDAL_TRACE_PRESSED 0.1   // Analog pedal position above which a pedal counts as pressed
+#define PEDAL_TRACE_MAX_LINE 256  // Longest line accepted in a trace file
+
+// Pedal state from `time_ns` (since the start of the run) until the next event
+typedef struct {
+    unsigned long long time_ns;
+    bool accelerator;
+    bool brake;
+} PedalEvent;
+
+/*
+Timestamped pedal input replacing the VMU terminal. One event per line, '#' starts a comment:
+    SECONDS CODE                   CODE as typed in the terminal: 0 release, 1 accelerate, 2 brake
+    SECONDS ACCELERATOR BRAKE      analog positions 0..1, pressed above PEDAL_TRACE_PRESSED
+Times must not decrease and the brake wins when both pedals are pressed. A run ends once the last
+event has been applied.
+*/
+typedef struct {
+    PedalEvent *events;
+    int count;
+    int next; // First event not yet delivered
+} PedalTrace;
+
+int pedal_trace_parse(const char *text, size_t length, PedalTrace *trace);
+int pedal_trace_load(const char *path, PedalTrace *trace);
+void pedal_trace_free(PedalTrace *trace);
+const PedalEvent *pedal_trace_due(PedalTrace *trace, unsigned long long time_ns);
+bool pedal_trace_done(const PedalTrace *trace);
+
+#endif
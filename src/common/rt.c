@@ -0,0 +1,148 @@
+// Real-time execution profile: CPU pinning, memory locking, prefaulting and SCHED_FIFO priorities
+#define _GNU_SOURCE // CPU_SET() and sched_setaffinity()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "rt.h"
+
+void rt_profile_default(RtProfile *profile) {
+    profile->enabled = false;
+    profile->cpu_mask = 0;
+    profile->loop_priority = RT_LOOP_PRIORITY;
+    profile->input_priority = RT_INPUT_PRIORITY;
+    profile->observer_priority = RT_OBSERVER_PRIORITY;
+}
+
+// Parses a CPU list such as "2" or "0,2-3". Returns 1 and sets `cpu_mask` if valid, 0 otherwise.
+int rt_parse_cpus(const char *text, uint64_t *cpu_mask) {
+    uint64_t mask = 0;
+    const char *p = text;
+
+    do {
+        char *end;
+        if (*p < '0' || *p > '9') return 0;
+        unsigned long first = strtoul(p, &end, 10), last = first;
+        if (*end == '-') {
+            p = end + 1;
+            if (*p < '0' || *p > '9') return 0;
+            last = strtoul(p, &end, 10);
+        }
+        if (first > last || last >= RT_MAX_CPUS) return 0;
+        for (unsigned long cpu = first; cpu <= last; cpu++) {
+            mask |= 1ULL << cpu;
+        }
+        p = end;
+    } while (*p++ == ',');
+
+    if (p[-1] != '\0') return 0;
+    *cpu_mask = mask;
+    return 1;
+}
+
+// Parses "LOOP[,INPUT[,OBSERVER]]" SCHED_FIFO priorities (1-99, 0 for the normal scheduler) into
+// `profile`; omitted ones keep their value. Returns 1 if valid, 0 otherwise.
+int rt_parse_priorities(const char *text, RtProfile *profile) {
+    int *priorities[] = { &profile->loop_priority, &profile->input_priority, &profile->observer_priority };
+    int values[3];
+    int count = 0;
+    const char *p = text;
+
+    do {
+        char *end;
+        if (count == 3 || *p < '0' || *p > '9') return 0;
+        long value = strtol(p, &end, 10);
+        if (value > 99) return 0;
+        values[count++] = (int)value;
+        p = end;
+    } while (*p++ == ',');
+
+    if (p[-1] != '\0') return 0;
+    for (int i = 0; i < count; i++) {
+        *priorities[i] = values[i];
+    }
+    return 1;
+}
+
+// Applies the process-wide part of the profile: pinning, and with the profile enabled memory locking
+// and a prefaulted stack. Call before creating threads, which inherit the CPU set. A step that fails
+// (typically for lack of CAP_SYS_NICE, CAP_IPC_LOCK or RLIMIT_MEMLOCK) is reported and the module
+// runs on without it. Returns 0 if every step succeeded, -1 otherwise.
+int rt_enter(const RtProfile *profile, const char *module) {
+    int result = 0;
+
+    if (profile->cpu_mask != 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu = 0; cpu < RT_MAX_CPUS; cpu++) {
+            if (profile->cpu_mask & (1ULL << cpu)) {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+            fprintf(stderr, "[%s] Error pinning to CPUs: %s\n", module, strerror(errno));
+            result = -1;
+        }
+    }
+    if (!profile->enabled) {
+        return result;
+    }
+
+    // Pages are locked as they are first touched rather than all at once, so the mostly unused
+    // default thread stacks do not count in full against RLIMIT_MEMLOCK. Everything the loops
+    // touch is prefaulted explicitly (rt_prefault()), and stays resident from then on.
+    int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+    flags |= MCL_ONFAULT;
+#endif
+    if (mlockall(flags) != 0) {
+        fprintf(stderr, "[%s] Error locking memory: %s\n", module, strerror(errno));
+        result = -1;
+    }
+    rt_prefault_stack();
+    return result;
+}
+
+// Moves the calling thread to SCHED_FIFO at `priority` and prefaults its stack, or back to the
+// normal scheduler if `priority` is 0. Returns 0 on success, -1 on error with errno set.
+int rt_thread_enter(int priority) {
+    struct sched_param param = { .sched_priority = priority };
+    int error = pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+    if (priority > 0) {
+        rt_prefault_stack();
+    }
+    return 0;
+}
+
+// Faults in every page of [address, address + size) so the first access in the loop does not take
+// a page fault. Contents are left untouched, so it is safe on segments other processes are writing.
+void rt_prefault(void *address, size_t size) {
+    long page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)address & ~(uintptr_t)(page - 1);
+    uintptr_t end = (uintptr_t)address + size;
+
+#ifdef MADV_POPULATE_WRITE
+    if (madvise((void *)start, end - start, MADV_POPULATE_WRITE) == 0) {
+        return; // Mapped writable without writing (Linux 5.14 and later)
+    }
+#endif
+    for (uintptr_t p = start; p < end; p += (uintptr_t)page) {
+        (void)*(volatile const char *)p;
+    }
+}
+
+// Touches RT_STACK_PREFAULT bytes of the calling thread's stack, so later calls do not fault on it
+void rt_prefault_stack(void) {
+    volatile char stack[RT_STACK_PREFAULT];
+    for (size_t i = 0; i < sizeof(stack); i += 4096) {
+        stack[i] = 0; // Volatile stores, which the compiler cannot drop as dead
+    }
+}
@@ -0,0 +1,38 @@
+// rt.h
+#ifndef RT_H
+#define RT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RT_MAX_CPUS 64             // CPUs a profile can pin to (bits of RtProfile.cpu_mask)
+#define RT_LOOP_PRIORITY 80        // Default SCHED_FIFO priority of the module main loops
+#define RT_INPUT_PRIORITY 60       // VMU pedal input thread
+#define RT_OBSERVER_PRIORITY 20    // VMU display and telemetry recorder threads
+#define RT_STACK_PREFAULT (128 * 1024) // Stack prefaulted by each real-time thread
+
+/*
+Real-time execution profile of a module process. When enabled, memory is locked, the pages the
+loops touch are prefaulted, and each thread runs under SCHED_FIFO at its own priority: the main
+loop above the VMU input thread, and both above the display and recorder, so presentation can
+never delay a control tick. A priority of 0 leaves the thread under the normal scheduler.
+Pinning works with or without the rest of the profile.
+*/
+typedef struct {
+    bool enabled;          // Lock memory, prefault and use the SCHED_FIFO priorities below
+    uint64_t cpu_mask;     // CPUs the process is pinned to (bit n = CPU n), 0 for no pinning
+    int loop_priority;     // Main loop of every module
+    int input_priority;    // VMU pedal input thread
+    int observer_priority; // VMU observer threads (status screen, telemetry recorder)
+} RtProfile;
+
+void rt_profile_default(RtProfile *profile);
+int rt_parse_cpus(const char *text, uint64_t *cpu_mask);
+int rt_parse_priorities(const char *text, RtProfile *profile);
+int rt_enter(const RtProfile *profile, const char *module);
+int rt_thread_enter(int priority);
+void rt_prefault(void *address, size_t size);
+void rt_prefault_stack(void);
+
+#endif
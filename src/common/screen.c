@@ -0,0 +1,76 @@
+// Diff-based terminal renderer: one buffered write() of the changed lines per frame
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "screen.h"
+
+void screen_init(Screen *screen, int fd) {
+    memset(screen, 0, sizeof(*screen));
+    screen->fd = fd;
+    screen->redraw = true;
+}
+
+// Starts formatting a new frame
+void screen_begin(Screen *screen) {
+    screen->lines = 0;
+}
+
+// Appends one line (without the newline) to the frame being formatted. Lines beyond
+// SCREEN_MAX_LINES are dropped.
+void screen_line(Screen *screen, const char *format, ...) {
+    if (screen->lines == SCREEN_MAX_LINES) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    vsnprintf(screen->frame[screen->lines], SCREEN_LINE_SIZE, format, args);
+    va_end(args);
+    screen->lines++;
+}
+
+// Sends the lines that differ from the previous frame and leaves the cursor on the line below the
+// frame, where terminal input is echoed. Nothing is written if the frame did not change.
+// Returns the number of bytes written, or -1 on error, after which the next frame is sent in full.
+int screen_flush(Screen *screen) {
+    size_t length = 0;
+    int changed = 0;
+
+    if (screen->redraw) {
+        length += (size_t)snprintf(screen->out, sizeof(screen->out), "\033[H\033[2J");
+    }
+    int rows = screen->lines > screen->previous_lines ? screen->lines : screen->previous_lines;
+    for (int i = 0; i < rows; i++) {
+        const char *line = i < screen->lines ? screen->frame[i] : "";
+        if (!screen->redraw && i < screen->previous_lines && strcmp(line, screen->previous[i]) == 0) {
+            continue;
+        }
+        // Position, text, then clear the rest of a longer previous line
+        length += (size_t)snprintf(screen->out + length, sizeof(screen->out) - length, "\033[%d;1H%s\033[K", i + 1, line);
+        changed++;
+    }
+    screen->frames++;
+    if (changed == 0 && !screen->redraw) {
+        return 0;
+    }
+    length += (size_t)snprintf(screen->out + length, sizeof(screen->out) - length, "\033[%d;1H", screen->lines + 1);
+
+    size_t written = 0;
+    while (written < length) {
+        ssize_t n = write(screen->fd, screen->out + written, length - written);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            screen->redraw = true; // The terminal no longer shows the previous frame
+            return -1;
+        }
+        written += (size_t)n;
+    }
+
+    memcpy(screen->previous, screen->frame, sizeof(screen->frame[0]) * (size_t)screen->lines);
+    screen->previous_lines = screen->lines;
+    screen->redraw = false;
+    screen->lines_written += (unsigned long)changed;
+    screen->bytes_written += written;
+    return (int)written;
+}
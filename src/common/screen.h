@@ -0,0 +1,37 @@
+// screen.h
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SCREEN_MAX_LINES 32  // Lines in a frame
+#define SCREEN_LINE_SIZE 96  // Bytes per line including the terminating NUL; longer lines are cut
+#define SCREEN_OUT_SIZE (SCREEN_MAX_LINES * (SCREEN_LINE_SIZE + 16) + 32) // Worst case: every line redrawn
+
+/*
+Full-screen text renderer for a terminal. A frame is formatted line by line into preallocated
+buffers; screen_flush() compares it with the previous frame and sends only the lines that changed,
+each positioned with a cursor escape, in a single write(). The renderer draws whenever it is asked
+to: pacing belongs to the caller (the VMU status screen is drawn by an observer thread that polls at
+the display rate).
+*/
+typedef struct {
+    int fd;
+    bool redraw;        // Clear the terminal and send every line with the next frame
+    int lines;          // Lines of the frame being formatted
+    int previous_lines; // Lines of the frame on the terminal
+    char frame[SCREEN_MAX_LINES][SCREEN_LINE_SIZE];
+    char previous[SCREEN_MAX_LINES][SCREEN_LINE_SIZE];
+    char out[SCREEN_OUT_SIZE];
+    unsigned long frames;        // Frames flushed
+    unsigned long lines_written; // Lines sent over all frames
+    unsigned long long bytes_written;
+} Screen;
+
+void screen_init(Screen *screen, int fd);
+void screen_begin(Screen *screen);
+void screen_line(Screen *screen, const char *format, ...) __attribute__((format(printf, 2, 3)));
+int screen_flush(Screen *screen);
+
+#endif
@@ -0,0 +1,48 @@
+// seqlock.h
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdbool.h>
+
+/*
+Sequence counter (seqlock) used to publish data placed in shared memory.
+Writers make the counter odd while they update the protected fields and even again when done.
+Readers copy the fields between seqlock_read_begin() and seqlock_read_retry() and start over if
+a write overlapped the copy, so they never block writers and never write to the shared segment.
+*/
+
+typedef unsigned int seqcount_t;
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SEQLOCK_CPU_RELAX() __builtin_ia32_pause()
+#else
+#define SEQLOCK_CPU_RELAX() __asm__ __volatile__("" ::: "memory")
+#endif
+
+// Starts a read section, waiting while a write is in progress. Returns the sequence to validate against.
+static inline seqcount_t seqlock_read_begin(const seqcount_t *seq) {
+    seqcount_t start;
+    while ((start = __atomic_load_n(seq, __ATOMIC_ACQUIRE)) & 1U) {
+        SEQLOCK_CPU_RELAX();
+    }
+    return start;
+}
+
+// Returns true if the fields read since seqlock_read_begin() may be inconsistent and must be read again.
+static inline bool seqlock_read_retry(const seqcount_t *seq, seqcount_t start) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(seq, __ATOMIC_RELAXED) != start;
+}
+
+// Marks the beginning of a write section (sequence becomes odd)
+static inline void seqlock_write_begin(seqcount_t *seq) {
+    __atomic_store_n(seq, __atomic_load_n(seq, __ATOMIC_RELAXED) + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+// Marks the end of a write section (sequence becomes even again)
+static inline void seqlock_write_end(seqcount_t *seq) {
+    __atomic_store_n(seq, __atomic_load_n(seq, __ATOMIC_RELAXED) + 1U, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,173 @@
+// Priority-inheriting, robust process-shared lock of the SystemState segment and owner-death recovery
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include "../vmu/vmu.h"
+
+#define STATE_READ_SPINS 100 // Polls of a counter left odd before a reader waits on the mutex
+
+// Sets up the lock block. Called by the VMU on a fresh segment, before any other process attaches.
+// Returns 0 on success, -1 on error with errno set (the segment then stays in STATE_LOCK_SEM mode).
+int state_lock_init(SystemState *state, StateLockMode mode) {
+    pthread_mutexattr_t attributes;
+    int error;
+
+    state->lock_mode = STATE_LOCK_SEM;
+    state->state_recoveries = 0;
+    if (mode != STATE_LOCK_MUTEX) {
+        return 0;
+    }
+    pthread_mutexattr_init(&attributes);
+    if ((error = pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED)) != 0 ||
+        (error = pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT)) != 0 ||
+        (error = pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST)) != 0 ||
+        (error = pthread_mutex_init(&state->state_mutex, &attributes)) != 0) {
+        pthread_mutexattr_destroy(&attributes);
+        errno = error;
+        return -1;
+    }
+    pthread_mutexattr_destroy(&attributes);
+    state->lock_mode = STATE_LOCK_MUTEX;
+    return 0;
+}
+
+// Locks state_mutex, repairing the state first if the previous holder died with it.
+// Returns 0, 1 if the state was repaired, or -1 with errno set if the mutex is unusable.
+int state_mutex_lock(SystemState *state) {
+    int error = pthread_mutex_lock(&state->state_mutex);
+    if (error == 0) {
+        return 0;
+    }
+    if (error == EOWNERDEAD) {
+        int repaired = system_state_repair(state);
+        state->state_recoveries++;
+        pthread_mutex_consistent(&state->state_mutex);
+        fprintf(stderr, "[STATE] A writer died holding the state lock, %d fields repaired\n", repaired);
+        return 1;
+    }
+    errno = error; // ENOTRECOVERABLE once a repair was abandoned, or a mutex that was never set up
+    return -1;
+}
+
+// Called when state_mutex_lock() failed: without the mutex neither the write sections nor the wait
+// for a dead writer are safe, and a state that may be torn must not be read or published, so the
+// failure is reported and the process stops.
+void state_lock_failed(void) {
+    fprintf(stderr, "[STATE] Error locking the state: %s. Stopping.\n", strerror(errno));
+    abort();
+}
+
+// Slow path of state_read_begin(): a write section of the block is in progress. Returns the even
+// sequence to validate the read against.
+seqcount_t state_read_wait(const SystemState *state, const seqcount_t *seq) {
+    seqcount_t start;
+    int spins = 0;
+
+    while ((start = __atomic_load_n(seq, __ATOMIC_ACQUIRE)) & 1U) {
+        if (state->lock_mode != STATE_LOCK_MUTEX || ++spins < STATE_READ_SPINS) {
+            SEQLOCK_CPU_RELAX();
+            continue;
+        }
+        // The writer holds the mutex for its whole section: block on it, lending it our priority,
+        // and recover the state if it died
+        SystemState *shared = (SystemState *)state;
+        if (state_mutex_lock(shared) < 0) {
+            state_lock_failed(); // The counter may stay odd forever
+        }
+        pthread_mutex_unlock(&shared->state_mutex);
+        spins = 0;
+    }
+    return start;
+}
+
+// Closes a write section abandoned by a dead writer. Returns 1 if the counter was odd.
+static int close_section(seqcount_t *seq) {
+    seqcount_t value = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    if ((value & 1U) == 0) {
+        return 0;
+    }
+    __atomic_store_n(seq, value + 1U, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static int repair_double(double *value, double min, double max, double fallback) {
+    if (isnan(*value)) {
+        *value = fallback;
+        return 1;
+    }
+    if (*value < min || *value > max) {
+        *value = *value < min ? min : max;
+        return 1;
+    }
+    return 0;
+}
+
+static int repair_int(int *value, int min, int max, int fallback) {
+    if (*value < min || *value > max) {
+        *value = fallback;
+        return 1;
+    }
+    return 0;
+}
+
+// A bool torn by a dead writer may hold any byte; only 0 and 1 are valid
+static int repair_bool(bool *value) {
+    unsigned char byte;
+    memcpy(&byte, value, 1);
+    if (byte > 1) {
+        *value = true;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Re-validates the whole state after a writer died, with every other writer excluded (the caller holds
+state_mutex). Odd sequence counters are closed, torn or out-of-range fields are brought back into
+their ranges and the pedals made exclusive again. Each block is rewritten in a write section, so
+readers either see the repaired values or retry. Returns the number of fixes made.
+*/
+int system_state_repair(SystemState *state) {
+    int fixes = 0;
+
+    fixes += close_section(&state->input_seq);
+    seqlock_write_begin(&state->input_seq);
+    fixes += repair_bool(&state->accelerator) + repair_bool(&state->brake);
+    if (state->accelerator && state->brake) {
+        state->accelerator = false; // Both pressed: the brake wins, as set_braking() leaves it
+        fixes++;
+    }
+    seqlock_write_end(&state->input_seq);
+
+    fixes += close_section(&state->vmu_seq);
+    seqlock_write_begin(&state->vmu_seq);
+    fixes += repair_double(&state->speed, MIN_SPEED, MAX_SPEED, MIN_SPEED);
+    fixes += repair_double(&state->battery, 0.0, MAX_BATTERY, 0.0);
+    fixes += repair_double(&state->fuel, 0.0, MAX_FUEL, 0.0);
+    fixes += repair_int(&state->power_mode, 0, 5, 4);
+    fixes += repair_double(&state->ev_power_level, 0.0, 1.0, 0.0);
+    fixes += repair_double(&state->iec_power_level, 0.0, 1.0, 0.0);
+    fixes += repair_bool(&state->was_accelerating);
+    seqlock_write_end(&state->vmu_seq);
+
+    fixes += close_section(&state->ev_seq);
+    seqlock_write_begin(&state->ev_seq);
+    fixes += repair_bool(&state->ev_on);
+    fixes += repair_int(&state->rpm_ev, 0, MAX_EV_RPM, 0);
+    fixes += repair_double(&state->temp_ev, -INFINITY, INFINITY, 25.0);
+    seqlock_write_end(&state->ev_seq);
+
+    fixes += close_section(&state->iec_seq);
+    seqlock_write_begin(&state->iec_seq);
+    fixes += repair_bool(&state->iec_on);
+    fixes += repair_int(&state->rpm_iec, 0, MAX_IEC_RPM, 0);
+    fixes += repair_double(&state->temp_iec, -INFINITY, INFINITY, 25.0);
+    seqlock_write_end(&state->iec_seq);
+
+    // The mailboxes are left alone: their only writer is the VMU control loop, which posts without the
+    // mutex, and the segment does not outlive the VMU
+    return fixes;
+}
@@ -0,0 +1,169 @@
+// Binary telemetry log: fixed-size tick records in a preallocated, memory-mapped ring file
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "telemetry.h"
+
+// Creates (or truncates) `path` with room for `capacity` records and maps it for appending.
+// The blocks are allocated and every page is written once up front, so appends do not allocate,
+// take write faults or fail for lack of disk space. Returns 0 on success, -1 on error with errno set.
+int telemetry_create(TelemetryLog *log, const char *path, uint64_t capacity, uint64_t period_ns, uint64_t engine_period_ns) {
+    memset(log, 0, sizeof(*log));
+    if (capacity == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    size_t map_size = TELEMETRY_HEADER_SIZE + capacity * sizeof(TelemetryRecord);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+    int error = posix_fallocate(fd, 0, (off_t)map_size);
+    if (error != 0 && ftruncate(fd, (off_t)map_size) == -1) {
+        // File systems without fallocate support still get a sparse file of the right size
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    memset(map, 0, map_size);
+
+    log->header = (TelemetryHeader *)map;
+    log->records = (TelemetryRecord *)((char *)map + TELEMETRY_HEADER_SIZE);
+    log->map_size = map_size;
+    memcpy(log->header->magic, TELEMETRY_MAGIC, sizeof(log->header->magic));
+    log->header->version = TELEMETRY_VERSION;
+    log->header->record_size = sizeof(TelemetryRecord);
+    log->header->capacity = capacity;
+    log->header->period_ns = period_ns;
+    log->header->engine_period_ns = engine_period_ns;
+    log->header->head = 0;
+    return 0;
+}
+
+// Maps an existing telemetry file read-only, also while it is being recorded.
+// Returns 0 on success, -1 if it cannot be opened or is not a telemetry file of this version.
+int telemetry_open(TelemetryLog *log, const char *path) {
+    memset(log, 0, sizeof(*log));
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < TELEMETRY_HEADER_SIZE) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    const TelemetryHeader *header = (const TelemetryHeader *)map;
+    if (memcmp(header->magic, TELEMETRY_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TELEMETRY_VERSION || header->record_size != sizeof(TelemetryRecord) ||
+        header->capacity == 0 ||
+        (size_t)st.st_size < TELEMETRY_HEADER_SIZE + header->capacity * sizeof(TelemetryRecord)) {
+        munmap(map, (size_t)st.st_size);
+        errno = EINVAL;
+        return -1;
+    }
+    log->header = (TelemetryHeader *)map;
+    log->records = (TelemetryRecord *)((char *)map + TELEMETRY_HEADER_SIZE);
+    log->map_size = (size_t)st.st_size;
+    return 0;
+}
+
+// Unmaps the log. The kernel writes back the pages of a recorded log as usual.
+void telemetry_close(TelemetryLog *log) {
+    if (log->header != NULL) {
+        munmap(log->header, log->map_size);
+    }
+    memset(log, 0, sizeof(*log));
+}
+
+// Number of records appended so far, including those overwritten by the ring
+uint64_t telemetry_count(const TelemetryLog *log) {
+    return __atomic_load_n(&log->header->head, __ATOMIC_ACQUIRE);
+}
+
+// Index of the oldest record still in the ring
+uint64_t telemetry_first(const TelemetryLog *log) {
+    uint64_t count = telemetry_count(log);
+    return count > log->header->capacity ? count - log->header->capacity : 0;
+}
+
+// Record `index` (counted from the first one ever appended), which must lie between
+// telemetry_first() and telemetry_count()
+const TelemetryRecord *telemetry_get(const TelemetryLog *log, uint64_t index) {
+    return &log->records[index % log->header->capacity];
+}
+
+void telemetry_vehicle_pack(const VehicleState *vehicle, TelemetryVehicle *packed) {
+    memset(packed, 0, sizeof(*packed));
+    packed->speed = vehicle->speed;
+    packed->battery = vehicle->battery;
+    packed->fuel = vehicle->fuel;
+    packed->ev_power_level = vehicle->ev_power_level;
+    packed->iec_power_level = vehicle->iec_power_level;
+    packed->temp_ev = vehicle->temp_ev;
+    packed->temp_iec = vehicle->temp_iec;
+    packed->power_mode = vehicle->power_mode;
+    packed->rpm_ev = vehicle->rpm_ev;
+    packed->rpm_iec = vehicle->rpm_iec;
+    packed->accelerator = vehicle->accelerator;
+    packed->brake = vehicle->brake;
+    packed->was_accelerating = vehicle->was_accelerating;
+    packed->ev_on = vehicle->ev_on;
+    packed->iec_on = vehicle->iec_on;
+}
+
+void telemetry_vehicle_unpack(const TelemetryVehicle *packed, VehicleState *vehicle) {
+    vehicle->speed = packed->speed;
+    vehicle->battery = packed->battery;
+    vehicle->fuel = packed->fuel;
+    vehicle->ev_power_level = packed->ev_power_level;
+    vehicle->iec_power_level = packed->iec_power_level;
+    vehicle->temp_ev = packed->temp_ev;
+    vehicle->temp_iec = packed->temp_iec;
+    vehicle->power_mode = packed->power_mode;
+    vehicle->rpm_ev = packed->rpm_ev;
+    vehicle->rpm_iec = packed->rpm_iec;
+    vehicle->accelerator = packed->accelerator;
+    vehicle->brake = packed->brake;
+    vehicle->was_accelerating = packed->was_accelerating;
+    vehicle->ev_on = packed->ev_on;
+    vehicle->iec_on = packed->iec_on;
+}
+
+// Fills every field of `record` but the time stamp from one control tick: the state the control law
+// read, the commands it decided, the state calculate_speed() read and the state after the tick.
+// The mailboxes are left empty.
+void telemetry_record_fill(TelemetryRecord *record, uint64_t tick, const VehicleState *before, const ControlCommands *commands,
+                           const VehicleState *speed_input, const VehicleState *after) {
+    memset(record, 0, sizeof(*record));
+    record->tick = tick;
+    telemetry_vehicle_pack(before, &record->before);
+    telemetry_vehicle_pack(after, &record->after);
+    record->speed_accelerator = speed_input->accelerator;
+    record->speed_brake = speed_input->brake;
+    record->speed_ev_on = speed_input->ev_on;
+    record->speed_iec_on = speed_input->iec_on;
+    record->ev_command = commands->send_ev ? (int8_t)commands->ev.type : TELEMETRY_NO_COMMAND;
+    record->iec_command = commands->send_iec ? (int8_t)commands->iec.type : TELEMETRY_NO_COMMAND;
+}
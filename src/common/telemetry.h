@@ -0,0 +1,97 @@
+// telemetry.h
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../vmu/vmu_model.h"
+
+#define TELEMETRY_MAGIC "HYBTLM01"       // First bytes of a telemetry file
+#define TELEMETRY_VERSION 2              // Bumped whenever the record layout changes
+#define TELEMETRY_HEADER_SIZE 4096       // Records start on the page after the header
+#define TELEMETRY_DEFAULT_RECORDS 65536  // ~3.6 hours of 200 ms ticks, 13 MB
+#define TELEMETRY_NO_COMMAND -1          // No command issued to an engine in the tick
+
+// One vehicle state with explicit field sizes, so files do not depend on the compiler's bool/enum layout
+typedef struct {
+    double speed;
+    double battery;
+    double fuel;
+    double ev_power_level;
+    double iec_power_level;
+    double temp_ev;
+    double temp_iec;
+    int32_t power_mode;
+    int32_t rpm_ev;
+    int32_t rpm_iec;
+    uint8_t accelerator;
+    uint8_t brake;
+    uint8_t was_accelerating;
+    uint8_t ev_on;
+    uint8_t iec_on;
+    uint8_t reserved[3];
+} TelemetryVehicle;
+
+/*
+One VMU control tick. `before` is the state vmu_control_engines() loaded and `after` every
+SystemState field once the tick has published the new power levels and speed. The pedal and
+engine status calculate_speed() read from its own snapshots are kept as well, since the other
+processes may have changed them in between.
+*/
+typedef struct {
+    uint64_t tick;    // Control tick number, from 1
+    uint64_t time_ns; // CLOCK_MONOTONIC at the end of the tick
+    TelemetryVehicle before;
+    TelemetryVehicle after;
+    uint8_t speed_accelerator; // Inputs of calculate_speed()
+    uint8_t speed_brake;
+    uint8_t speed_ev_on;
+    uint8_t speed_iec_on;
+    int8_t ev_command;  // CommandType sent to each engine in the tick, or TELEMETRY_NO_COMMAND
+    int8_t iec_command;
+    uint8_t reserved[2];
+    uint32_t ev_mailbox_version; // Power setpoint mailboxes
+    uint32_t iec_mailbox_version;
+    double ev_mailbox_power;
+    double iec_mailbox_power;
+} TelemetryRecord;
+
+_Static_assert(sizeof(TelemetryRecord) == 208, "Telemetry record layout changed, bump TELEMETRY_VERSION");
+
+// File header. `head` counts every record ever appended; the last `capacity` of them are kept.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint64_t period_ns; // Control period of the recorded loop
+    uint64_t head;      // Published with release order after each record is complete
+    uint64_t engine_period_ns; // Engine period of a lockstep recording (bin/sim), 0 if the engines ran in their own processes
+} TelemetryHeader;
+
+typedef struct {
+    TelemetryHeader *header;
+    TelemetryRecord *records;
+    size_t map_size;
+} TelemetryLog;
+
+// Appends a record: a copy into the mapping and a counter update, no system call. Pages reach the
+// file through the kernel's normal writeback.
+static inline void telemetry_append(TelemetryLog *log, const TelemetryRecord *record) {
+    uint64_t head = log->header->head;
+    log->records[head % log->header->capacity] = *record;
+    __atomic_store_n(&log->header->head, head + 1, __ATOMIC_RELEASE);
+}
+
+int telemetry_create(TelemetryLog *log, const char *path, uint64_t capacity, uint64_t period_ns, uint64_t engine_period_ns);
+int telemetry_open(TelemetryLog *log, const char *path);
+void telemetry_close(TelemetryLog *log);
+uint64_t telemetry_count(const TelemetryLog *log);
+uint64_t telemetry_first(const TelemetryLog *log);
+const TelemetryRecord *telemetry_get(const TelemetryLog *log, uint64_t index);
+void telemetry_vehicle_pack(const VehicleState *vehicle, TelemetryVehicle *packed);
+void telemetry_vehicle_unpack(const TelemetryVehicle *packed, VehicleState *vehicle);
+void telemetry_record_fill(TelemetryRecord *record, uint64_t tick, const VehicleState *before, const ControlCommands *commands,
+                           const VehicleState *speed_input, const VehicleState *after);
+
+#endif
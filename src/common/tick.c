@@ -0,0 +1,63 @@
+// Absolute-deadline tick scheduler shared by the module main loops
+#include "tick.h"
+#include "clock.h"
+
+// Starts the schedule with the first deadline one period from now
+void tick_init(TickScheduler *sched, long period_ns, TickPolicy policy) {
+    sched->period_ns = period_ns;
+    sched->policy = policy;
+    sched->ticks = 0;
+    sched->overruns = 0;
+    sched->skipped = 0;
+    tick_restart(sched);
+}
+
+// Re-anchors the schedule at the current time without counting overruns (e.g. after a pause)
+void tick_restart(TickScheduler *sched) {
+    clock_gettime(CLOCK_MONOTONIC, &sched->next);
+    timespec_add_ns(&sched->next, sched->period_ns);
+}
+
+// True if the deadline of the next tick has been reached
+bool tick_due(const TickScheduler *sched, const struct timespec *now) {
+    return timespec_cmp(now, &sched->next) >= 0;
+}
+
+// Accounts for a tick that was run at `now` and moves to the next deadline.
+// Returns how late the tick started, in nanoseconds.
+long long tick_advance(TickScheduler *sched, const struct timespec *now) {
+    struct timespec late_by = timespec_until(now, &sched->next);
+    long long late_ns = (long long)late_by.tv_sec * NSEC_PER_SEC + late_by.tv_nsec;
+    long long missed = late_ns / sched->period_ns; // Deadlines that passed in addition to this one
+
+    sched->ticks++;
+    if (missed > 0) {
+        sched->overruns++;
+    }
+
+    if (missed == 0 || (sched->policy == TICK_CATCH_UP && missed <= TICK_MAX_CATCH_UP)) {
+        // On time, or within the catch-up budget: the late ticks become due immediately
+        timespec_add_ns(&sched->next, sched->period_ns);
+    } else {
+        // Drop the missed ticks but stay on the original grid
+        timespec_add_ns(&sched->next, (long)((missed + 1) * sched->period_ns));
+        sched->skipped += missed;
+    }
+    return late_ns;
+}
+
+// Time left until the next deadline, zero if it already passed
+struct timespec tick_timeout(const TickScheduler *sched, const struct timespec *now) {
+    return timespec_until(&sched->next, now);
+}
+
+// Sleeps until the next deadline and accounts for the tick that is about to run.
+// Returns the wake-up lateness in nanoseconds.
+long long tick_wait(TickScheduler *sched) {
+    struct timespec now;
+
+    // Returns early with EINTR on SIGINT/SIGUSR1 so the caller can re-check its flags
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &sched->next, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return tick_advance(sched, &now);
+}
@@ -0,0 +1,37 @@
+// tick.h
+#ifndef TICK_H
+#define TICK_H
+
+#include <stdbool.h>
+#include <time.h>
+
+#define TICK_MAX_CATCH_UP 5 // Late ticks run back-to-back before the schedule is realigned
+
+// What to do with ticks whose deadline passed while the loop was busy
+typedef enum {
+    TICK_CATCH_UP, // Run missed ticks back-to-back (bounded by TICK_MAX_CATCH_UP) so the tick count tracks wall time
+    TICK_SKIP      // Drop missed ticks and realign to the next deadline on the original grid
+} TickPolicy;
+
+/*
+Fixed-rate scheduler driven by absolute CLOCK_MONOTONIC deadlines.
+Deadlines advance by exactly one period per tick, so the time spent in the loop body does
+not accumulate into the period the way a relative usleep() does.
+*/
+typedef struct {
+    struct timespec next;   // Absolute deadline of the next tick
+    long period_ns;         // Tick period
+    TickPolicy policy;      // Overrun handling
+    unsigned long ticks;    // Ticks run so far
+    unsigned long overruns; // Ticks that started at least one full period late
+    unsigned long skipped;  // Ticks dropped by TICK_SKIP or by realignment
+} TickScheduler;
+
+void tick_init(TickScheduler *sched, long period_ns, TickPolicy policy);
+void tick_restart(TickScheduler *sched);
+bool tick_due(const TickScheduler *sched, const struct timespec *now);
+long long tick_advance(TickScheduler *sched, const struct timespec *now);
+struct timespec tick_timeout(const TickScheduler *sched, const struct timespec *now);
+long long tick_wait(TickScheduler *sched);
+
+#endif
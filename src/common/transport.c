@@ -0,0 +1,279 @@
+// Transport backends between the VMU and the engine modules: POSIX named objects and in-process memory
+#define _GNU_SOURCE // ppoll()
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "transport.h"
+
+#define TRANSPORT_QUEUE_DEPTH 10 // Commands held by each POSIX message queue
+
+static const char *const channel_names[TRANSPORT_CHANNELS] = { "EV", "IEC" };
+
+// Reports a failed step like perror(), prefixed with the module name, and preserves errno
+static void report(const Transport *transport, const char *what) {
+    int error = errno;
+    fprintf(stderr, "[%s] %s: %s\n", transport->module, what, strerror(error));
+    errno = error;
+}
+
+// Channel an engine endpoint receives on
+static TransportChannel own_channel(const Transport *transport) {
+    return transport->role == TRANSPORT_ROLE_IEC ? TRANSPORT_IEC : TRANSPORT_EV;
+}
+
+// Marks the endpoint closed
+static void reset_endpoint(Transport *transport) {
+    transport->state = (SystemState *)MAP_FAILED;
+    transport->sem = SEM_FAILED;
+    transport->shm_fd = -1;
+    for (int channel = 0; channel < TRANSPORT_CHANNELS; channel++) {
+        transport->queues[channel] = (mqd_t)-1;
+        transport->rings[channel] = NULL;
+    }
+}
+
+void transport_init(Transport *transport, const TransportOps *ops, TransportRole role, CommandTransport commands, const char *module) {
+    memset(transport, 0, sizeof(*transport));
+    transport->ops = ops;
+    transport->role = role;
+    transport->commands = commands;
+    transport->module = module;
+    transport->names.state = SHARED_MEM_NAME;
+    transport->names.semaphore = SEMAPHORE_NAME;
+    transport->names.queues[TRANSPORT_EV] = EV_COMMAND_QUEUE_NAME;
+    transport->names.queues[TRANSPORT_IEC] = IEC_COMMAND_QUEUE_NAME;
+    transport->names.rings[TRANSPORT_EV] = EV_COMMAND_RING_NAME;
+    transport->names.rings[TRANSPORT_IEC] = IEC_COMMAND_RING_NAME;
+    reset_endpoint(transport);
+}
+
+// --- Command channels, message queues or rings depending on `commands` ---
+
+static int channel_send(Transport *transport, TransportChannel channel, const EngineCommand *cmd) {
+    if (transport->commands == TRANSPORT_RING) {
+        if (transport->rings[channel] == NULL) {
+            errno = EBADF;
+            return -1;
+        }
+        return cmd_ring_push(transport->rings[channel], cmd);
+    }
+    return mq_send(transport->queues[channel], (const char *)cmd, sizeof(*cmd), 0);
+}
+
+static int channel_receive(Transport *transport, EngineCommand *cmd) {
+    TransportChannel channel = own_channel(transport);
+    if (transport->commands == TRANSPORT_RING) {
+        return cmd_ring_pop(transport->rings[channel], cmd);
+    }
+    return mq_receive(transport->queues[channel], (char *)cmd, sizeof(*cmd), NULL) == -1 ? -1 : 0;
+}
+
+static int channel_wait(Transport *transport, const struct timespec *timeout) {
+    TransportChannel channel = own_channel(transport);
+    if (transport->commands == TRANSPORT_RING) {
+        return cmd_ring_wait(transport->rings[channel], timeout);
+    }
+
+    // On Linux a message queue descriptor is a pollable file descriptor
+    struct pollfd pfd = { .fd = (int)transport->queues[channel], .events = POLLIN };
+    int ret = ppoll(&pfd, 1, timeout, NULL);
+    if (ret == -1 && errno == EINTR) {
+        return 0; // Interrupted by SIGINT/SIGUSR1; the main loop re-checks its flags
+    }
+    return ret > 0 ? 1 : ret;
+}
+
+// --- POSIX backend ---
+
+// Unmaps and closes whatever is open. The VMU, which created the objects, also unlinks them.
+static void posix_close(Transport *transport) {
+    bool vmu = transport->role == TRANSPORT_ROLE_VMU;
+
+    for (int channel = 0; channel < TRANSPORT_CHANNELS; channel++) {
+        close_command_ring(transport->rings[channel]);
+        if (transport->queues[channel] != (mqd_t)-1) {
+            mq_close(transport->queues[channel]);
+        }
+        if (vmu && transport->commands == TRANSPORT_RING) {
+            shm_unlink(transport->names.rings[channel]);
+        } else if (vmu) {
+            mq_unlink(transport->names.queues[channel]);
+        }
+    }
+    if (transport->state != MAP_FAILED) {
+        munmap(transport->state, sizeof(SystemState));
+    }
+    if (transport->sem != SEM_FAILED) {
+        sem_close(transport->sem);
+    }
+    if (vmu) {
+        shm_unlink(transport->names.state);
+        sem_unlink(transport->names.semaphore);
+    }
+    reset_endpoint(transport);
+}
+
+// Unwinds a failed posix_open()
+static int posix_fail(Transport *transport) {
+    int error = errno;
+    posix_close(transport);
+    errno = error;
+    return -1;
+}
+
+// Opens the command channel of `channel`: created and reset by the VMU, attached by its engine
+static int posix_open_channel(Transport *transport, TransportChannel channel) {
+    bool vmu = transport->role == TRANSPORT_ROLE_VMU;
+    char what[64];
+
+    if (transport->commands == TRANSPORT_RING) {
+        // Reset by the VMU so no command from a previous run is replayed
+        transport->rings[channel] = open_command_ring(transport->names.rings[channel], vmu);
+        if (transport->rings[channel] == NULL) {
+            report(transport, vmu ? "Error creating command rings" : "Error opening command ring");
+            return -1;
+        }
+        return 0;
+    }
+
+    struct mq_attr attributes = {
+        .mq_flags = 0,
+        .mq_maxmsg = TRANSPORT_QUEUE_DEPTH,
+        .mq_msgsize = sizeof(EngineCommand),
+        .mq_curmsgs = 0
+    };
+    // Non-blocking on both ends; an engine creates its queue too in case the VMU failed to
+    transport->queues[channel] = mq_open(transport->names.queues[channel], (vmu ? O_WRONLY : O_RDONLY) | O_CREAT | O_NONBLOCK, 0666, &attributes);
+    if (transport->queues[channel] == (mqd_t)-1) {
+        if (vmu) {
+            snprintf(what, sizeof(what), "Error creating/opening %s message queue", channel_names[channel]);
+        } else {
+            snprintf(what, sizeof(what), "Error creating/opening message queue");
+        }
+        report(transport, what);
+        return -1;
+    }
+    return 0;
+}
+
+static int posix_open(Transport *transport) {
+    bool vmu = transport->role == TRANSPORT_ROLE_VMU;
+
+    transport->shm_fd = shm_open(transport->names.state, vmu ? O_CREAT | O_RDWR : O_RDWR, 0666);
+    if (transport->shm_fd == -1) {
+        report(transport, "Error opening shared memory");
+        return -1;
+    }
+    if (vmu && ftruncate(transport->shm_fd, sizeof(SystemState)) == -1) {
+        report(transport, "Error configuring shared memory size");
+        close(transport->shm_fd);
+        transport->shm_fd = -1;
+        return posix_fail(transport);
+    }
+    transport->state = (SystemState *)mmap(NULL, sizeof(SystemState), PROT_READ | PROT_WRITE, MAP_SHARED, transport->shm_fd, 0);
+    close(transport->shm_fd);
+    transport->shm_fd = -1; // The mapping keeps the object; the descriptor is not needed any more
+    if (transport->state == MAP_FAILED) {
+        report(transport, "Error mapping shared memory");
+        return posix_fail(transport);
+    }
+
+    // Kept for tools and tests that serialize whole-state updates (modules publish lock-free)
+    transport->sem = vmu ? sem_open(transport->names.semaphore, O_CREAT, 0666, 1) : sem_open(transport->names.semaphore, 0);
+    if (transport->sem == SEM_FAILED) {
+        report(transport, vmu ? "Error creating semaphore" : "Error opening semaphore");
+        return posix_fail(transport);
+    }
+
+    for (int channel = 0; channel < TRANSPORT_CHANNELS; channel++) {
+        if ((vmu || channel == (int)own_channel(transport)) && posix_open_channel(transport, channel) != 0) {
+            return posix_fail(transport);
+        }
+    }
+    return 0;
+}
+
+const TransportOps posix_transport = {
+    .name = "posix",
+    .open = posix_open,
+    .send = channel_send,
+    .receive = channel_receive,
+    .wait = channel_wait,
+    .close = posix_close,
+};
+
+// --- In-process backend ---
+
+// Created by the VMU endpoint and attached by the engine threads. Endpoints are opened and closed
+// only while the engine threads are not running, so the bus needs no lock.
+static struct {
+    SystemState *state;
+    CommandRing *rings[TRANSPORT_CHANNELS];
+} bus;
+
+static void inproc_close(Transport *transport) {
+    if (transport->role == TRANSPORT_ROLE_VMU) {
+        for (int channel = 0; channel < TRANSPORT_CHANNELS; channel++) {
+            close_command_ring(transport->rings[channel]);
+        }
+        if (transport->state != MAP_FAILED) {
+            munmap(transport->state, sizeof(SystemState));
+            if (bus.state == transport->state) {
+                memset(&bus, 0, sizeof(bus));
+            }
+        }
+    }
+    reset_endpoint(transport); // The engines only drop their view of the bus
+}
+
+static int inproc_open(Transport *transport) {
+    transport->commands = TRANSPORT_RING; // The channels behave exactly like the shared-memory rings
+
+    if (transport->role != TRANSPORT_ROLE_VMU) {
+        if (bus.state == NULL) {
+            errno = ENOENT;
+            report(transport, "Error attaching to the VMU");
+            return -1;
+        }
+        TransportChannel channel = own_channel(transport);
+        transport->state = bus.state;
+        transport->rings[channel] = bus.rings[channel];
+        return 0;
+    }
+
+    if (bus.state != NULL) {
+        errno = EBUSY;
+        report(transport, "Error creating the in-process transport");
+        return -1;
+    }
+    transport->state = (SystemState *)mmap(NULL, sizeof(SystemState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (transport->state == MAP_FAILED) {
+        report(transport, "Error mapping system state");
+        return -1;
+    }
+    for (int channel = 0; channel < TRANSPORT_CHANNELS; channel++) {
+        transport->rings[channel] = open_private_command_ring();
+        if (transport->rings[channel] == NULL) {
+            report(transport, "Error creating command rings");
+            inproc_close(transport);
+            return -1;
+        }
+    }
+    bus.state = transport->state;
+    memcpy(bus.rings, transport->rings, sizeof(bus.rings));
+    return 0;
+}
+
+const TransportOps inproc_transport = {
+    .name = "inproc",
+    .open = inproc_open,
+    .send = channel_send,
+    .receive = channel_receive,
+    .wait = channel_wait,
+    .close = inproc_close,
+};
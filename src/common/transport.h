@@ -0,0 +1,99 @@
+// transport.h
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdbool.h>
+#include <time.h>
+#include <semaphore.h>
+#include <mqueue.h>
+#include "../vmu/vmu.h"
+#include "cmd_ring.h"
+
+// Command channels, one per engine module
+typedef enum {
+    TRANSPORT_EV,
+    TRANSPORT_IEC,
+    TRANSPORT_CHANNELS
+} TransportChannel;
+
+// End of the transport opened by a module
+typedef enum {
+    TRANSPORT_ROLE_VMU, // Creates the state and both channels, sends on both
+    TRANSPORT_ROLE_EV,  // Attaches to the state, receives on TRANSPORT_EV
+    TRANSPORT_ROLE_IEC  // Attaches to the state, receives on TRANSPORT_IEC
+} TransportRole;
+
+// Names of the objects of the POSIX backend (defaults set by transport_init())
+typedef struct {
+    const char *state;     // Shared-memory object holding the SystemState
+    const char *semaphore; // Named semaphore of the tools that update the whole state
+    const char *queues[TRANSPORT_CHANNELS];
+    const char *rings[TRANSPORT_CHANNELS];
+} TransportNames;
+
+typedef struct Transport Transport;
+
+/*
+A transport backend. open() creates (VMU) or attaches to (engines) the state and the command channels,
+send() queues a command on a channel without blocking, receive() takes the next pending command of the
+engine's channel without blocking, wait() sleeps until one is pending or the timeout expires, and
+close() releases the endpoint (the VMU also removes what it created). send() and receive() fail with
+EAGAIN like mq_send() and mq_receive() on O_NONBLOCK queues.
+
+State is published and snapshotted with state_write_begin()/end() and the snapshot_*() helpers on
+`state`: every backend maps the state in memory shared by all its endpoints, so the seqlock protocol is
+the same for all of them and stays inline rather than behind an indirect call.
+*/
+typedef struct {
+    const char *name;
+    int (*open)(Transport *transport);
+    int (*send)(Transport *transport, TransportChannel channel, const EngineCommand *cmd);
+    int (*receive)(Transport *transport, EngineCommand *cmd);
+    int (*wait)(Transport *transport, const struct timespec *timeout);
+    void (*close)(Transport *transport);
+} TransportOps;
+
+struct Transport {
+    const TransportOps *ops;
+    TransportRole role;
+    CommandTransport commands; // POSIX backend: message queues or command rings
+    const char *module;        // Prefix of error messages ("VMU", "EV" or "IEC")
+    TransportNames names;
+    // Endpoint, set by open()
+    SystemState *state;        // MAP_FAILED until opened
+    sem_t *sem;                // SEM_FAILED unless the backend has one
+    int shm_fd;                // Descriptor of the state while it is being mapped, -1 otherwise
+    mqd_t queues[TRANSPORT_CHANNELS];       // (mqd_t)-1 unless used
+    CommandRing *rings[TRANSPORT_CHANNELS]; // NULL unless used
+};
+
+// Named objects shared between processes: the state segment, the semaphore and message queues or rings
+extern const TransportOps posix_transport;
+// Anonymous memory shared between the threads of one process (--runtime=threads)
+extern const TransportOps inproc_transport;
+
+void transport_init(Transport *transport, const TransportOps *ops, TransportRole role, CommandTransport commands, const char *module);
+
+// Returns 0 on success, -1 on error (reported on stderr, nothing left open)
+static inline int transport_open(Transport *transport) {
+    return transport->ops->open(transport);
+}
+
+static inline int transport_send(Transport *transport, TransportChannel channel, const EngineCommand *cmd) {
+    return transport->ops->send(transport, channel, cmd);
+}
+
+static inline int transport_receive(Transport *transport, EngineCommand *cmd) {
+    return transport->ops->receive(transport, cmd);
+}
+
+// Returns 1 if a command is pending, 0 on timeout or signal, -1 on error
+static inline int transport_wait(Transport *transport, const struct timespec *timeout) {
+    return transport->ops->wait(transport, timeout);
+}
+
+static inline void transport_close(Transport *transport) {
+    transport->ops->close(transport);
+}
+
+#endif
@@ -0,0 +1,60 @@
+// Electric motor model shared by the EV module and the headless simulation
+
+#include "ev_model.h"
+#include "ev.h"
+
+// Advances the motor by one physics step: RPM follows the commanded power level and the
+// temperature rises while running and cools down towards ambient while off
+void ev_engine_model(bool ev_on, double ev_power_level, int *rpm_ev, double *temp_ev) {
+    int new_rpm = *rpm_ev;
+    double new_temp = *temp_ev;
+
+    if (ev_on) {
+        // Calculate target RPM based on the commanded power level
+        int target_rpm = (int)(ev_power_level * MAX_EV_RPM);
+        
+        // Smoothly transition RPM 
+        if (*rpm_ev < target_rpm) {
+            new_rpm += (int)(MAX_EV_RPM * POWER_INCREASE_RATE);
+            if (new_rpm > target_rpm) new_rpm = target_rpm;
+        } else if (*rpm_ev > target_rpm) {
+            new_rpm -= (int)(MAX_EV_RPM * POWER_DECREASE_RATE * 0.5);
+            if (new_rpm < target_rpm) new_rpm = target_rpm;
+        }
+        
+        // Calculate temperature change
+        new_temp = *temp_ev + (ev_power_level * EV_TEMP_INCREASE_RATE);
+        if (new_temp > MAX_EV_TEMP){
+            new_temp = MAX_EV_TEMP; // Cap at max temp
+        }
+        
+    } else {
+        // Calculate target RPM based on the commanded power level
+        int target_rpm = (int)(ev_power_level * MAX_EV_RPM);
+        
+        // Smoothly transition RPM
+        if (*rpm_ev > target_rpm) {
+            new_rpm -= (int)(MAX_EV_RPM * POWER_DECREASE_RATE * 0.5);
+            if (new_rpm < target_rpm) new_rpm = target_rpm;
+        }
+        
+        // Cool down the engine if it's above ambient temperature
+        if (*temp_ev > 25.0) {
+            new_temp = *temp_ev - EV_TEMP_DECREASE_RATE;
+            if (new_temp < 25.0) new_temp = 25.0;
+        }
+    }
+
+    *rpm_ev = new_rpm;
+    *temp_ev = new_temp;
+}
+
+// Applies the on/off effect of a command. SET_POWER and END do not change the motor state.
+void ev_apply_command(CommandType type, bool *ev_on, int *rpm_ev) {
+    if (type == CMD_START) {
+        *ev_on = true;
+    } else if (type == CMD_STOP) {
+        *ev_on = false;
+        *rpm_ev = 0; // Set RPM to 0 when stopping
+    }
+}
@@ -0,0 +1,11 @@
+// ev_model.h
+#ifndef EV_MODEL_H
+#define EV_MODEL_H
+
+#include <stdbool.h>
+#include "../vmu/vmu.h"
+
+void ev_engine_model(bool ev_on, double ev_power_level, int *rpm_ev, double *temp_ev);
+void ev_apply_command(CommandType type, bool *ev_on, int *rpm_ev);
+
+#endif
@@ -3,25 +3,43 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include "ev.c"
+#include "../common/options.h"
+#include "../common/histogram.h"
+#include "../common/rt.h"
+
+int main(int argc, char *argv[]) {
+    RuntimeOptions options;
+    if (!parse_runtime_options(argc, argv, &options)) {
+        exit(EXIT_FAILURE);
+    }
+    command_transport = options.transport;
+    power_mailbox = options.power_mailbox;
 
-int main() {
     system("clear");
+    rt_enter(&options.rt, "EV"); // Pinning and memory locking before the segments are mapped
     // Initialize communication with VMU
-    if(init_communication_ev(SHARED_MEM_NAME, SEMAPHORE_NAME, IEC_COMMAND_QUEUE_NAME) == 0){
+    if(init_communication_ev(SHARED_MEM_NAME, SEMAPHORE_NAME, EV_COMMAND_QUEUE_NAME) == 0){
         exit(EXIT_FAILURE);
     }    
     
-    // Main loop of the EV module
-    while (running) {
-        if (!paused) {
-            receive_cmd(); // Receive commands from the VMU
-            engine(); // Call the engine function to update the engine state
-            // Simulate EV engine behavior
-            usleep(70000); // Small delay for the IEC loop
-        } else {
-            sleep(1); // Sleep for 1 second if paused
+    if (options.stats && stats_open(EV_STATS_NAME, "ev") == NULL) {
+        perror("[EV] Error creating statistics segment");
+    }
+    if (options.rt.enabled) {
+        // Everything the loop touches is resident before the first step
+        rt_prefault(system_state, sizeof(SystemState));
+        if (ev_transport.rings[TRANSPORT_EV] != NULL) rt_prefault(ev_transport.rings[TRANSPORT_EV], sizeof(CommandRing));
+        if (rt_thread_enter(options.rt.loop_priority) != 0) {
+            perror("[EV] Error setting main loop priority");
         }
     }
+    // Main loop of the EV module: physics runs on absolute deadlines, commands are
+    // handled as soon as they arrive instead of waiting for the next step
+    ev_loop.period_ns = options.period_ns ? options.period_ns : ENGINE_PERIOD_NS;
+    ev_loop.tick_policy = options.tick_policy;
+    engine_loop_run(&ev_loop);
+    engine_loop_report(&ev_loop);
+    stats_close(EV_STATS_NAME);
 
     cleanup(); // Cleanup resources before exiting
     return 0;
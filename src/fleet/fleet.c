@@ -0,0 +1,268 @@
+// Fleet simulation: the headless lockstep simulation applied to many vehicles stored as
+// structure-of-arrays.
+
+#include <stdlib.h>
+#include <string.h>
+#include "fleet.h"
+#include "fleet_simd.h"
+#include "../ev/ev_model.h"
+#include "../iec/iec_model.h"
+
+// Allocates a zeroed, cache line aligned array of `capacity` elements
+static void *fleet_array(int capacity, size_t size) {
+    size_t bytes = (size_t)capacity * size;
+    bytes = (bytes + FLEET_ALIGNMENT - 1) / FLEET_ALIGNMENT * FLEET_ALIGNMENT;
+    void *array = aligned_alloc(FLEET_ALIGNMENT, bytes);
+    if (array != NULL) {
+        memset(array, 0, bytes);
+    }
+    return array;
+}
+
+// Allocates the arrays of `count` parked vehicles. Returns 0 on success, -1 if out of memory.
+int fleet_init(Fleet *fleet, int count, long vmu_period_ns, long engine_period_ns) {
+    memset(fleet, 0, sizeof(*fleet));
+    if (count < 1) {
+        return -1;
+    }
+    fleet->count = count;
+    fleet->capacity = (count + FLEET_PAD - 1) / FLEET_PAD * FLEET_PAD;
+
+    int n = fleet->capacity;
+    fleet->accelerator = fleet_array(n, sizeof(bool));
+    fleet->brake = fleet_array(n, sizeof(bool));
+    fleet->speed = fleet_array(n, sizeof(double));
+    fleet->battery = fleet_array(n, sizeof(double));
+    fleet->fuel = fleet_array(n, sizeof(double));
+    fleet->power_mode = fleet_array(n, sizeof(int));
+    fleet->ev_power_level = fleet_array(n, sizeof(double));
+    fleet->iec_power_level = fleet_array(n, sizeof(double));
+    fleet->was_accelerating = fleet_array(n, sizeof(bool));
+    fleet->ev_on = fleet_array(n, sizeof(bool));
+    fleet->rpm_ev = fleet_array(n, sizeof(int));
+    fleet->temp_ev = fleet_array(n, sizeof(double));
+    fleet->iec_on = fleet_array(n, sizeof(bool));
+    fleet->rpm_iec = fleet_array(n, sizeof(int));
+    fleet->temp_iec = fleet_array(n, sizeof(double));
+    fleet->ev_command = fleet_array(n, sizeof(int));
+    fleet->iec_command = fleet_array(n, sizeof(int));
+    fleet->distance_km = fleet_array(n, sizeof(double));
+    fleet->max_speed = fleet_array(n, sizeof(double));
+    fleet->commands = fleet_array(n, sizeof(unsigned long));
+
+    if (!fleet->accelerator || !fleet->brake || !fleet->speed || !fleet->battery || !fleet->fuel ||
+        !fleet->power_mode || !fleet->ev_power_level || !fleet->iec_power_level || !fleet->was_accelerating ||
+        !fleet->ev_on || !fleet->rpm_ev || !fleet->temp_ev || !fleet->iec_on || !fleet->rpm_iec ||
+        !fleet->temp_iec || !fleet->ev_command || !fleet->iec_command || !fleet->distance_km || !fleet->max_speed || !fleet->commands) {
+        fleet_free(fleet);
+        return -1;
+    }
+
+    VehicleState parked;
+    init_vehicle_state(&parked);
+    for (int i = 0; i < n; i++) {
+        fleet_put_vehicle(fleet, i, &parked);
+        fleet->ev_command[i] = FLEET_NO_COMMAND;
+        fleet->iec_command[i] = FLEET_NO_COMMAND;
+    }
+
+    fleet->vmu_period_ns = vmu_period_ns;
+    fleet->engine_period_ns = engine_period_ns;
+    fleet->next_vmu_ns = vmu_period_ns;
+    fleet->next_engine_ns = engine_period_ns;
+    return 0;
+}
+
+void fleet_free(Fleet *fleet) {
+    free(fleet->accelerator);
+    free(fleet->brake);
+    free(fleet->speed);
+    free(fleet->battery);
+    free(fleet->fuel);
+    free(fleet->power_mode);
+    free(fleet->ev_power_level);
+    free(fleet->iec_power_level);
+    free(fleet->was_accelerating);
+    free(fleet->ev_on);
+    free(fleet->rpm_ev);
+    free(fleet->temp_ev);
+    free(fleet->iec_on);
+    free(fleet->rpm_iec);
+    free(fleet->temp_iec);
+    free(fleet->ev_command);
+    free(fleet->iec_command);
+    free(fleet->distance_km);
+    free(fleet->max_speed);
+    free(fleet->commands);
+    memset(fleet, 0, sizeof(*fleet));
+}
+
+// Copies vehicle i out of the arrays
+void fleet_get_vehicle(const Fleet *fleet, int i, VehicleState *vehicle) {
+    vehicle->accelerator = fleet->accelerator[i];
+    vehicle->brake = fleet->brake[i];
+    vehicle->speed = fleet->speed[i];
+    vehicle->battery = fleet->battery[i];
+    vehicle->fuel = fleet->fuel[i];
+    vehicle->power_mode = fleet->power_mode[i];
+    vehicle->ev_power_level = fleet->ev_power_level[i];
+    vehicle->iec_power_level = fleet->iec_power_level[i];
+    vehicle->was_accelerating = fleet->was_accelerating[i];
+    vehicle->ev_on = fleet->ev_on[i];
+    vehicle->rpm_ev = fleet->rpm_ev[i];
+    vehicle->temp_ev = fleet->temp_ev[i];
+    vehicle->iec_on = fleet->iec_on[i];
+    vehicle->rpm_iec = fleet->rpm_iec[i];
+    vehicle->temp_iec = fleet->temp_iec[i];
+}
+
+// Copies vehicle i into the arrays
+void fleet_put_vehicle(Fleet *fleet, int i, const VehicleState *vehicle) {
+    fleet->accelerator[i] = vehicle->accelerator;
+    fleet->brake[i] = vehicle->brake;
+    fleet->speed[i] = vehicle->speed;
+    fleet->battery[i] = vehicle->battery;
+    fleet->fuel[i] = vehicle->fuel;
+    fleet->power_mode[i] = vehicle->power_mode;
+    fleet->ev_power_level[i] = vehicle->ev_power_level;
+    fleet->iec_power_level[i] = vehicle->iec_power_level;
+    fleet->was_accelerating[i] = vehicle->was_accelerating;
+    fleet->ev_on[i] = vehicle->ev_on;
+    fleet->rpm_ev[i] = vehicle->rpm_ev;
+    fleet->temp_ev[i] = vehicle->temp_ev;
+    fleet->iec_on[i] = vehicle->iec_on;
+    fleet->rpm_iec[i] = vehicle->rpm_iec;
+    fleet->temp_iec[i] = vehicle->temp_iec;
+}
+
+// Segment end times are accumulated exactly as sim_run_script() advances through the segments,
+// so a fleet without stagger changes pedals at the same steps as the single-vehicle simulation
+void fleet_script_init(FleetScript *fleet_script, const PedalScript *script, unsigned long long stagger_ns) {
+    unsigned long long end_ns = 0;
+    for (int i = 0; i < script->count; i++) {
+        end_ns += (unsigned long long)(script->segments[i].duration_s * 1e9 + 0.5);
+        fleet_script->end_ns[i] = end_ns;
+    }
+    fleet_script->script = script;
+    fleet_script->length_ns = end_ns;
+    fleet_script->stagger_ns = stagger_ns;
+}
+
+// Pedal of vehicle i for the step at `time_ns`. A step that falls exactly on a segment boundary
+// still belongs to the segment that ends there, as in sim_advance().
+Pedal fleet_script_pedal(const FleetScript *fleet_script, int i, unsigned long long time_ns) {
+    const PedalScript *script = fleet_script->script;
+    unsigned long long position = (time_ns + (unsigned long long)i * fleet_script->stagger_ns) % fleet_script->length_ns;
+
+    if (position == 0) {
+        return script->segments[script->count - 1].pedal;
+    }
+    int segment = 0;
+    while (position > fleet_script->end_ns[segment]) {
+        segment++;
+    }
+    return script->segments[segment].pedal;
+}
+
+// VMU step of vehicles [first, last) at the current fleet time, in the order of vehicle_vmu_step():
+// control law and speed (vectorized, see fleet_simd.h), then delivery of the issued commands.
+// Pedals are taken from the script when one is given, otherwise the values already in the arrays
+// are used.
+void fleet_vmu_step_range(Fleet *fleet, const FleetScript *fleet_script, int first, int last) {
+    if (fleet_script != NULL) {
+        for (int i = first; i < last; i++) {
+            Pedal pedal = fleet_script_pedal(fleet_script, i, fleet->time_ns);
+            fleet->accelerator[i] = (pedal == PEDAL_ACCELERATE);
+            fleet->brake[i] = (pedal == PEDAL_BRAKE);
+        }
+    }
+
+    fleet_control(fleet, first, last);
+    fleet_speed(fleet, first, last);
+
+    for (int i = first; i < last; i++) {
+        double speed = fleet->speed[i];
+
+        if (fleet->ev_command[i] != FLEET_NO_COMMAND) {
+            ev_apply_command((CommandType)fleet->ev_command[i], &fleet->ev_on[i], &fleet->rpm_ev[i]);
+            fleet->commands[i]++;
+        }
+        if (fleet->iec_command[i] != FLEET_NO_COMMAND) {
+            iec_apply_command((CommandType)fleet->iec_command[i], &fleet->iec_on[i], &fleet->rpm_iec[i]);
+            fleet->commands[i]++;
+        }
+
+        fleet->distance_km[i] += speed * (double)fleet->vmu_period_ns / 3600e9;
+        if (speed > fleet->max_speed[i]) {
+            fleet->max_speed[i] = speed;
+        }
+    }
+}
+
+// Physics step of both engines of vehicles [first, last)
+void fleet_engine_step_range(Fleet *fleet, int first, int last) {
+    fleet_engines(fleet, first, last);
+}
+
+// Runs every step due in the next `duration_ns` of simulated time for the whole fleet, with the
+// same ordering as sim_advance()
+void fleet_advance(Fleet *fleet, unsigned long long duration_ns, const FleetScript *fleet_script) {
+    unsigned long long end_ns = fleet->time_ns + duration_ns;
+
+    while (fleet->next_vmu_ns <= end_ns || fleet->next_engine_ns <= end_ns) {
+        if (fleet->next_engine_ns <= fleet->next_vmu_ns) {
+            fleet->time_ns = fleet->next_engine_ns;
+            fleet_engine_step_range(fleet, 0, fleet->count);
+            fleet->next_engine_ns += fleet->engine_period_ns;
+            fleet->engine_steps++;
+        } else {
+            fleet->time_ns = fleet->next_vmu_ns;
+            fleet_vmu_step_range(fleet, fleet_script, 0, fleet->count);
+            fleet->next_vmu_ns += fleet->vmu_period_ns;
+            fleet->vmu_steps++;
+        }
+    }
+    fleet->time_ns = end_ns;
+}
+
+unsigned long fleet_total_commands(const Fleet *fleet) {
+    unsigned long total = 0;
+    for (int i = 0; i < fleet->count; i++) {
+        total += fleet->commands[i];
+    }
+    return total;
+}
+
+// FNV-1a hash of `bytes` bytes, continuing from `hash`
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t bytes) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < bytes; i++) {
+        hash = (hash ^ p[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Hash of the state and statistics of every vehicle, to compare runs bit for bit
+uint64_t fleet_checksum(const Fleet *fleet) {
+    size_t n = (size_t)fleet->count;
+    uint64_t hash = 14695981039346656037ULL;
+    hash = fnv1a(hash, fleet->accelerator, n * sizeof(bool));
+    hash = fnv1a(hash, fleet->brake, n * sizeof(bool));
+    hash = fnv1a(hash, fleet->speed, n * sizeof(double));
+    hash = fnv1a(hash, fleet->battery, n * sizeof(double));
+    hash = fnv1a(hash, fleet->fuel, n * sizeof(double));
+    hash = fnv1a(hash, fleet->power_mode, n * sizeof(int));
+    hash = fnv1a(hash, fleet->ev_power_level, n * sizeof(double));
+    hash = fnv1a(hash, fleet->iec_power_level, n * sizeof(double));
+    hash = fnv1a(hash, fleet->was_accelerating, n * sizeof(bool));
+    hash = fnv1a(hash, fleet->ev_on, n * sizeof(bool));
+    hash = fnv1a(hash, fleet->rpm_ev, n * sizeof(int));
+    hash = fnv1a(hash, fleet->temp_ev, n * sizeof(double));
+    hash = fnv1a(hash, fleet->iec_on, n * sizeof(bool));
+    hash = fnv1a(hash, fleet->rpm_iec, n * sizeof(int));
+    hash = fnv1a(hash, fleet->temp_iec, n * sizeof(double));
+    hash = fnv1a(hash, fleet->distance_km, n * sizeof(double));
+    hash = fnv1a(hash, fleet->max_speed, n * sizeof(double));
+    hash = fnv1a(hash, fleet->commands, n * sizeof(unsigned long));
+    return hash;
+}
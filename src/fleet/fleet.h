@@ -0,0 +1,79 @@
+// fleet.h
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../sim/sim.h"
+
+#define FLEET_ALIGNMENT 64 // Arrays start on a cache line
+#define FLEET_PAD 8        // Array lengths are rounded up to a multiple of this many vehicles
+#define FLEET_NO_COMMAND -1 // No command issued to an engine in the last VMU step
+
+/*
+Many vehicles stepped in lockstep, with the VehicleState fields stored as structure-of-arrays:
+field[i] belongs to vehicle i. Every vehicle runs the same VMU and engine models as the headless
+simulation (Simulation), so vehicle i of a fleet reproduces a single-vehicle run exactly.
+Padding entries past `count` hold parked vehicles and are never stepped.
+*/
+typedef struct {
+    int count;    // Number of vehicles
+    int capacity; // Allocated length of every array (count rounded up to FLEET_PAD)
+    // Pedals
+    bool *accelerator;
+    bool *brake;
+    // VMU
+    double *speed;
+    double *battery;
+    double *fuel;
+    int *power_mode;
+    double *ev_power_level;
+    double *iec_power_level;
+    bool *was_accelerating;
+    // EV
+    bool *ev_on;
+    int *rpm_ev;
+    double *temp_ev;
+    // IEC
+    bool *iec_on;
+    int *rpm_iec;
+    double *temp_iec;
+    // Command issued to each engine by the last VMU step (CommandType or FLEET_NO_COMMAND)
+    int *ev_command;
+    int *iec_command;
+    // Per-vehicle trip statistics, as in Simulation
+    double *distance_km;
+    double *max_speed;
+    unsigned long *commands;
+    // Shared simulated clock, as in Simulation
+    long vmu_period_ns;
+    long engine_period_ns;
+    unsigned long long time_ns;
+    unsigned long long next_vmu_ns;
+    unsigned long long next_engine_ns;
+    unsigned long vmu_steps;
+    unsigned long engine_steps;
+} Fleet;
+
+// Pedal script played by every vehicle of a fleet, vehicle i starting `i * stagger_ns` into it
+// and wrapping around at the end so the fleet is not driving in unison
+typedef struct {
+    const PedalScript *script;
+    unsigned long long end_ns[SIM_MAX_SEGMENTS]; // Script time at which each segment ends
+    unsigned long long length_ns;                // Script time of one full play
+    unsigned long long stagger_ns;
+} FleetScript;
+
+int fleet_init(Fleet *fleet, int count, long vmu_period_ns, long engine_period_ns);
+void fleet_free(Fleet *fleet);
+void fleet_get_vehicle(const Fleet *fleet, int i, VehicleState *vehicle);
+void fleet_put_vehicle(Fleet *fleet, int i, const VehicleState *vehicle);
+void fleet_script_init(FleetScript *fleet_script, const PedalScript *script, unsigned long long stagger_ns);
+Pedal fleet_script_pedal(const FleetScript *fleet_script, int i, unsigned long long time_ns);
+void fleet_vmu_step_range(Fleet *fleet, const FleetScript *fleet_script, int first, int last);
+void fleet_engine_step_range(Fleet *fleet, int first, int last);
+void fleet_advance(Fleet *fleet, unsigned long long duration_ns, const FleetScript *fleet_script);
+unsigned long fleet_total_commands(const Fleet *fleet);
+uint64_t fleet_checksum(const Fleet *fleet);
+
+#endif
@@ -0,0 +1,131 @@
+// fleet_control_lanes.h
+// Body of the branchless VMU control kernel, written once against a small set of vector macros and
+// included by fleet_simd.c for each instruction set. The includer defines:
+//   KERNEL(name), KERNEL_TARGET, LANES, VEC
+//   V_SET1, V_LOAD, V_STORE, V_ADD, V_SUB, V_MUL, V_DIV, V_MIN, V_MAX, V_LT, V_GT,
+//   V_AND, V_OR, V_ANDNOT (~a & b), V_SEL (m ? a : b), V_LOAD_BOOL, V_LOAD_INT, V_STORE_INT
+//
+// Every lane computes all branches of vmu_control_model() and selects the result with masks. The
+// floating point operations and their order are exactly those of the scalar code, and V_MIN/V_MAX
+// return the same value as fmin/fmax for the finite, non-negative values seen here, so the results
+// are bit-for-bit identical.
+
+KERNEL_TARGET
+void KERNEL(fleet_control)(Fleet *fleet, int first, int last) {
+    const VEC zero = V_SET1(0.0);
+    const VEC one = V_SET1(1.0);
+    const VEC tenth = V_SET1(0.1);
+    const VEC min_speed = V_SET1(MIN_SPEED);
+    const VEC increase = V_SET1(POWER_INCREASE_RATE);
+    const VEC decrease = V_SET1(POWER_DECREASE_RATE);
+    const VEC full = V_SET1(100);
+    int i = first;
+
+    for (; i + LANES <= last; i += LANES) {
+        VEC speed = V_LOAD(fleet->speed + i);
+        VEC battery = V_LOAD(fleet->battery + i);
+        VEC fuel = V_LOAD(fleet->fuel + i);
+        VEC ev_level = V_LOAD(fleet->ev_power_level + i);
+        VEC iec_level = V_LOAD(fleet->iec_power_level + i);
+        VEC accelerator = V_LOAD_BOOL(fleet->accelerator + i);
+        VEC brake = V_LOAD_BOOL(fleet->brake + i);
+        VEC ev_on = V_LOAD_BOOL(fleet->ev_on + i);
+        VEC iec_on = V_LOAD_BOOL(fleet->iec_on + i);
+
+        VEC battery_ok = V_GT(battery, V_SET1(BATTERY_CRITICAL_THRESHOLD));
+        VEC fuel_ok = V_GT(fuel, V_SET1(FUEL_CRITICAL_THRESHOLD));
+        VEC moving = V_GT(speed, min_speed);
+
+        // --- Accelerating: target power of each branch of the decision tree ---
+        VEC both_ok = V_AND(battery_ok, fuel_ok);
+        VEC iec_only = V_ANDNOT(battery_ok, fuel_ok);
+        VEC low_fuel = V_ANDNOT(fuel_ok, battery_ok);
+        VEC electric_only = V_LT(speed, V_SET1(ELECTRIC_ONLY_SPEED_THRESHOLD));
+
+        VEC ev_only_target = V_ADD(tenth, V_DIV(V_SUB(speed, min_speed), V_SET1(ELECTRIC_ONLY_SPEED_THRESHOLD - MIN_SPEED)));
+        ev_only_target = V_MIN(V_MAX(ev_only_target, zero), one);
+        VEC hybrid_iec_target = V_ADD(tenth, V_DIV(V_SUB(speed, V_SET1(ELECTRIC_ONLY_SPEED_THRESHOLD)),
+                                                   V_SET1(IEC_MAX_POWER_SPEED - ELECTRIC_ONLY_SPEED_THRESHOLD)));
+        hybrid_iec_target = V_MIN(V_MAX(hybrid_iec_target, zero), one);
+        VEC iec_only_target = V_ADD(tenth, V_DIV(speed, V_SET1(IEC_MAX_POWER_SPEED)));
+        iec_only_target = V_MIN(V_MAX(iec_only_target, zero), one);
+        VEC low_fuel_target = V_ADD(tenth, V_DIV(V_SUB(speed, min_speed), V_SET1(EV_ONLY_SPEED_LIMIT - MIN_SPEED)));
+        low_fuel_target = V_MIN(V_MAX(low_fuel_target, zero), one);
+        VEC limit_target = V_MAX(zero, V_SUB(V_SET1(0.5), V_MUL(V_SUB(speed, V_SET1(EV_ONLY_SPEED_LIMIT)), V_SET1(0.05))));
+        low_fuel_target = V_SEL(V_LT(speed, V_SET1(EV_ONLY_SPEED_LIMIT)), low_fuel_target, limit_target);
+
+        VEC target_ev = V_SEL(both_ok, V_SEL(electric_only, ev_only_target, one), V_SEL(low_fuel, low_fuel_target, zero));
+        VEC target_iec = V_SEL(both_ok, V_SEL(electric_only, zero, hybrid_iec_target), V_SEL(iec_only, iec_only_target, zero));
+        VEC accel_iec_on = V_OR(V_ANDNOT(electric_only, both_ok), iec_only);
+
+        // Ramp towards the targets
+        VEC accel_ev_level = V_SEL(V_LT(ev_level, target_ev), V_MIN(V_ADD(ev_level, increase), target_ev),
+                                   V_SEL(V_GT(ev_level, target_ev), V_MAX(V_SUB(ev_level, decrease), target_ev), ev_level));
+        VEC accel_iec_level = V_SEL(V_LT(iec_level, target_iec), V_MIN(V_ADD(iec_level, increase), target_iec),
+                                    V_SEL(V_GT(iec_level, target_iec), V_MAX(V_SUB(iec_level, decrease), target_iec), iec_level));
+
+        // --- Not accelerating: power decays, the IEC is kept on to charge a low battery ---
+        VEC coast_ev_level = V_MAX(V_SUB(ev_level, decrease), zero);
+        VEC coast_iec_level = V_MAX(V_SUB(iec_level, decrease), zero);
+        VEC charging = V_ANDNOT(brake, iec_only);
+        VEC charge_level = V_SET1(0.2);
+        coast_iec_level = V_SEL(V_AND(charging, V_LT(coast_iec_level, charge_level)),
+                                V_MIN(V_ADD(coast_iec_level, increase), charge_level), coast_iec_level);
+
+        VEC new_ev_level = V_SEL(accelerator, accel_ev_level, coast_ev_level);
+        VEC new_iec_level = V_SEL(accelerator, accel_iec_level, coast_iec_level);
+        VEC desired_ev_on = V_AND(accelerator, battery_ok);
+        VEC desired_iec_on = V_SEL(accelerator, accel_iec_on, charging);
+
+        // --- Commands: START/STOP on a state change, SET_POWER while running ---
+        VEC no_command = V_SET1(FLEET_NO_COMMAND);
+        VEC ev_command = V_SEL(ev_on, V_SEL(desired_ev_on, V_SET1(CMD_SET_POWER), V_SET1(CMD_STOP)),
+                               V_SEL(desired_ev_on, V_SET1(CMD_START), no_command));
+        VEC iec_command = V_SEL(iec_on, V_SEL(desired_iec_on, V_SET1(CMD_SET_POWER), V_SET1(CMD_STOP)),
+                                V_SEL(desired_iec_on, V_SET1(CMD_START), no_command));
+
+        // --- Battery and fuel ---
+        VEC new_battery = V_SUB(battery, V_MUL(new_ev_level, V_SET1(BATTERY_CONSUMPTION_RATE)));
+        new_battery = V_SEL(V_LT(new_battery, zero), zero, new_battery);
+        new_battery = V_SEL(V_AND(ev_on, V_GT(new_ev_level, zero)), new_battery, battery);
+
+        VEC new_fuel = V_SUB(fuel, V_MUL(new_iec_level, V_SET1(FUEL_CONSUMPTION_RATE)));
+        new_fuel = V_SEL(V_LT(new_fuel, zero), zero, new_fuel);
+        new_fuel = V_SEL(V_AND(iec_on, V_GT(new_iec_level, zero)), new_fuel, fuel);
+
+        VEC not_full = V_LT(new_battery, full);
+        VEC recharged = V_ADD(new_battery, V_SET1(IEC_RECHARGE_RATE));
+        recharged = V_SEL(V_GT(recharged, full), full, recharged);
+        new_battery = V_SEL(V_AND(V_AND(iec_on, fuel_ok), not_full), recharged, new_battery);
+
+        VEC speed_ratio = V_DIV(speed, V_SET1(MAX_SPEED));
+        VEC regen = V_SEL(brake, V_MUL(V_SET1(REGEN_BRAKE_RATE), speed_ratio), V_MUL(V_SET1(REGEN_COAST_RATE), speed_ratio));
+        VEC regenerated = V_ADD(new_battery, regen);
+        regenerated = V_SEL(V_GT(regenerated, full), full, regenerated);
+        new_battery = V_SEL(V_ANDNOT(accelerator, V_AND(moving, V_LT(new_battery, full))), regenerated, new_battery);
+
+        // --- Power mode, from the last matching rule to the first ---
+        VEC parked = V_ANDNOT(V_OR(V_OR(accelerator, brake), V_OR(desired_ev_on, desired_iec_on)),
+                              V_LT(speed, V_SET1(MIN_SPEED + 0.1)));
+        VEC mode = V_SET1(4);
+        mode = V_SEL(V_ANDNOT(desired_ev_on, desired_iec_on), V_SEL(accelerator, V_SET1(2), V_SET1(5)), mode);
+        mode = V_SEL(V_AND(desired_ev_on, desired_iec_on), V_SET1(1), mode);
+        mode = V_SEL(V_ANDNOT(desired_iec_on, desired_ev_on), V_SET1(0), mode);
+        mode = V_SEL(V_AND(brake, moving), V_SET1(3), mode);
+        mode = V_SEL(parked, V_SET1(4), mode);
+
+        V_STORE(fleet->ev_power_level + i, new_ev_level);
+        V_STORE(fleet->iec_power_level + i, new_iec_level);
+        V_STORE(fleet->battery + i, new_battery);
+        V_STORE(fleet->fuel + i, new_fuel);
+        V_STORE_INT(fleet->power_mode + i, mode);
+        V_STORE_INT(fleet->ev_command + i, ev_command);
+        V_STORE_INT(fleet->iec_command + i, iec_command);
+        for (int lane = 0; lane < LANES; lane++) {
+            fleet->was_accelerating[i + lane] = fleet->accelerator[i + lane];
+        }
+    }
+
+    // Vehicles left over at the end of the range
+    fleet_control_scalar(fleet, i, last);
+}
@@ -0,0 +1,108 @@
+// fleet_physics_lanes.h
+// Bodies of the branchless speed and engine kernels, included by fleet_simd.c for each instruction
+// set with the same vector macros as fleet_control_lanes.h.
+//
+// RPMs are integers in the scalar models. They are converted to doubles, which hold them exactly,
+// so integer additions, comparisons and (int) truncations give the same results in the lanes.
+
+// speed_model() for vehicles [first, last), storing the new speed
+KERNEL_TARGET
+void KERNEL(fleet_speed)(Fleet *fleet, int first, int last) {
+    const VEC zero = V_SET1(0.0);
+    const VEC one = V_SET1(1.0);
+    const VEC five = V_SET1(5);
+    int i = first;
+
+    for (; i + LANES <= last; i += LANES) {
+        VEC speed = V_LOAD(fleet->speed + i);
+        VEC ev_level = V_LOAD(fleet->ev_power_level + i);
+        VEC iec_level = V_LOAD(fleet->iec_power_level + i);
+        VEC accelerator = V_LOAD_BOOL(fleet->accelerator + i);
+        VEC brake = V_LOAD_BOOL(fleet->brake + i);
+        VEC ev_on = V_LOAD_BOOL(fleet->ev_on + i);
+        VEC iec_on = V_LOAD_BOOL(fleet->iec_on + i);
+
+        // Accelerating: EV contribution fading out from 60 to 70 km/h, plus the IEC
+        VEC fade_factor = V_SUB(one, V_DIV(V_SUB(speed, V_SET1(60.0)), V_SET1(10.0)));
+        VEC ev_contribution = V_SEL(V_GT(speed, V_SET1(60.0)), V_MUL(ev_level, fade_factor), V_MUL(ev_level, five));
+        ev_contribution = V_SEL(V_ANDNOT(V_GT(speed, V_SET1(70.0)), ev_on), ev_contribution, zero);
+        VEC iec_contribution = V_SEL(iec_on, V_MUL(iec_level, five), zero);
+        VEC efficiency_factor = V_SUB(one, V_MUL(V_DIV(speed, V_SET1(MAX_SPEED)), V_SET1(0.8)));
+        VEC accel_change = V_MUL(V_ADD(ev_contribution, iec_contribution), efficiency_factor);
+
+        // Not accelerating: drag, engine braking and the brake
+        VEC deceleration = V_MUL(V_SET1(0.05), V_ADD(one, V_MUL(V_DIV(speed, V_SET1(50.0)), V_SET1(0.5))));
+        VEC engine_braking = V_GT(speed, one);
+        deceleration = V_SEL(V_AND(engine_braking, ev_on), V_ADD(deceleration, V_SET1(0.2)), deceleration);
+        deceleration = V_SEL(V_AND(engine_braking, iec_on), V_ADD(deceleration, V_SET1(0.4)), deceleration);
+        VEC coast_change = V_SUB(zero, deceleration);
+        coast_change = V_SEL(V_AND(brake, V_GT(speed, V_SET1(0.001))), V_SUB(coast_change, V_SET1(10)), coast_change);
+
+        VEC speed_change = V_MUL(V_SEL(accelerator, accel_change, coast_change), V_SET1(SPEED_CHANGE_SMOOTHING));
+        VEC new_speed = V_ADD(speed, speed_change);
+        new_speed = V_SEL(V_LT(new_speed, V_SET1(MIN_SPEED)), V_SET1(MIN_SPEED), new_speed);
+        new_speed = V_SEL(V_GT(new_speed, V_SET1(MAX_SPEED)), V_SET1(MAX_SPEED), new_speed);
+        V_STORE(fleet->speed + i, new_speed);
+    }
+
+    fleet_speed_scalar(fleet, i, last);
+}
+
+// ev_engine_model() and iec_engine_model() for vehicles [first, last)
+KERNEL_TARGET
+void KERNEL(fleet_engines)(Fleet *fleet, int first, int last) {
+    const VEC ambient = V_SET1(25.0);
+    const VEC idle = V_SET1(IEC_IDLE_RPM);
+    int i = first;
+
+    for (; i + LANES <= last; i += LANES) {
+        // --- EV ---
+        VEC ev_on = V_LOAD_BOOL(fleet->ev_on + i);
+        VEC ev_level = V_LOAD(fleet->ev_power_level + i);
+        VEC rpm = V_LOAD_INT(fleet->rpm_ev + i);
+        VEC temp = V_LOAD(fleet->temp_ev + i);
+
+        VEC target = V_TRUNC(V_MUL(ev_level, V_SET1(MAX_EV_RPM)));
+        VEC ramp_up = V_MIN(V_ADD(rpm, V_SET1((int)(MAX_EV_RPM * POWER_INCREASE_RATE))), target);
+        VEC ramp_down = V_MAX(V_SUB(rpm, V_SET1((int)(MAX_EV_RPM * POWER_DECREASE_RATE * 0.5))), target);
+        VEC above = V_GT(rpm, target);
+        VEC new_rpm = V_SEL(above, ramp_down, rpm);
+        new_rpm = V_SEL(V_AND(ev_on, V_LT(rpm, target)), ramp_up, new_rpm);
+
+        VEC heated = V_ADD(temp, V_MUL(ev_level, V_SET1(EV_TEMP_INCREASE_RATE)));
+        heated = V_SEL(V_GT(heated, V_SET1(MAX_EV_TEMP)), V_SET1(MAX_EV_TEMP), heated);
+        VEC cooled = V_SUB(temp, V_SET1(EV_TEMP_DECREASE_RATE));
+        cooled = V_SEL(V_LT(cooled, ambient), ambient, cooled);
+        cooled = V_SEL(V_GT(temp, ambient), cooled, temp);
+
+        V_STORE_INT(fleet->rpm_ev + i, new_rpm);
+        V_STORE(fleet->temp_ev + i, V_SEL(ev_on, heated, cooled));
+
+        // --- IEC ---
+        VEC iec_on = V_LOAD_BOOL(fleet->iec_on + i);
+        VEC iec_level = V_LOAD(fleet->iec_power_level + i);
+        rpm = V_LOAD_INT(fleet->rpm_iec + i);
+        temp = V_LOAD(fleet->temp_iec + i);
+
+        VEC scaled = V_TRUNC(V_MUL(iec_level, V_SET1(MAX_IEC_RPM - IEC_IDLE_RPM)));
+        VEC on_target = V_ADD(idle, scaled);
+        VEC on_rpm = V_SEL(V_GT(rpm, on_target),
+                           V_MAX(V_SUB(rpm, V_SET1((int)((MAX_IEC_RPM - IEC_IDLE_RPM) * POWER_DECREASE_RATE * 0.1))), on_target), rpm);
+        on_rpm = V_SEL(V_LT(rpm, on_target),
+                       V_MIN(V_ADD(rpm, V_SET1((int)((MAX_IEC_RPM - IEC_IDLE_RPM) * POWER_INCREASE_RATE * 0.8))), on_target), on_rpm);
+        on_rpm = V_SEL(V_LT(on_rpm, idle), idle, on_rpm);
+        VEC off_rpm = V_SEL(V_GT(rpm, scaled),
+                            V_MAX(V_SUB(rpm, V_SET1((int)((MAX_IEC_RPM - IEC_IDLE_RPM) * POWER_DECREASE_RATE * 0.7))), scaled), rpm);
+
+        heated = V_ADD(temp, V_MUL(V_MUL(on_rpm, V_SET1(0.001)), V_SET1(IEC_TEMP_INCREASE_RATE)));
+        heated = V_SEL(V_GT(heated, V_SET1(MAX_IEC_TEMP)), V_SET1(MAX_IEC_TEMP), heated);
+        cooled = V_SUB(temp, V_SET1(IEC_TEMP_DECREASE_RATE));
+        cooled = V_SEL(V_LT(cooled, ambient), ambient, cooled);
+        cooled = V_SEL(V_GT(temp, ambient), cooled, temp);
+
+        V_STORE_INT(fleet->rpm_iec + i, V_SEL(iec_on, on_rpm, off_rpm));
+        V_STORE(fleet->temp_iec + i, V_SEL(iec_on, heated, cooled));
+    }
+
+    fleet_engines_scalar(fleet, i, last);
+}
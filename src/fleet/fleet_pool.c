@@ -0,0 +1,177 @@
+// Work-stealing thread pool that steps a fleet on all cores
+
+#include <stdio.h>
+#include <string.h>
+#include "fleet_pool.h"
+#include "fleet_simd.h"
+
+static uint64_t pack_range(uint32_t next, uint32_t end) {
+    return ((uint64_t)end << 32) | next;
+}
+
+// Takes the first chunk of the queue (owner). Returns 0 when the queue is empty.
+static int take_front(FleetQueue *queue, int *chunk) {
+    uint64_t range = __atomic_load_n(&queue->range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t next = (uint32_t)range, end = (uint32_t)(range >> 32);
+        if (next >= end) {
+            return 0;
+        }
+        if (__atomic_compare_exchange_n(&queue->range, &range, pack_range(next + 1, end), true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *chunk = (int)next;
+            return 1;
+        }
+    }
+}
+
+// Takes the last chunk of the queue (thief). Returns 0 when the queue is empty.
+static int take_back(FleetQueue *queue, int *chunk) {
+    uint64_t range = __atomic_load_n(&queue->range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t next = (uint32_t)range, end = (uint32_t)(range >> 32);
+        if (next >= end) {
+            return 0;
+        }
+        if (__atomic_compare_exchange_n(&queue->range, &range, pack_range(next, end - 1), true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *chunk = (int)(end - 1);
+            return 1;
+        }
+    }
+}
+
+static void run_chunk(FleetPool *pool, int chunk) {
+    Fleet *fleet = pool->fleet;
+    int first = chunk * FLEET_CHUNK;
+    int last = first + FLEET_CHUNK < fleet->count ? first + FLEET_CHUNK : fleet->count;
+
+    if (pool->phase == FLEET_PHASE_VMU) {
+        fleet_vmu_step_range(fleet, pool->fleet_script, first, last);
+    } else {
+        fleet_engine_step_range(fleet, first, last);
+    }
+}
+
+// Runs the worker's own chunks, then steals from the other workers until every queue is empty
+static void run_phase_chunks(FleetPool *pool, FleetWorker *worker) {
+    int chunk;
+
+    while (take_front(&pool->queues[worker->index], &chunk)) {
+        run_chunk(pool, chunk);
+        worker->chunks++;
+    }
+    for (int offset = 1; offset < pool->threads; offset++) {
+        FleetQueue *victim = &pool->queues[(worker->index + offset) % pool->threads];
+        while (take_back(victim, &chunk)) {
+            run_chunk(pool, chunk);
+            worker->chunks++;
+            worker->stolen++;
+        }
+    }
+}
+
+static void *fleet_worker(void *arg) {
+    FleetWorker *worker = (FleetWorker *)arg;
+    FleetPool *pool = worker->pool;
+
+    for (;;) {
+        pthread_barrier_wait(&pool->start);
+        if (pool->phase == FLEET_PHASE_EXIT) {
+            return NULL;
+        }
+        run_phase_chunks(pool, worker);
+        pthread_barrier_wait(&pool->end);
+    }
+}
+
+// Starts threads - 1 workers for `fleet`. Returns 0 on success, -1 on error. If a thread cannot be
+// created the ones already started stay parked on the start barrier and the pool must not be used
+// or destroyed; callers exit.
+int fleet_pool_init(FleetPool *pool, Fleet *fleet, int threads) {
+    memset(pool, 0, sizeof(*pool));
+    if (threads < 1 || threads > FLEET_MAX_THREADS) {
+        return -1;
+    }
+    pool->fleet = fleet;
+    pool->threads = threads;
+    pool->chunks = (fleet->count + FLEET_CHUNK - 1) / FLEET_CHUNK;
+
+    // Resolve the kernel selection before the workers can race on it
+    fleet_get_kernel();
+
+    if (pthread_barrier_init(&pool->start, NULL, threads) != 0 ||
+        pthread_barrier_init(&pool->end, NULL, threads) != 0) {
+        perror("[FLEET] Error creating barriers");
+        return -1;
+    }
+    for (int w = 0; w < threads; w++) {
+        pool->workers[w].pool = pool;
+        pool->workers[w].index = w;
+    }
+    for (int w = 1; w < threads; w++) {
+        if (pthread_create(&pool->workers[w].thread, NULL, fleet_worker, &pool->workers[w]) != 0) {
+            perror("[FLEET] Error creating worker thread");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void fleet_pool_destroy(FleetPool *pool) {
+    // Release the workers into the exit phase
+    pool->phase = FLEET_PHASE_EXIT;
+    pthread_barrier_wait(&pool->start);
+    for (int w = 1; w < pool->threads; w++) {
+        pthread_join(pool->workers[w].thread, NULL);
+    }
+    pthread_barrier_destroy(&pool->start);
+    pthread_barrier_destroy(&pool->end);
+}
+
+// Runs one phase over the whole fleet on every worker and returns when it is complete
+void fleet_pool_run_phase(FleetPool *pool, FleetPhase phase, const FleetScript *fleet_script) {
+    // Deal the chunks out in contiguous blocks so each worker starts on its own part of the arrays
+    for (int w = 0; w < pool->threads; w++) {
+        uint32_t first = (uint32_t)((long)pool->chunks * w / pool->threads);
+        uint32_t last = (uint32_t)((long)pool->chunks * (w + 1) / pool->threads);
+        __atomic_store_n(&pool->queues[w].range, pack_range(first, last), __ATOMIC_RELAXED);
+    }
+    pool->phase = phase;
+    pool->fleet_script = fleet_script;
+
+    // The barriers order the setup above before the workers read it, and every chunk of this
+    // phase before the next phase
+    pthread_barrier_wait(&pool->start);
+    run_phase_chunks(pool, &pool->workers[0]);
+    pthread_barrier_wait(&pool->end);
+}
+
+// Same as fleet_advance(), each step running as a phase on the pool
+void fleet_pool_advance(FleetPool *pool, unsigned long long duration_ns, const FleetScript *fleet_script) {
+    Fleet *fleet = pool->fleet;
+    unsigned long long end_ns = fleet->time_ns + duration_ns;
+
+    while (fleet->next_vmu_ns <= end_ns || fleet->next_engine_ns <= end_ns) {
+        if (fleet->next_engine_ns <= fleet->next_vmu_ns) {
+            fleet->time_ns = fleet->next_engine_ns;
+            fleet_pool_run_phase(pool, FLEET_PHASE_ENGINE, NULL);
+            fleet->next_engine_ns += fleet->engine_period_ns;
+            fleet->engine_steps++;
+        } else {
+            fleet->time_ns = fleet->next_vmu_ns;
+            fleet_pool_run_phase(pool, FLEET_PHASE_VMU, fleet_script);
+            fleet->next_vmu_ns += fleet->vmu_period_ns;
+            fleet->vmu_steps++;
+        }
+    }
+    fleet->time_ns = end_ns;
+}
+
+unsigned long fleet_pool_steals(const FleetPool *pool) {
+    unsigned long stolen = 0;
+    for (int w = 0; w < pool->threads; w++) {
+        stolen += pool->workers[w].stolen;
+    }
+    return stolen;
+}
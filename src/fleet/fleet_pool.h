@@ -0,0 +1,61 @@
+// fleet_pool.h
+#ifndef FLEET_POOL_H
+#define FLEET_POOL_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include "fleet.h"
+
+#define FLEET_CHUNK 1024      // Vehicles per work item, a multiple of FLEET_PAD and of the cache line
+#define FLEET_MAX_THREADS 256
+
+typedef enum {
+    FLEET_PHASE_VMU,    // Control law, speed and command delivery
+    FLEET_PHASE_ENGINE, // EV/IEC physics
+    FLEET_PHASE_EXIT    // Workers return
+} FleetPhase;
+
+// Chunks [next, end) still to run from one worker's queue, packed in one word so that the owner
+// (taking from the front) and thieves (taking from the back) claim chunks with a single CAS
+typedef struct {
+    uint64_t range;
+    char padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+} __attribute__((aligned(CACHE_LINE_SIZE))) FleetQueue;
+
+struct FleetPool;
+
+// One worker thread, on its own cache line since its counters are updated while the others run
+typedef struct {
+    struct FleetPool *pool;
+    int index;
+    pthread_t thread;
+    unsigned long chunks; // Chunks run by this worker
+    unsigned long stolen; // Of which taken from another worker's queue
+} __attribute__((aligned(CACHE_LINE_SIZE))) FleetWorker;
+
+/*
+Steps a fleet with `threads` threads, the caller being worker 0. Every step is one phase: the
+vehicles are split into chunks dealt out to per-worker queues, each worker runs its own chunks
+and then steals from the others, and a barrier ends the phase before the next one starts, so a
+control step never overlaps a physics step. Vehicles are independent within a phase, so the
+results are identical whatever the number of threads and whoever runs a chunk.
+*/
+typedef struct FleetPool {
+    Fleet *fleet;
+    int threads;
+    int chunks;
+    pthread_barrier_t start;         // Releases the workers into a phase
+    pthread_barrier_t end;           // Waits for every chunk of the phase
+    FleetPhase phase;
+    const FleetScript *fleet_script; // Pedal input of the current VMU phase
+    FleetQueue queues[FLEET_MAX_THREADS];
+    FleetWorker workers[FLEET_MAX_THREADS];
+} FleetPool;
+
+int fleet_pool_init(FleetPool *pool, Fleet *fleet, int threads);
+void fleet_pool_destroy(FleetPool *pool);
+void fleet_pool_run_phase(FleetPool *pool, FleetPhase phase, const FleetScript *fleet_script);
+void fleet_pool_advance(FleetPool *pool, unsigned long long duration_ns, const FleetScript *fleet_script);
+unsigned long fleet_pool_steals(const FleetPool *pool);
+
+#endif
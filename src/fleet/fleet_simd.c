@@ -0,0 +1,250 @@
+// Fleet kernels (VMU control law, speed and engine physics): scalar references and branchless
+// SSE2/AVX2 versions, selected at runtime from the CPU features.
+
+#include <string.h>
+#include "fleet_simd.h"
+#include "../ev/ev_model.h"
+#include "../iec/iec_model.h"
+#include "../ev/ev.h"   // EV_TEMP_* rates
+#include "../iec/iec.h" // IEC_TEMP_* rates
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FLEET_X86 1
+#else
+#define FLEET_X86 0
+#endif
+
+static FleetKernel fleet_kernel = FLEET_KERNEL_AUTO; // Resolved on first use
+
+bool fleet_kernel_supported(FleetKernel kernel) {
+    switch (kernel) {
+        case FLEET_KERNEL_SCALAR:
+        case FLEET_KERNEL_AUTO:
+            return true;
+#if FLEET_X86
+        case FLEET_KERNEL_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case FLEET_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+// Selects the kernel used by fleet_control(). FLEET_KERNEL_AUTO, or a kernel the CPU does not
+// support, selects the widest supported one. Returns the kernel in use.
+FleetKernel fleet_set_kernel(FleetKernel kernel) {
+    if (kernel == FLEET_KERNEL_AUTO || !fleet_kernel_supported(kernel)) {
+        kernel = FLEET_KERNEL_SCALAR;
+        if (fleet_kernel_supported(FLEET_KERNEL_AVX2)) {
+            kernel = FLEET_KERNEL_AVX2;
+        } else if (fleet_kernel_supported(FLEET_KERNEL_SSE2)) {
+            kernel = FLEET_KERNEL_SSE2;
+        }
+    }
+    fleet_kernel = kernel;
+    return kernel;
+}
+
+FleetKernel fleet_get_kernel(void) {
+    if (fleet_kernel == FLEET_KERNEL_AUTO) {
+        return fleet_set_kernel(FLEET_KERNEL_AUTO);
+    }
+    return fleet_kernel;
+}
+
+const char *fleet_kernel_name(FleetKernel kernel) {
+    switch (kernel) {
+        case FLEET_KERNEL_SCALAR: return "scalar";
+        case FLEET_KERNEL_SSE2: return "sse2";
+        case FLEET_KERNEL_AVX2: return "avx2";
+        default: return "auto";
+    }
+}
+
+// Parses scalar|sse2|avx2|auto. Returns 1 on success, 0 on an unknown name.
+int parse_fleet_kernel(const char *text, FleetKernel *kernel) {
+    for (int k = FLEET_KERNEL_SCALAR; k <= FLEET_KERNEL_AUTO; k++) {
+        if (strcmp(text, fleet_kernel_name((FleetKernel)k)) == 0) {
+            *kernel = (FleetKernel)k;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Calls the selected version of a kernel
+#define FLEET_DISPATCH(kernel, fleet, first, last) \
+    switch (fleet_get_kernel()) { \
+        case FLEET_KERNEL_AVX2: kernel##_avx2(fleet, first, last); break; \
+        case FLEET_KERNEL_SSE2: kernel##_sse2(fleet, first, last); break; \
+        default: kernel##_scalar(fleet, first, last); break; \
+    }
+
+void fleet_control(Fleet *fleet, int first, int last) {
+    FLEET_DISPATCH(fleet_control, fleet, first, last);
+}
+
+void fleet_speed(Fleet *fleet, int first, int last) {
+    FLEET_DISPATCH(fleet_speed, fleet, first, last);
+}
+
+void fleet_engines(Fleet *fleet, int first, int last) {
+    FLEET_DISPATCH(fleet_engines, fleet, first, last);
+}
+
+// Reference implementation: vmu_control_model() applied to each vehicle in turn
+void fleet_control_scalar(Fleet *fleet, int first, int last) {
+    for (int i = first; i < last; i++) {
+        VehicleState vehicle;
+        ControlCommands commands;
+
+        fleet_get_vehicle(fleet, i, &vehicle);
+        vmu_control_model(&vehicle, &commands);
+
+        fleet->ev_power_level[i] = vehicle.ev_power_level;
+        fleet->iec_power_level[i] = vehicle.iec_power_level;
+        fleet->was_accelerating[i] = vehicle.was_accelerating;
+        fleet->power_mode[i] = vehicle.power_mode;
+        fleet->battery[i] = vehicle.battery;
+        fleet->fuel[i] = vehicle.fuel;
+        fleet->ev_command[i] = commands.send_ev ? (int)commands.ev.type : FLEET_NO_COMMAND;
+        fleet->iec_command[i] = commands.send_iec ? (int)commands.iec.type : FLEET_NO_COMMAND;
+    }
+}
+
+// Reference implementation: speed_model() applied to each vehicle in turn
+void fleet_speed_scalar(Fleet *fleet, int first, int last) {
+    for (int i = first; i < last; i++) {
+        VehicleState vehicle;
+        fleet_get_vehicle(fleet, i, &vehicle);
+        fleet->speed[i] = speed_model(&vehicle);
+    }
+}
+
+// Reference implementation: the EV and IEC models applied to each vehicle in turn
+void fleet_engines_scalar(Fleet *fleet, int first, int last) {
+    for (int i = first; i < last; i++) {
+        ev_engine_model(fleet->ev_on[i], fleet->ev_power_level[i], &fleet->rpm_ev[i], &fleet->temp_ev[i]);
+        iec_engine_model(fleet->iec_on[i], fleet->iec_power_level[i], &fleet->rpm_iec[i], &fleet->temp_iec[i]);
+    }
+}
+
+#if FLEET_X86
+
+// --- SSE2: 2 vehicles per instruction ---
+#define KERNEL(name) name##_sse2
+#define KERNEL_TARGET __attribute__((target("sse2")))
+#define LANES 2
+#define VEC __m128d
+#define V_SET1(x) _mm_set1_pd((double)(x))
+#define V_LOAD(p) _mm_loadu_pd(p)
+#define V_STORE(p, v) _mm_storeu_pd((p), (v))
+#define V_ADD(a, b) _mm_add_pd((a), (b))
+#define V_SUB(a, b) _mm_sub_pd((a), (b))
+#define V_MUL(a, b) _mm_mul_pd((a), (b))
+#define V_DIV(a, b) _mm_div_pd((a), (b))
+#define V_MIN(a, b) _mm_min_pd((a), (b))
+#define V_MAX(a, b) _mm_max_pd((a), (b))
+#define V_LT(a, b) _mm_cmplt_pd((a), (b))
+#define V_GT(a, b) _mm_cmpgt_pd((a), (b))
+#define V_AND(a, b) _mm_and_pd((a), (b))
+#define V_OR(a, b) _mm_or_pd((a), (b))
+#define V_ANDNOT(a, b) _mm_andnot_pd((a), (b))
+#define V_SEL(m, a, b) _mm_or_pd(_mm_and_pd((m), (a)), _mm_andnot_pd((m), (b)))
+#define V_LOAD_BOOL(p) _mm_castsi128_pd(_mm_set_epi64x(-(long long)(p)[1], -(long long)(p)[0]))
+#define V_LOAD_INT(p) _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)(p)))
+#define V_STORE_INT(p, v) _mm_storel_epi64((__m128i *)(p), _mm_cvttpd_epi32(v))
+#define V_TRUNC(v) _mm_cvtepi32_pd(_mm_cvttpd_epi32(v))
+#include "fleet_control_lanes.h"
+#include "fleet_physics_lanes.h"
+#undef KERNEL
+#undef KERNEL_TARGET
+#undef LANES
+#undef VEC
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_MUL
+#undef V_DIV
+#undef V_MIN
+#undef V_MAX
+#undef V_LT
+#undef V_GT
+#undef V_AND
+#undef V_OR
+#undef V_ANDNOT
+#undef V_SEL
+#undef V_LOAD_BOOL
+#undef V_LOAD_INT
+#undef V_STORE_INT
+#undef V_TRUNC
+
+// --- AVX2: 4 vehicles per instruction ---
+// Loads the 4 bools at p as all-ones/all-zeros 64 bit lanes
+__attribute__((target("avx2")))
+static inline __m256d avx2_load_bool(const bool *p) {
+    int bytes;
+    memcpy(&bytes, p, sizeof(bytes));
+    __m256i wide = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(bytes));
+    return _mm256_castsi256_pd(_mm256_cmpgt_epi64(wide, _mm256_setzero_si256()));
+}
+
+#define KERNEL(name) name##_avx2
+#define KERNEL_TARGET __attribute__((target("avx2")))
+#define LANES 4
+#define VEC __m256d
+#define V_SET1(x) _mm256_set1_pd((double)(x))
+#define V_LOAD(p) _mm256_loadu_pd(p)
+#define V_STORE(p, v) _mm256_storeu_pd((p), (v))
+#define V_ADD(a, b) _mm256_add_pd((a), (b))
+#define V_SUB(a, b) _mm256_sub_pd((a), (b))
+#define V_MUL(a, b) _mm256_mul_pd((a), (b))
+#define V_DIV(a, b) _mm256_div_pd((a), (b))
+#define V_MIN(a, b) _mm256_min_pd((a), (b))
+#define V_MAX(a, b) _mm256_max_pd((a), (b))
+#define V_LT(a, b) _mm256_cmp_pd((a), (b), _CMP_LT_OQ)
+#define V_GT(a, b) _mm256_cmp_pd((a), (b), _CMP_GT_OQ)
+#define V_AND(a, b) _mm256_and_pd((a), (b))
+#define V_OR(a, b) _mm256_or_pd((a), (b))
+#define V_ANDNOT(a, b) _mm256_andnot_pd((a), (b))
+#define V_SEL(m, a, b) _mm256_blendv_pd((b), (a), (m))
+#define V_LOAD_BOOL(p) avx2_load_bool(p)
+#define V_LOAD_INT(p) _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(p)))
+#define V_STORE_INT(p, v) _mm_storeu_si128((__m128i *)(p), _mm256_cvttpd_epi32(v))
+#define V_TRUNC(v) _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(v))
+#include "fleet_control_lanes.h"
+#include "fleet_physics_lanes.h"
+
+#else
+
+// Without x86 vector units the scalar reference is the only kernel
+void fleet_control_sse2(Fleet *fleet, int first, int last) {
+    fleet_control_scalar(fleet, first, last);
+}
+
+void fleet_control_avx2(Fleet *fleet, int first, int last) {
+    fleet_control_scalar(fleet, first, last);
+}
+
+void fleet_speed_sse2(Fleet *fleet, int first, int last) {
+    fleet_speed_scalar(fleet, first, last);
+}
+
+void fleet_speed_avx2(Fleet *fleet, int first, int last) {
+    fleet_speed_scalar(fleet, first, last);
+}
+
+void fleet_engines_sse2(Fleet *fleet, int first, int last) {
+    fleet_engines_scalar(fleet, first, last);
+}
+
+void fleet_engines_avx2(Fleet *fleet, int first, int last) {
+    fleet_engines_scalar(fleet, first, last);
+}
+
+#endif
@@ -0,0 +1,42 @@
+// fleet_simd.h
+#ifndef FLEET_SIMD_H
+#define FLEET_SIMD_H
+
+#include "fleet.h"
+
+// Vectorized fleet kernels over the structure-of-arrays state. Each kernel has a scalar reference built on the single-vehicle models
+// and branchless SSE2 (2 vehicles per instruction) and AVX2 (4 vehicles per instruction) versions
+// that produce bit-for-bit the same results. The best one supported by the CPU is used by default.
+typedef enum {
+    FLEET_KERNEL_SCALAR,
+    FLEET_KERNEL_SSE2,
+    FLEET_KERNEL_AVX2,
+    FLEET_KERNEL_AUTO
+} FleetKernel;
+
+bool fleet_kernel_supported(FleetKernel kernel);
+FleetKernel fleet_set_kernel(FleetKernel kernel);
+FleetKernel fleet_get_kernel(void);
+const char *fleet_kernel_name(FleetKernel kernel);
+int parse_fleet_kernel(const char *text, FleetKernel *kernel);
+
+// VMU control law of vehicles [first, last): updates the commanded power levels, mode, battery
+// and fuel and stores the command decided for each engine in ev_command/iec_command
+void fleet_control(Fleet *fleet, int first, int last);
+void fleet_control_scalar(Fleet *fleet, int first, int last);
+void fleet_control_sse2(Fleet *fleet, int first, int last);
+void fleet_control_avx2(Fleet *fleet, int first, int last);
+
+// speed_model() for vehicles [first, last), storing the new speed
+void fleet_speed(Fleet *fleet, int first, int last);
+void fleet_speed_scalar(Fleet *fleet, int first, int last);
+void fleet_speed_sse2(Fleet *fleet, int first, int last);
+void fleet_speed_avx2(Fleet *fleet, int first, int last);
+
+// One physics step of both engines of vehicles [first, last): RPM and temperature
+void fleet_engines(Fleet *fleet, int first, int last);
+void fleet_engines_scalar(Fleet *fleet, int first, int last);
+void fleet_engines_sse2(Fleet *fleet, int first, int last);
+void fleet_engines_avx2(Fleet *fleet, int first, int last);
+
+#endif
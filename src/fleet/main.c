@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include "fleet.c"
+#include "fleet_simd.h"
+#include "fleet_pool.h"
+#include "../common/clock.h"
+
+#define DEFAULT_SCRIPT "1:60,0:30,2:10" // Same default drive as bin/sim
+#define DEFAULT_VEHICLES 10000
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--vehicles=N] [--script=SPEC] [--repeat=N] [--stagger=SECONDS] [--vmu-period=MS] [--engine-period=MS] [--kernel=NAME] [--threads=N] [--bench]\n", program);
+    fprintf(stderr, "  --vehicles=N        Number of vehicles (default %d)\n", DEFAULT_VEHICLES);
+    fprintf(stderr, "  --script=SPEC       Comma separated PEDAL:SECONDS segments, PEDAL 0=release 1=accelerate 2=brake (default %s)\n", DEFAULT_SCRIPT);
+    fprintf(stderr, "  --repeat=N          Play the script N times (default 1)\n");
+    fprintf(stderr, "  --stagger=SECONDS   Vehicle i starts i*SECONDS into the script (default 0)\n");
+    fprintf(stderr, "  --vmu-period=MS     Simulated VMU control period (default 200)\n");
+    fprintf(stderr, "  --engine-period=MS  Simulated EV/IEC physics period (default 70)\n");
+    fprintf(stderr, "  --kernel=NAME       Vector kernels: scalar, sse2, avx2 or auto (default auto, best supported)\n");
+    fprintf(stderr, "  --threads=N         Worker threads, 0 for one per online CPU (default 1)\n");
+    fprintf(stderr, "  --bench             Run with 1, 2, 4... up to --threads threads (default one per CPU) and report the scaling\n");
+}
+
+// Parses a period in milliseconds into nanoseconds, 0 if invalid
+static long parse_period(const char *text) {
+    char *end;
+    double period_ms = strtod(text, &end);
+    if (*end != '\0' || !(period_ms > 0.0 && period_ms <= 10000.0)) {
+        return 0;
+    }
+    return (long)(period_ms * 1000000.0);
+}
+
+// Runs the script `repeat` times on a new fleet with `threads` threads. Returns the wall time in
+// seconds, or a negative value on error; the final fleet is left in `fleet` for the caller to free.
+static double run_fleet(Fleet *fleet, int vehicles, long vmu_period_ns, long engine_period_ns,
+                        const FleetScript *fleet_script, int repeat, int threads, unsigned long *steals) {
+    if (fleet_init(fleet, vehicles, vmu_period_ns, engine_period_ns) != 0) {
+        fprintf(stderr, "[FLEET] Not enough memory for %d vehicles\n", vehicles);
+        return -1.0;
+    }
+    unsigned long long duration_ns = fleet_script->length_ns * (unsigned long long)repeat;
+    unsigned long long wall_start;
+
+    if (threads == 1) {
+        wall_start = monotonic_ns();
+        fleet_advance(fleet, duration_ns, fleet_script);
+        *steals = 0;
+    } else {
+        static FleetPool pool;
+        if (fleet_pool_init(&pool, fleet, threads) != 0) {
+            return -1.0;
+        }
+        wall_start = monotonic_ns();
+        fleet_pool_advance(&pool, duration_ns, fleet_script);
+        *steals = fleet_pool_steals(&pool);
+        fleet_pool_destroy(&pool);
+    }
+    return (monotonic_ns() - wall_start) / 1e9;
+}
+
+// Steps per second with 1, 2, 4... threads, checking that every run ends in the same state
+static void run_bench(int vehicles, long vmu_period_ns, long engine_period_ns,
+                      const FleetScript *fleet_script, int repeat, int max_threads) {
+    Fleet fleet;
+    double base_wall = 0.0;
+    uint64_t base_checksum = 0;
+
+    printf("%8s %10s %16s %8s %11s %8s %10s\n", "threads", "wall_s", "vehicle-steps/s", "speedup", "efficiency", "steals", "identical");
+    int threads = 1;
+    for (;;) {
+        unsigned long steals;
+        double wall_s = run_fleet(&fleet, vehicles, vmu_period_ns, engine_period_ns, fleet_script, repeat, threads, &steals);
+        if (wall_s < 0.0) {
+            exit(EXIT_FAILURE);
+        }
+        double vehicle_steps = (double)(fleet.vmu_steps + fleet.engine_steps) * fleet.count;
+        uint64_t checksum = fleet_checksum(&fleet);
+        if (threads == 1) {
+            base_wall = wall_s;
+            base_checksum = checksum;
+        }
+        double speedup = wall_s > 0.0 ? base_wall / wall_s : 0.0;
+        printf("%8d %10.3f %16.0f %8.2f %10.0f%% %8lu %10s\n", threads, wall_s,
+               wall_s > 0.0 ? vehicle_steps / wall_s : 0.0, speedup, 100.0 * speedup / threads, steals,
+               checksum == base_checksum ? "yes" : "NO");
+        fleet_free(&fleet);
+        if (threads >= max_threads) {
+            break;
+        }
+        threads = threads * 2 < max_threads ? threads * 2 : max_threads;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"vehicles", required_argument, NULL, 'n'},
+        {"script", required_argument, NULL, 's'},
+        {"repeat", required_argument, NULL, 'r'},
+        {"stagger", required_argument, NULL, 'g'},
+        {"vmu-period", required_argument, NULL, 'v'},
+        {"engine-period", required_argument, NULL, 'e'},
+        {"kernel", required_argument, NULL, 'k'},
+        {"threads", required_argument, NULL, 'j'},
+        {"bench", no_argument, NULL, 'b'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    const char *script_text = DEFAULT_SCRIPT;
+    long vmu_period_ns = VMU_PERIOD_NS;
+    long engine_period_ns = ENGINE_PERIOD_NS;
+    int vehicles = DEFAULT_VEHICLES;
+    int repeat = 1;
+    double stagger_s = 0.0;
+    FleetKernel kernel = FLEET_KERNEL_AUTO;
+    int threads = -1; // Not given
+    bool bench = false;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:s:r:g:v:e:k:j:bh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'n':
+                vehicles = atoi(optarg);
+                break;
+            case 's':
+                script_text = optarg;
+                break;
+            case 'r':
+                repeat = atoi(optarg);
+                break;
+            case 'g':
+                stagger_s = atof(optarg);
+                break;
+            case 'v':
+                vmu_period_ns = parse_period(optarg);
+                break;
+            case 'e':
+                engine_period_ns = parse_period(optarg);
+                break;
+            case 'k':
+                if (!parse_fleet_kernel(optarg, &kernel)) {
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'j':
+                threads = atoi(optarg);
+                if (threads < 0) {
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'b':
+                bench = true;
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    PedalScript script;
+    if (!parse_pedal_script(script_text, &script) || vehicles < 1 || repeat < 1 || stagger_s < 0.0 ||
+        vmu_period_ns == 0 || engine_period_ns == 0 || threads > FLEET_MAX_THREADS) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    FleetKernel selected = fleet_set_kernel(kernel);
+    if (kernel != FLEET_KERNEL_AUTO && selected != kernel) {
+        fprintf(stderr, "[FLEET] %s kernels not supported by this CPU, using %s\n",
+                fleet_kernel_name(kernel), fleet_kernel_name(selected));
+    }
+
+    if (threads < 0) {
+        threads = bench ? 0 : 1;
+    }
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus < 1 ? 1 : cpus > FLEET_MAX_THREADS ? FLEET_MAX_THREADS : (int)cpus;
+    }
+    FleetScript fleet_script;
+    fleet_script_init(&fleet_script, &script, (unsigned long long)(stagger_s * 1e9 + 0.5));
+
+    if (bench) {
+        printf("Fleet scaling: %d vehicles, %.1f s simulated, %s kernels\n", vehicles,
+               fleet_script.length_ns * (double)repeat / 1e9, fleet_kernel_name(selected));
+        run_bench(vehicles, vmu_period_ns, engine_period_ns, &fleet_script, repeat, threads);
+        return 0;
+    }
+
+    Fleet fleet;
+    unsigned long steals;
+    double wall_s = run_fleet(&fleet, vehicles, vmu_period_ns, engine_period_ns, &fleet_script, repeat, threads, &steals);
+    if (wall_s < 0.0) {
+        exit(EXIT_FAILURE);
+    }
+
+    double distance = 0.0, battery = 0.0, fuel = 0.0;
+    for (int i = 0; i < fleet.count; i++) {
+        distance += fleet.distance_km[i];
+        battery += fleet.battery[i];
+        fuel += fleet.fuel[i];
+    }
+
+    double sim_s = fleet.time_ns / 1e9;
+    double vehicle_steps = (double)(fleet.vmu_steps + fleet.engine_steps) * fleet.count;
+    printf("Simulated %d vehicles for %.1f s (%lu VMU steps, %lu engine steps, %lu commands) in %.3f s wall\n",
+           fleet.count, sim_s, fleet.vmu_steps, fleet.engine_steps, fleet_total_commands(&fleet), wall_s);
+    printf("Throughput (%s kernels, %d threads): %.0f vehicle-steps/s, %.0f ns per vehicle-step\n",
+           fleet_kernel_name(selected), threads, wall_s > 0.0 ? vehicle_steps / wall_s : 0.0, vehicle_steps > 0.0 ? wall_s * 1e9 / vehicle_steps : 0.0);
+    printf("Fleet distance: %.3f km, mean final battery: %.2f%%, mean final fuel: %.2f%%\n",
+           distance, battery / fleet.count, fuel / fleet.count);
+
+    fleet_free(&fleet);
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Combustion engine model shared by the IEC module and the headless simulation
+
+#include "iec_model.h"
+#include "iec.h"
+
+// Advances the engine by one physics step: RPM follows the commanded power level above idle and
+// the temperature rises with RPM while running and cools down towards ambient while off
+void iec_engine_model(bool iec_on, double iec_power_level, int *rpm_iec, double *temp_iec) {
+    int current_rpm = *rpm_iec;
+    double current_temp = *temp_iec;
+    int new_rpm = current_rpm;
+    double new_temp = current_temp;
+    
+    if (iec_on) {
+
+        int target_rpm = IEC_IDLE_RPM + (int)(iec_power_level * (MAX_IEC_RPM - IEC_IDLE_RPM));
+        
+        // Smoothly transition RPM
+        if (current_rpm < target_rpm) {
+            new_rpm += (int)((MAX_IEC_RPM - IEC_IDLE_RPM) * POWER_INCREASE_RATE * 0.8);
+            if (new_rpm > target_rpm) new_rpm = target_rpm;
+        } else if (current_rpm > target_rpm) {
+            new_rpm -= (int)((MAX_IEC_RPM - IEC_IDLE_RPM) * POWER_DECREASE_RATE * 0.1);
+            if (new_rpm < target_rpm) new_rpm = target_rpm;
+        }
+        
+        // Ensure RPM does not drop below idle when engine is on
+        if (new_rpm < IEC_IDLE_RPM) {
+            new_rpm = IEC_IDLE_RPM;
+        }
+        
+        // Increase temperature based on RPM
+        new_temp += new_rpm * 0.001 * IEC_TEMP_INCREASE_RATE;
+        if (new_temp > MAX_IEC_TEMP) new_temp = MAX_IEC_TEMP;
+    } else {
+        int target_rpm = (int)(iec_power_level * (MAX_IEC_RPM - IEC_IDLE_RPM));
+        
+        // Smoothly transition RPM
+        if (current_rpm > target_rpm) {
+            new_rpm -= (int)((MAX_IEC_RPM - IEC_IDLE_RPM) * POWER_DECREASE_RATE * 0.7);
+            if (new_rpm < target_rpm) new_rpm = target_rpm;
+        }
+        
+        // Cool down the engine if it's above ambient temperature
+        if (current_temp > 25.0) {
+            new_temp -= IEC_TEMP_DECREASE_RATE;
+            if (new_temp < 25.0) new_temp = 25.0;
+        }
+    }
+
+    *rpm_iec = new_rpm;
+    *temp_iec = new_temp;
+}
+
+// Applies the on/off effect of a command. SET_POWER and END do not change the engine state.
+void iec_apply_command(CommandType type, bool *iec_on, int *rpm_iec) {
+    if (type == CMD_START) {
+        *iec_on = true;
+        // When starting, immediately set RPM to idle to simulate engine turning over
+        *rpm_iec = IEC_IDLE_RPM;
+    } else if (type == CMD_STOP) {
+        *iec_on = false;
+        // RPM reduction handled by iec_engine_model()
+    }
+}
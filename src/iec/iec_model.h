@@ -0,0 +1,11 @@
+// iec_model.h
+#ifndef IEC_MODEL_H
+#define IEC_MODEL_H
+
+#include <stdbool.h>
+#include "../vmu/vmu.h"
+
+void iec_engine_model(bool iec_on, double iec_power_level, int *rpm_iec, double *temp_iec);
+void iec_apply_command(CommandType type, bool *iec_on, int *rpm_iec);
+
+#endif
@@ -2,26 +2,43 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include "iec.c"
+#include "../common/options.h"
+#include "../common/histogram.h"
+#include "../common/rt.h"
+
+int main(int argc, char *argv[]) {
+    RuntimeOptions options;
+    if (!parse_runtime_options(argc, argv, &options)) {
+        exit(EXIT_FAILURE);
+    }
+    command_transport = options.transport;
+    power_mailbox = options.power_mailbox;
 
-int main() {
     system("clear");
+    rt_enter(&options.rt, "IEC"); // Pinning and memory locking before the segments are mapped
     // Initialize communication with VMU
     if(init_communication_iec(SHARED_MEM_NAME, SEMAPHORE_NAME, IEC_COMMAND_QUEUE_NAME) == 0){
         exit(EXIT_FAILURE);
     }
-    // Main loop of the IEC module
-    while (running) {
-        if (!paused) {
-            
-            receive_cmd(); // Receive commands from the VMU
-            engine(); // Call the engine function to update the engine state
-
-            usleep(70000); // Small delay for the IEC loop
-        } else {
-            sleep(1); // Sleep for 1 second if paused
+    if (options.stats && stats_open(IEC_STATS_NAME, "iec") == NULL) {
+        perror("[IEC] Error creating statistics segment");
+    }
+    if (options.rt.enabled) {
+        // Everything the loop touches is resident before the first step
+        rt_prefault(system_state, sizeof(SystemState));
+        if (iec_transport.rings[TRANSPORT_IEC] != NULL) rt_prefault(iec_transport.rings[TRANSPORT_IEC], sizeof(CommandRing));
+        if (rt_thread_enter(options.rt.loop_priority) != 0) {
+            perror("[IEC] Error setting main loop priority");
         }
     }
+    // Main loop of the IEC module: physics runs on absolute deadlines, commands are
+    // handled as soon as they arrive instead of waiting for the next step
+    iec_loop.period_ns = options.period_ns ? options.period_ns : ENGINE_PERIOD_NS;
+    iec_loop.tick_policy = options.tick_policy;
+    engine_loop_run(&iec_loop);
+    engine_loop_report(&iec_loop);
+    stats_close(IEC_STATS_NAME);
 
-    
+    cleanup(); // Cleanup resources before exiting
     return 0;
 }
\ No newline at end of file
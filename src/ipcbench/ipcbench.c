@@ -0,0 +1,308 @@
+// Microbenchmark of the ways the VMU could deliver EngineCommand messages to the engine modules
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "ipcbench.h"
+
+static const char *transport_names[IPC_TRANSPORT_COUNT] = {
+    "mq", "pipe", "dgram", "eventfd-ring", "futex-ring",
+};
+
+const char *ipc_transport_name(IpcTransport transport) {
+    return transport_names[transport];
+}
+
+// Returns 1 and sets `transport` if `text` names one, 0 otherwise
+int parse_ipc_transport(const char *text, IpcTransport *transport) {
+    for (int t = 0; t < IPC_TRANSPORT_COUNT; t++) {
+        if (strcmp(text, transport_names[t]) == 0) {
+            *transport = (IpcTransport)t;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Opens one direction of `transport`. Returns 0 on success, -1 on error with errno set.
+int ipc_path_open(IpcPath *path, IpcTransport transport) {
+    static int queues = 0;
+
+    memset(path, 0, sizeof(*path));
+    path->transport = transport;
+    path->mq = (mqd_t)-1;
+    path->fds[0] = path->fds[1] = -1;
+
+    switch (transport) {
+        case IPC_MQ: {
+            // Same attributes as the command queues of init_communication()
+            struct mq_attr attributes = {0};
+            attributes.mq_maxmsg = IPC_MQ_MAXMSG;
+            attributes.mq_msgsize = sizeof(EngineCommand);
+            char name[64];
+            snprintf(name, sizeof(name), "/ipcbench_%d_%d", (int)getpid(), queues++);
+            path->mq = mq_open(name, O_RDWR | O_CREAT | O_EXCL, 0600, &attributes);
+            if (path->mq == (mqd_t)-1) {
+                return -1;
+            }
+            mq_unlink(name); // The descriptor is inherited across fork(); nothing is left behind
+            return 0;
+        }
+        case IPC_PIPE:
+            return pipe(path->fds);
+        case IPC_DGRAM:
+            return socketpair(AF_UNIX, SOCK_DGRAM, 0, path->fds);
+        case IPC_EVENTFD_RING:
+        case IPC_FUTEX_RING:
+            path->ring = mmap(NULL, sizeof(IpcRing), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (path->ring == MAP_FAILED) {
+                path->ring = NULL;
+                return -1;
+            }
+            if (transport == IPC_EVENTFD_RING && (path->fds[0] = eventfd(0, 0)) == -1) {
+                ipc_path_close(path);
+                return -1;
+            }
+            return 0;
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+}
+
+void ipc_path_close(IpcPath *path) {
+    if (path->mq != (mqd_t)-1) {
+        mq_close(path->mq);
+    }
+    for (int i = 0; i < 2; i++) {
+        if (path->fds[i] != -1) {
+            close(path->fds[i]);
+        }
+    }
+    if (path->ring != NULL) {
+        munmap(path->ring, sizeof(IpcRing));
+    }
+    memset(path, 0, sizeof(*path));
+    path->mq = (mqd_t)-1;
+    path->fds[0] = path->fds[1] = -1;
+}
+
+// Sends `cmd`, blocking while the transport is full. Returns 0 on success, -1 on error.
+int ipc_send(IpcPath *path, const EngineCommand *cmd) {
+    ssize_t sent;
+
+    switch (path->transport) {
+        case IPC_MQ:
+            while (mq_send(path->mq, (const char *)cmd, sizeof(*cmd), 0) == -1) {
+                if (errno != EINTR) return -1;
+            }
+            return 0;
+        case IPC_PIPE:
+        case IPC_DGRAM:
+            // Smaller than PIPE_BUF, so a pipe write is atomic as a datagram is
+            while ((sent = write(path->fds[1], cmd, sizeof(*cmd))) == -1 && errno == EINTR) {
+            }
+            return sent == sizeof(*cmd) ? 0 : -1;
+        case IPC_EVENTFD_RING:
+            while (cmd_ring_push(&path->ring->ring, cmd) == -1) {
+                sched_yield();
+            }
+            // The fence in cmd_ring_push() orders the new head before this load, pairing with
+            // the consumer raising its flag before checking the ring again
+            if (__atomic_load_n(&path->ring->eventfd_sleeping, __ATOMIC_RELAXED)) {
+                uint64_t one = 1;
+                if (write(path->fds[0], &one, sizeof(one)) != sizeof(one)) return -1;
+            }
+            return 0;
+        case IPC_FUTEX_RING:
+            while (cmd_ring_push(&path->ring->ring, cmd) == -1) {
+                sched_yield();
+            }
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+// Receives the next command, blocking until one arrives. Returns 0 on success, -1 on error.
+int ipc_receive(IpcPath *path, EngineCommand *cmd) {
+    ssize_t received;
+
+    switch (path->transport) {
+        case IPC_MQ:
+            while (mq_receive(path->mq, (char *)cmd, sizeof(*cmd), NULL) == -1) {
+                if (errno != EINTR) return -1;
+            }
+            return 0;
+        case IPC_PIPE:
+        case IPC_DGRAM:
+            while ((received = read(path->fds[0], cmd, sizeof(*cmd))) == -1 && errno == EINTR) {
+            }
+            return received == sizeof(*cmd) ? 0 : -1;
+        case IPC_EVENTFD_RING: {
+            IpcRing *ring = path->ring;
+            while (cmd_ring_pop(&ring->ring, cmd) == -1) {
+                // Same handshake as cmd_ring_wait(), with the eventfd counter as the doorbell:
+                // a wake-up written before we block is kept in the counter and not lost
+                __atomic_store_n(&ring->eventfd_sleeping, 1, __ATOMIC_RELAXED);
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                if (!cmd_ring_pending(&ring->ring)) {
+                    uint64_t count;
+                    if (read(path->fds[0], &count, sizeof(count)) == -1 && errno != EINTR) return -1;
+                }
+                __atomic_store_n(&ring->eventfd_sleeping, 0, __ATOMIC_RELAXED);
+            }
+            return 0;
+        }
+        case IPC_FUTEX_RING:
+            while (cmd_ring_pop(&path->ring->ring, cmd) == -1) {
+                cmd_ring_wait(&path->ring->ring, NULL);
+            }
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+// User plus system CPU time in nanoseconds of this process (RUSAGE_SELF) or of its waited-for
+// children (RUSAGE_CHILDREN)
+static unsigned long long cpu_ns(int who) {
+    struct rusage usage;
+    getrusage(who, &usage);
+    return (unsigned long long)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * NSEC_PER_SEC +
+           (unsigned long long)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ULL;
+}
+
+// Waits for the child and returns 0 if it exited cleanly
+static int reap(pid_t child) {
+    int status;
+    while (waitpid(child, &status, 0) == -1) {
+        if (errno != EINTR) return -1;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+// Round trips of one command to a child that echoes it back. Returns 0 on success, -1 on error.
+int ipc_bench_round_trip(IpcTransport transport, int count, IpcResult *result) {
+    IpcPath ping, pong;
+    EngineCommand cmd = { .type = CMD_SET_POWER, .power_level = 0.5 };
+
+    if (ipc_path_open(&ping, transport) != 0) {
+        return -1;
+    }
+    if (ipc_path_open(&pong, transport) != 0) {
+        ipc_path_close(&ping);
+        return -1;
+    }
+
+    unsigned long long cpu_start = cpu_ns(RUSAGE_SELF) + cpu_ns(RUSAGE_CHILDREN);
+    pid_t child = fork();
+    if (child == 0) {
+        // Engine side: echo every command until CMD_END
+        while (ipc_receive(&ping, &cmd) == 0 && cmd.type != CMD_END) {
+            if (ipc_send(&pong, &cmd) != 0) _exit(EXIT_FAILURE);
+        }
+        _exit(cmd.type == CMD_END ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    if (child == -1) {
+        ipc_path_close(&ping);
+        ipc_path_close(&pong);
+        return -1;
+    }
+
+    memset(&result->rtt, 0, sizeof(result->rtt));
+    int error = 0;
+    for (int i = 0; i < IPC_WARMUP + count && !error; i++) {
+        cmd.seq = (unsigned int)i + 1;
+        cmd.sent_ns = monotonic_ns();
+        EngineCommand reply;
+        error = ipc_send(&ping, &cmd) != 0 || ipc_receive(&pong, &reply) != 0 || reply.seq != cmd.seq;
+        if (i >= IPC_WARMUP) {
+            hist_add(&result->rtt, monotonic_ns() - cmd.sent_ns);
+        }
+    }
+    cmd.type = CMD_END;
+    if (ipc_send(&ping, &cmd) != 0) {
+        kill(child, SIGKILL);
+        error = 1;
+    }
+    error |= reap(child) != 0;
+    unsigned long long cpu = cpu_ns(RUSAGE_SELF) + cpu_ns(RUSAGE_CHILDREN) - cpu_start;
+
+    ipc_path_close(&ping);
+    ipc_path_close(&pong);
+    result->transport = transport;
+    result->round_trips = count;
+    result->rtt_cpu_ns = (double)cpu / (IPC_WARMUP + count);
+    return error ? -1 : 0;
+}
+
+// One-way stream of `count` commands to a child that acknowledges the total at the end.
+// Returns 0 on success, -1 on error.
+int ipc_bench_stream(IpcTransport transport, int count, IpcResult *result) {
+    IpcPath data, ack;
+    EngineCommand cmd = { .type = CMD_SET_POWER, .power_level = 0.5 };
+
+    if (ipc_path_open(&data, transport) != 0) {
+        return -1;
+    }
+    if (ipc_path_open(&ack, transport) != 0) {
+        ipc_path_close(&data);
+        return -1;
+    }
+
+    unsigned long long cpu_start = cpu_ns(RUSAGE_SELF) + cpu_ns(RUSAGE_CHILDREN);
+    pid_t child = fork();
+    if (child == 0) {
+        // Engine side: count commands until CMD_END, then report how many arrived
+        unsigned int received = 0;
+        while (ipc_receive(&data, &cmd) == 0 && cmd.type != CMD_END) {
+            received++;
+        }
+        cmd.seq = received;
+        _exit(cmd.type == CMD_END && ipc_send(&ack, &cmd) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    if (child == -1) {
+        ipc_path_close(&data);
+        ipc_path_close(&ack);
+        return -1;
+    }
+
+    int error = 0;
+    unsigned long long start = monotonic_ns();
+    for (int i = 0; i < count && !error; i++) {
+        cmd.seq = (unsigned int)i + 1;
+        cmd.sent_ns = monotonic_ns();
+        error = ipc_send(&data, &cmd) != 0;
+    }
+    cmd.type = CMD_END;
+    EngineCommand reply;
+    if (error || ipc_send(&data, &cmd) != 0 || ipc_receive(&ack, &reply) != 0) {
+        kill(child, SIGKILL);
+        error = 1;
+    } else {
+        error = reply.seq != (unsigned int)count;
+    }
+    double wall_s = (monotonic_ns() - start) / 1e9;
+    error |= reap(child) != 0;
+    unsigned long long cpu = cpu_ns(RUSAGE_SELF) + cpu_ns(RUSAGE_CHILDREN) - cpu_start;
+
+    ipc_path_close(&data);
+    ipc_path_close(&ack);
+    result->transport = transport;
+    result->messages = count;
+    result->messages_per_s = wall_s > 0.0 ? count / wall_s : 0.0;
+    result->stream_cpu_ns = (double)cpu / count;
+    return error ? -1 : 0;
+}
@@ -0,0 +1,61 @@
+// ipcbench.h
+#ifndef IPCBENCH_H
+#define IPCBENCH_H
+
+#include <mqueue.h>
+#include "../common/cmd_ring.h"
+#include "../common/histogram.h"
+
+#define IPC_MQ_MAXMSG 10 // Queue depth used by init_communication()
+#define IPC_WARMUP 1000  // Round trips run before the measured ones
+
+// Ways of delivering an EngineCommand between two processes
+typedef enum {
+    IPC_MQ,           // POSIX message queue with the attributes of init_communication()
+    IPC_PIPE,         // Anonymous pipe, one EngineCommand per write()
+    IPC_DGRAM,        // UNIX datagram socket pair
+    IPC_EVENTFD_RING, // CommandRing in shared memory, sleeping consumer woken through an eventfd
+    IPC_FUTEX_RING,   // CommandRing in shared memory with its own futex doorbell (TRANSPORT_RING)
+    IPC_TRANSPORT_COUNT
+} IpcTransport;
+
+// Command ring plus the flag an eventfd consumer raises before blocking
+typedef struct {
+    CommandRing ring;
+    _Alignas(CACHE_LINE_SIZE) unsigned int eventfd_sleeping;
+} IpcRing;
+
+/*
+One direction of a channel, opened before fork() so both processes inherit it. Sends and
+receives block: a full queue applies back-pressure instead of dropping the command.
+The rings have no wait for free space, so a producer finding one full yields the CPU and retries.
+*/
+typedef struct {
+    IpcTransport transport;
+    mqd_t mq;
+    int fds[2];    // Pipe or socket pair: [0] receives, [1] sends. Eventfd: fds[0]
+    IpcRing *ring; // Shared anonymous mapping for the ring transports
+} IpcPath;
+
+typedef struct {
+    IpcTransport transport;
+    // Round trips: command to the echoing child and back
+    int round_trips;
+    LatencyHistogram rtt;
+    double rtt_cpu_ns;        // CPU time of both processes per round trip
+    // One-way stream of commands
+    int messages;
+    double messages_per_s;
+    double stream_cpu_ns;     // CPU time of both processes per message
+} IpcResult;
+
+const char *ipc_transport_name(IpcTransport transport);
+int parse_ipc_transport(const char *text, IpcTransport *transport);
+int ipc_path_open(IpcPath *path, IpcTransport transport);
+void ipc_path_close(IpcPath *path);
+int ipc_send(IpcPath *path, const EngineCommand *cmd);
+int ipc_receive(IpcPath *path, EngineCommand *cmd);
+int ipc_bench_round_trip(IpcTransport transport, int count, IpcResult *result);
+int ipc_bench_stream(IpcTransport transport, int count, IpcResult *result);
+
+#endif
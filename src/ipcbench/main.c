@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "ipcbench.c"
+
+#define DEFAULT_ROUND_TRIPS 100000
+#define DEFAULT_MESSAGES 200000
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--transport=NAME] [--round-trips=N] [--messages=N]\n", program);
+    fprintf(stderr, "  --transport=NAME  mq, pipe, dgram, eventfd-ring or futex-ring (default all)\n");
+    fprintf(stderr, "  --round-trips=N   Measured command round trips per transport (default %d)\n", DEFAULT_ROUND_TRIPS);
+    fprintf(stderr, "  --messages=N      Commands in the one-way throughput stream (default %d)\n", DEFAULT_MESSAGES);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"transport", required_argument, NULL, 't'},
+        {"round-trips", required_argument, NULL, 'r'},
+        {"messages", required_argument, NULL, 'm'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    IpcTransport only = IPC_TRANSPORT_COUNT; // All
+    int round_trips = DEFAULT_ROUND_TRIPS;
+    int messages = DEFAULT_MESSAGES;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "t:r:m:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 't':
+                if (!parse_ipc_transport(optarg, &only)) {
+                    fprintf(stderr, "Unknown transport '%s'\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'r':
+                round_trips = atoi(optarg);
+                break;
+            case 'm':
+                messages = atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (round_trips < 1 || messages < 1) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("EngineCommand delivery: %zu-byte messages, mq depth %d, ring capacity %d, %ld CPUs online\n",
+           sizeof(EngineCommand), IPC_MQ_MAXMSG, CMD_RING_CAPACITY, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-13s %9s %9s %9s %9s %9s %9s %10s %12s %10s\n", "transport", "rtt_mean", "rtt_p50", "rtt_p90",
+           "rtt_p99", "rtt_p99.9", "rtt_max", "cpu/rtt", "msgs/s", "cpu/msg");
+    printf("%-13s %9s %9s %9s %9s %9s %9s %10s %12s %10s\n", "", "us", "us", "us", "us", "us", "us", "ns", "", "ns");
+
+    int status = EXIT_SUCCESS;
+    for (int t = 0; t < IPC_TRANSPORT_COUNT; t++) {
+        if (only != IPC_TRANSPORT_COUNT && t != (int)only) {
+            continue;
+        }
+        IpcResult result;
+        if (ipc_bench_round_trip((IpcTransport)t, round_trips, &result) != 0 ||
+            ipc_bench_stream((IpcTransport)t, messages, &result) != 0) {
+            fprintf(stderr, "[IPCBENCH] %s: ", ipc_transport_name((IpcTransport)t));
+            perror("benchmark failed");
+            status = EXIT_FAILURE;
+            continue;
+        }
+        const LatencyHistogram *rtt = &result.rtt;
+        printf("%-13s %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %10.0f %12.0f %10.0f\n", ipc_transport_name((IpcTransport)t),
+               rtt->sum_ns / 1e3 / rtt->count, hist_percentile(rtt, 50.0) / 1e3, hist_percentile(rtt, 90.0) / 1e3,
+               hist_percentile(rtt, 99.0) / 1e3, hist_percentile(rtt, 99.9) / 1e3, rtt->max_ns / 1e3,
+               result.rtt_cpu_ns, result.messages_per_s, result.stream_cpu_ns);
+    }
+    return status;
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sim.c"
+#include "../common/clock.h"
+
+#define DEFAULT_SCRIPT "1:60,0:30,2:10" // Accelerate for a minute, coast, then brake to a stop
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--script=SPEC] [--repeat=N] [--vmu-period=MS] [--engine-period=MS] [--trace=FILE] [--pedal-trace=FILE] [--telemetry=FILE]\n", program);
+    fprintf(stderr, "  --script=SPEC       Comma separated PEDAL:SECONDS segments, PEDAL 0=release 1=accelerate 2=brake (default %s)\n", DEFAULT_SCRIPT);
+    fprintf(stderr, "  --repeat=N          Play the script N times (default 1)\n");
+    fprintf(stderr, "  --vmu-period=MS     Simulated VMU control period (default 200)\n");
+    fprintf(stderr, "  --engine-period=MS  Simulated EV/IEC physics period (default 70)\n");
+    fprintf(stderr, "  --trace=FILE        Write a CSV row per VMU step to FILE ('-' for stdout)\n");
+    fprintf(stderr, "  --pedal-trace=FILE  Play the timestamped pedal events in FILE instead of --script (see bin/vmu --pedal-trace)\n");
+    fprintf(stderr, "  --telemetry=FILE    Record every VMU step in the telemetry ring file FILE (see bin/telemetry)\n");
+}
+
+// Parses a period in milliseconds into nanoseconds, 0 if invalid
+static long parse_period(const char *text) {
+    char *end;
+    double period_ms = strtod(text, &end);
+    if (*end != '\0' || !(period_ms > 0.0 && period_ms <= 10000.0)) {
+        return 0;
+    }
+    return (long)(period_ms * 1000000.0);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"script", required_argument, NULL, 's'},
+        {"repeat", required_argument, NULL, 'r'},
+        {"vmu-period", required_argument, NULL, 'v'},
+        {"engine-period", required_argument, NULL, 'e'},
+        {"trace", required_argument, NULL, 't'},
+        {"pedal-trace", required_argument, NULL, 'p'},
+        {"telemetry", required_argument, NULL, 'R'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    const char *script_text = DEFAULT_SCRIPT;
+    const char *trace_path = NULL;
+    const char *pedal_trace_path = NULL;
+    const char *telemetry_path = NULL;
+    long vmu_period_ns = VMU_PERIOD_NS;
+    long engine_period_ns = ENGINE_PERIOD_NS;
+    int repeat = 1;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "s:r:v:e:t:p:R:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's':
+                script_text = optarg;
+                break;
+            case 'r':
+                repeat = atoi(optarg);
+                break;
+            case 'v':
+                vmu_period_ns = parse_period(optarg);
+                break;
+            case 'e':
+                engine_period_ns = parse_period(optarg);
+                break;
+            case 't':
+                trace_path = optarg;
+                break;
+            case 'p':
+                pedal_trace_path = optarg;
+                break;
+            case 'R':
+                telemetry_path = optarg;
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    PedalScript script;
+    if (!parse_pedal_script(script_text, &script) || repeat < 1 || vmu_period_ns == 0 || engine_period_ns == 0) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    PedalTrace pedal_trace;
+    if (pedal_trace_path != NULL && pedal_trace_load(pedal_trace_path, &pedal_trace) != 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *trace = NULL;
+    if (trace_path != NULL) {
+        trace = strcmp(trace_path, "-") == 0 ? stdout : fopen(trace_path, "w");
+        if (trace == NULL) {
+            perror("[SIM] Error opening trace file");
+            exit(EXIT_FAILURE);
+        }
+        sim_trace_header(trace);
+    }
+
+    Simulation sim;
+    sim_init(&sim, vmu_period_ns, engine_period_ns);
+
+    TelemetryLog telemetry;
+    if (telemetry_path != NULL) {
+        if (telemetry_create(&telemetry, telemetry_path, TELEMETRY_DEFAULT_RECORDS, vmu_period_ns, engine_period_ns) != 0) {
+            perror("[SIM] Error creating telemetry file");
+            exit(EXIT_FAILURE);
+        }
+        sim.telemetry = &telemetry;
+    }
+
+    unsigned long long wall_start = monotonic_ns();
+    if (pedal_trace_path != NULL) {
+        sim_run_pedal_trace(&sim, &pedal_trace, trace);
+        pedal_trace_free(&pedal_trace);
+    } else {
+        sim_run_script(&sim, &script, repeat, trace);
+    }
+    double wall_s = (monotonic_ns() - wall_start) / 1e9;
+
+    if (trace != NULL && trace != stdout) {
+        fclose(trace);
+    }
+    if (telemetry_path != NULL) {
+        telemetry_close(&telemetry);
+    }
+
+    // The summary goes to stderr when the trace is written to stdout
+    FILE *out = trace == stdout ? stderr : stdout;
+    double sim_s = sim.time_ns / 1e9;
+    fprintf(out, "Simulated %.1f s (%lu VMU steps, %lu engine steps, %lu commands) in %.3f s wall: %.0fx real time\n",
+            sim_s, sim.vmu_steps, sim.engine_steps, sim.commands, wall_s, wall_s > 0.0 ? sim_s / wall_s : 0.0);
+    fprintf(out, "Distance: %.3f km, max speed: %.2f km/h\n", sim.distance_km, sim.max_speed);
+    fprintf(out, "Final speed: %.2f km/h, battery: %.2f%%, fuel: %.2f%%, power mode: %d\n",
+            sim.vehicle.speed, sim.vehicle.battery, sim.vehicle.fuel, sim.vehicle.power_mode);
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Headless faster-than-real-time simulation of the VMU, EV and IEC models in lockstep.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "../ev/ev_model.h"
+#include "../iec/iec_model.h"
+
+// Parses a pedal script of comma separated PEDAL:SECONDS segments, e.g. "1:30,0:10,2:5"
+// (accelerate 30 s, coast 10 s, brake 5 s). Returns 1 on success, 0 on a malformed script.
+int parse_pedal_script(const char *text, PedalScript *script) {
+    const char *p = text;
+    script->count = 0;
+
+    while (*p != '\0') {
+        char *end;
+        long pedal = strtol(p, &end, 10);
+        if (end == p || *end != ':' || pedal < PEDAL_RELEASED || pedal > PEDAL_BRAKE) {
+            return 0;
+        }
+        p = end + 1;
+        double duration_s = strtod(p, &end);
+        if (end == p || duration_s <= 0.0 || (*end != ',' && *end != '\0')) {
+            return 0;
+        }
+        if (script->count == SIM_MAX_SEGMENTS) {
+            return 0;
+        }
+        script->segments[script->count].pedal = (Pedal)pedal;
+        script->segments[script->count].duration_s = duration_s;
+        script->count++;
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return script->count > 0;
+}
+
+void sim_init(Simulation *sim, long vmu_period_ns, long engine_period_ns) {
+    memset(sim, 0, sizeof(*sim));
+    init_vehicle_state(&sim->vehicle);
+    sim->vmu_period_ns = vmu_period_ns;
+    sim->engine_period_ns = engine_period_ns;
+    // As with the tick scheduler, the first step of each loop is one period after start
+    sim->next_vmu_ns = vmu_period_ns;
+    sim->next_engine_ns = engine_period_ns;
+}
+
+// Same effect as typing 0/1/2 into the VMU terminal (see read_input())
+void sim_set_pedal(Simulation *sim, Pedal pedal) {
+    sim->vehicle.accelerator = (pedal == PEDAL_ACCELERATE);
+    sim->vehicle.brake = (pedal == PEDAL_BRAKE);
+}
+
+// One VMU loop iteration of a single vehicle: control law, then speed, then delivery of the
+// issued `commands`. Returns the number of commands issued.
+int vehicle_vmu_step(VehicleState *vehicle, ControlCommands *commands) {
+    int issued = 0;
+
+    vmu_control_model(vehicle, commands);
+    vehicle->speed = speed_model(vehicle);
+
+    // The engines apply START/STOP as soon as they receive them, after the VMU step
+    if (commands->send_ev) {
+        ev_apply_command(commands->ev.type, &vehicle->ev_on, &vehicle->rpm_ev);
+        issued++;
+    }
+    if (commands->send_iec) {
+        iec_apply_command(commands->iec.type, &vehicle->iec_on, &vehicle->rpm_iec);
+        issued++;
+    }
+    return issued;
+}
+
+void sim_vmu_step(Simulation *sim) {
+    VehicleState *vehicle = &sim->vehicle;
+    ControlCommands commands;
+
+    if (sim->telemetry != NULL) {
+        VehicleState before = *vehicle;
+        TelemetryRecord record;
+        sim->commands += vehicle_vmu_step(vehicle, &commands);
+        // The pedals and engine status do not change between the control law and the speed update
+        telemetry_record_fill(&record, sim->vmu_steps + 1, &before, &commands, &before, vehicle);
+        record.time_ns = sim->time_ns;
+        telemetry_append(sim->telemetry, &record);
+    } else {
+        sim->commands += vehicle_vmu_step(vehicle, &commands);
+    }
+
+    sim->distance_km += vehicle->speed * (double)sim->vmu_period_ns / 3600e9;
+    if (vehicle->speed > sim->max_speed) {
+        sim->max_speed = vehicle->speed;
+    }
+    sim->vmu_steps++;
+}
+
+// One physics step of both engines
+void sim_engine_step(Simulation *sim) {
+    VehicleState *vehicle = &sim->vehicle;
+    ev_engine_model(vehicle->ev_on, vehicle->ev_power_level, &vehicle->rpm_ev, &vehicle->temp_ev);
+    iec_engine_model(vehicle->iec_on, vehicle->iec_power_level, &vehicle->rpm_iec, &vehicle->temp_iec);
+    sim->engine_steps++;
+}
+
+void sim_trace_header(FILE *trace) {
+    fprintf(trace, "time_s,accelerator,brake,speed,battery,fuel,power_mode,ev_power,iec_power,ev_on,rpm_ev,temp_ev,iec_on,rpm_iec,temp_iec\n");
+}
+
+static void sim_trace_row(const Simulation *sim, FILE *trace) {
+    const VehicleState *v = &sim->vehicle;
+    fprintf(trace, "%.3f,%d,%d,%.6f,%.6f,%.6f,%d,%.6f,%.6f,%d,%d,%.6f,%d,%d,%.6f\n",
+            sim->time_ns / 1e9, v->accelerator, v->brake, v->speed, v->battery, v->fuel, v->power_mode,
+            v->ev_power_level, v->iec_power_level, v->ev_on, v->rpm_ev, v->temp_ev, v->iec_on, v->rpm_iec, v->temp_iec);
+}
+
+// Simulated time of the next step of either loop
+unsigned long long sim_next_step_ns(const Simulation *sim) {
+    return sim->next_engine_ns <= sim->next_vmu_ns ? sim->next_engine_ns : sim->next_vmu_ns;
+}
+
+// Runs the next step of the simulation: the engine step when both loops are due at the same
+// instant, as the engine modules run a step due at a VMU deadline before they see its commands.
+// The step hook is called first. A CSV row is written to `trace` after each VMU step.
+// Returns the step that ran.
+SimStep sim_step(Simulation *sim, FILE *trace) {
+    SimStep step = sim->next_engine_ns <= sim->next_vmu_ns ? SIM_STEP_ENGINE : SIM_STEP_VMU;
+
+    sim->time_ns = step == SIM_STEP_ENGINE ? sim->next_engine_ns : sim->next_vmu_ns;
+    if (sim->step_hook != NULL) {
+        sim->step_hook(sim, step, sim->step_hook_context);
+    }
+    if (step == SIM_STEP_ENGINE) {
+        sim_engine_step(sim);
+        sim->next_engine_ns += sim->engine_period_ns;
+    } else {
+        sim_vmu_step(sim);
+        sim->next_vmu_ns += sim->vmu_period_ns;
+        if (trace != NULL) {
+            sim_trace_row(sim, trace);
+        }
+    }
+    return step;
+}
+
+// Runs every step due in the next `duration_ns` of simulated time
+void sim_advance(Simulation *sim, unsigned long long duration_ns, FILE *trace) {
+    unsigned long long end_ns = sim->time_ns + duration_ns;
+
+    while (sim_next_step_ns(sim) <= end_ns) {
+        sim_step(sim, trace);
+    }
+    sim->time_ns = end_ns;
+}
+
+// Plays the pedal script `repeat` times. Pedal changes happen exactly at segment boundaries.
+void sim_run_script(Simulation *sim, const PedalScript *script, int repeat, FILE *trace) {
+    for (int r = 0; r < repeat; r++) {
+        for (int i = 0; i < script->count; i++) {
+            sim_set_pedal(sim, script->segments[i].pedal);
+            sim_advance(sim, (unsigned long long)(script->segments[i].duration_s * 1e9 + 0.5), trace);
+        }
+    }
+}
+
+typedef struct {
+    PedalTrace *pedal_trace;
+    unsigned long long start_ns;
+    SimStepHook hook; // Hook set before the run, still called after the pedals are set
+    void *context;
+} PedalTraceInput;
+
+// Step hook of sim_run_pedal_trace(): applies the event due at a VMU step
+static void pedal_trace_input(Simulation *sim, SimStep step, void *context) {
+    PedalTraceInput *input = (PedalTraceInput *)context;
+    if (step == SIM_STEP_VMU) {
+        const PedalEvent *event = pedal_trace_due(input->pedal_trace, sim->time_ns - input->start_ns);
+        if (event != NULL) {
+            sim_set_pedal(sim, event->brake ? PEDAL_BRAKE : event->accelerator ? PEDAL_ACCELERATE : PEDAL_RELEASED);
+        }
+    }
+    if (input->hook != NULL) {
+        input->hook(sim, step, input->context);
+    }
+}
+
+// Plays a pedal trace from the start of the simulation. Each event takes effect at the first VMU
+// step at or after its timestamp, as in the VMU process, and the run ends with the step that
+// applies the last event. The trace is the step hook for the length of the run, in front of the
+// hook already set.
+void sim_run_pedal_trace(Simulation *sim, PedalTrace *pedal_trace, FILE *trace) {
+    PedalTraceInput input = { pedal_trace, sim->time_ns, sim->step_hook, sim->step_hook_context };
+
+    sim->step_hook = pedal_trace_input;
+    sim->step_hook_context = &input;
+    while (!pedal_trace_done(pedal_trace)) {
+        sim_step(sim, trace);
+    }
+    sim->step_hook = input.hook;
+    sim->step_hook_context = input.context;
+}
@@ -0,0 +1,79 @@
+// sim.h
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "../vmu/vmu_model.h"
+#include "../common/pedal_trace.h"
+#include "../common/telemetry.h"
+
+#define SIM_MAX_SEGMENTS 256 // Maximum number of segments in a pedal script
+
+// Pedal positions, using the same codes that are typed into the VMU terminal
+typedef enum {
+    PEDAL_RELEASED = 0,   // Neither accelerator nor brake
+    PEDAL_ACCELERATE = 1, // Accelerator pressed
+    PEDAL_BRAKE = 2       // Brake pressed
+} Pedal;
+
+// Holds `pedal` for `duration_s` simulated seconds
+typedef struct {
+    Pedal pedal;
+    double duration_s;
+} PedalSegment;
+
+typedef struct {
+    PedalSegment segments[SIM_MAX_SEGMENTS];
+    int count;
+} PedalScript;
+
+typedef struct Simulation Simulation;
+
+// The two loops of the simulation
+typedef enum {
+    SIM_STEP_ENGINE, // EV/IEC physics step
+    SIM_STEP_VMU     // VMU control step
+} SimStep;
+
+// Called by sim_step() before each step, at its simulated time: an input source may set the pedals
+// before a VMU step, an observer sees the state every step starts from
+typedef void (*SimStepHook)(Simulation *sim, SimStep step, void *context);
+
+/*
+Headless lockstep simulation of one vehicle. The VMU control step and the EV/IEC physics steps
+run on their own simulated periods in a single process, with no sleeps, display or IPC.
+Commands take effect right after the VMU step that issued them, as the event-driven engines do.
+Every run, whatever drives it, goes through sim_step().
+*/
+struct Simulation {
+    VehicleState vehicle;
+    long vmu_period_ns;                // Simulated VMU control period
+    long engine_period_ns;             // Simulated EV/IEC physics period
+    unsigned long long time_ns;        // Simulated time
+    unsigned long long next_vmu_ns;    // Simulated time of the next VMU step
+    unsigned long long next_engine_ns; // Simulated time of the next engine step
+    unsigned long vmu_steps;
+    unsigned long engine_steps;
+    unsigned long commands;            // START/STOP/SET_POWER commands issued by the VMU
+    double distance_km;                // Distance travelled
+    double max_speed;                  // Highest speed reached
+    TelemetryLog *telemetry;           // If set, every VMU step is recorded (see bin/telemetry --replay)
+    SimStepHook step_hook;             // If set, called before every step
+    void *step_hook_context;
+};
+
+int parse_pedal_script(const char *text, PedalScript *script);
+void sim_init(Simulation *sim, long vmu_period_ns, long engine_period_ns);
+void sim_set_pedal(Simulation *sim, Pedal pedal);
+int vehicle_vmu_step(VehicleState *vehicle, ControlCommands *commands);
+void sim_vmu_step(Simulation *sim);
+void sim_engine_step(Simulation *sim);
+unsigned long long sim_next_step_ns(const Simulation *sim);
+SimStep sim_step(Simulation *sim, FILE *trace);
+void sim_advance(Simulation *sim, unsigned long long duration_ns, FILE *trace);
+void sim_run_script(Simulation *sim, const PedalScript *script, int repeat, FILE *trace);
+void sim_run_pedal_trace(Simulation *sim, PedalTrace *pedal_trace, FILE *trace);
+void sim_trace_header(FILE *trace);
+
+#endif
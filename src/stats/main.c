@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "stats.c"
+#include "../vmu/vmu.h"
+
+static const char *segment_name(const char *module) {
+    if (strcmp(module, "vmu") == 0) return VMU_STATS_NAME;
+    if (strcmp(module, "ev") == 0) return EV_STATS_NAME;
+    if (strcmp(module, "iec") == 0) return IEC_STATS_NAME;
+    if (strcmp(module, "display") == 0) return DISPLAY_STATS_NAME;
+    return NULL;
+}
+
+// Usage: stats [-i SECONDS] [vmu] [ev] [iec] [display]
+// Prints the latency histograms of the running modules (all of them by default),
+// once or every SECONDS until interrupted.
+int main(int argc, char *argv[]) {
+    static const char *all_modules[] = {"vmu", "ev", "iec", "display"};
+    const char **modules = all_modules;
+    int module_count = 4;
+    int interval = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:h")) != -1) {
+        if (opt == 'i') {
+            interval = atoi(optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-i SECONDS] [vmu] [ev] [iec] [display]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (optind < argc) {
+        modules = (const char **)&argv[optind];
+        module_count = argc - optind;
+    }
+
+    StatsPage copy;
+    do {
+        printf("%-7s %-16s %10s %10s %10s %10s %10s\n", "mod", "metric", "count", "mean(us)", "p50(us)", "p99(us)", "max(us)");
+        for (int i = 0; i < module_count; i++) {
+            const char *name = segment_name(modules[i]);
+            const StatsPage *page = name != NULL ? map_stats_page(name) : NULL;
+            if (page == NULL) {
+                fprintf(stderr, "%s: no statistics (module not running?)\n", modules[i]);
+                continue;
+            }
+            if (copy_stats_page(page, &copy)) {
+                print_stats(stdout, &copy);
+            } else {
+                fprintf(stderr, "%s: statistics page busy, try again\n", modules[i]);
+            }
+            unmap_stats_page(page);
+        }
+        fflush(stdout);
+        if (interval > 0) {
+            sleep(interval);
+            printf("\n");
+        }
+    } while (interval > 0);
+
+    return 0;
+}
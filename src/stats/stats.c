@@ -0,0 +1,56 @@
+// Reader for the latency statistics published by the VMU, EV and IEC modules and the VMU status screen.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "stats.h"
+
+// Maps the statistics segment `name` read-only. Returns NULL if the module is not running.
+const StatsPage *map_stats_page(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    const StatsPage *page = (const StatsPage *)mmap(NULL, sizeof(StatsPage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return page == MAP_FAILED ? NULL : page;
+}
+
+void unmap_stats_page(const StatsPage *page) {
+    if (page != NULL) {
+        munmap((void *)page, sizeof(StatsPage));
+    }
+}
+
+// Copies `page` under its seqlock so all histograms are from the same instant.
+// The writer is never blocked; returns 0 if it kept the page busy for STATS_COPY_RETRIES attempts.
+int copy_stats_page(const StatsPage *page, StatsPage *copy) {
+    for (int attempt = 0; attempt < STATS_COPY_RETRIES; attempt++) {
+        seqcount_t start = seqlock_read_begin(&page->seq);
+        memcpy(copy, page, sizeof(StatsPage));
+        if (!seqlock_read_retry(&page->seq, start)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Prints count, mean, p50, p99 and max (in microseconds) of every histogram with samples
+void print_stats(FILE *out, const StatsPage *page) {
+    for (int id = 0; id < STAT_COUNT; id++) {
+        const LatencyHistogram *hist = &page->hist[id];
+        if (hist->count == 0) {
+            continue;
+        }
+        fprintf(out, "%-7s %-16s %10llu %10.1f %10.1f %10.1f %10.1f\n",
+                page->module, stats_name((StatId)id), hist->count,
+                (double)hist->sum_ns / (double)hist->count / 1000.0,
+                hist_percentile(hist, 50.0) / 1000.0,
+                hist_percentile(hist, 99.0) / 1000.0,
+                hist->max_ns / 1000.0);
+    }
+}
@@ -0,0 +1,15 @@
+// stats.h
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include "../common/histogram.h"
+
+#define STATS_COPY_RETRIES 100 // Attempts to obtain a consistent copy of a page that is being written
+
+const StatsPage *map_stats_page(const char *name);
+void unmap_stats_page(const StatsPage *page);
+int copy_stats_page(const StatsPage *page, StatsPage *copy);
+void print_stats(FILE *out, const StatsPage *page);
+
+#endif
@@ -0,0 +1,80 @@
+// Reader for the binary telemetry files recorded by the VMU (--telemetry)
+
+#include <stdio.h>
+#include <string.h>
+#include "dump.h"
+
+void telemetry_summarize(const TelemetryLog *log, TelemetrySummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    uint64_t first = telemetry_first(log);
+    uint64_t count = telemetry_count(log);
+    summary->appended = count;
+    summary->kept = count - first;
+    if (summary->kept == 0) {
+        return;
+    }
+
+    const TelemetryRecord *previous = telemetry_get(log, first);
+    summary->first_tick = summary->last_tick = previous->tick;
+    for (uint64_t i = first + 1; i < count; i++) {
+        const TelemetryRecord *record = telemetry_get(log, i);
+        double interval_ms = (double)(record->time_ns - previous->time_ns) / 1e6;
+        if (interval_ms > summary->max_interval_ms) {
+            summary->max_interval_ms = interval_ms;
+        }
+        if (record->tick != previous->tick + 1) {
+            summary->tick_gaps++;
+        }
+        previous = record;
+    }
+    summary->last_tick = previous->tick;
+    summary->span_s = (double)(previous->time_ns - telemetry_get(log, first)->time_ns) / 1e9;
+    if (summary->kept > 1) {
+        summary->mean_interval_ms = summary->span_s * 1e3 / (double)(summary->kept - 1);
+    }
+}
+
+void print_telemetry_summary(FILE *out, const TelemetryLog *log, const TelemetrySummary *summary) {
+    fprintf(out, "records:   %llu appended, %llu kept (ring of %llu, %u bytes each)\n",
+            (unsigned long long)summary->appended, (unsigned long long)summary->kept,
+            (unsigned long long)log->header->capacity, log->header->record_size);
+    if (summary->kept == 0) {
+        return;
+    }
+    fprintf(out, "ticks:     %llu to %llu, %llu gaps\n", (unsigned long long)summary->first_tick,
+            (unsigned long long)summary->last_tick, (unsigned long long)summary->tick_gaps);
+    fprintf(out, "period:    %.3f ms configured, %.3f ms mean, %.3f ms max between records\n",
+            log->header->period_ns / 1e6, summary->mean_interval_ms, summary->max_interval_ms);
+    fprintf(out, "span:      %.3f s\n", summary->span_s);
+    if (log->header->engine_period_ns != 0) {
+        fprintf(out, "engines:   lockstep every %.3f ms (bin/sim)\n", log->header->engine_period_ns / 1e6);
+    }
+}
+
+static const char *command_name(int8_t command) {
+    switch (command) {
+        case CMD_START: return "start";
+        case CMD_STOP: return "stop";
+        case CMD_SET_POWER: return "power";
+        case CMD_END: return "end";
+        default: return "";
+    }
+}
+
+// One row per kept record, oldest first: the state after the tick and the commands it sent
+void write_telemetry_csv(FILE *out, const TelemetryLog *log) {
+    fprintf(out, "tick,time_ns,accelerator,brake,speed,battery,fuel,power_mode,ev_power,iec_power,ev_on,rpm_ev,temp_ev,"
+                 "iec_on,rpm_iec,temp_iec,ev_command,iec_command,ev_mailbox_version,ev_mailbox_power,"
+                 "iec_mailbox_version,iec_mailbox_power\n");
+    uint64_t count = telemetry_count(log);
+    for (uint64_t i = telemetry_first(log); i < count; i++) {
+        const TelemetryRecord *record = telemetry_get(log, i);
+        const TelemetryVehicle *v = &record->after;
+        fprintf(out, "%llu,%llu,%d,%d,%.6f,%.6f,%.6f,%d,%.6f,%.6f,%d,%d,%.6f,%d,%d,%.6f,%s,%s,%u,%.6f,%u,%.6f\n",
+                (unsigned long long)record->tick, (unsigned long long)record->time_ns, v->accelerator, v->brake,
+                v->speed, v->battery, v->fuel, v->power_mode, v->ev_power_level, v->iec_power_level, v->ev_on,
+                v->rpm_ev, v->temp_ev, v->iec_on, v->rpm_iec, v->temp_iec, command_name(record->ev_command),
+                command_name(record->iec_command), record->ev_mailbox_version, record->ev_mailbox_power,
+                record->iec_mailbox_version, record->iec_mailbox_power);
+    }
+}
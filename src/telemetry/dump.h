@@ -0,0 +1,24 @@
+// dump.h
+#ifndef DUMP_H
+#define DUMP_H
+
+#include <stdio.h>
+#include "../common/telemetry.h"
+
+// What a telemetry file holds, from its header and the time stamps of the kept records
+typedef struct {
+    uint64_t appended;      // Records ever appended
+    uint64_t kept;          // Records still in the ring (the most recent ones)
+    uint64_t first_tick;    // Tick numbers of the oldest and newest kept record
+    uint64_t last_tick;
+    uint64_t tick_gaps;     // Kept records whose tick does not follow the previous one
+    double span_s;          // Wall time between the oldest and newest kept record
+    double mean_interval_ms; // Spacing of consecutive records
+    double max_interval_ms;
+} TelemetrySummary;
+
+void telemetry_summarize(const TelemetryLog *log, TelemetrySummary *summary);
+void print_telemetry_summary(FILE *out, const TelemetryLog *log, const TelemetrySummary *summary);
+void write_telemetry_csv(FILE *out, const TelemetryLog *log);
+
+#endif
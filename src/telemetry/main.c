@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include "dump.c"
+#include "replay.c"
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--csv | --replay] FILE\n", program);
+    fprintf(stderr, "  --csv     Write the kept records as CSV on stdout, oldest first, instead of the summary\n");
+    fprintf(stderr, "  --replay  Re-execute the recorded ticks and report the first one that diverges (exit status 1)\n");
+}
+
+// Inspects or replays a telemetry file recorded by `vmu --telemetry=FILE` or `sim --telemetry=FILE`
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"csv", no_argument, NULL, 'c'},
+        {"replay", no_argument, NULL, 'r'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int csv = 0;
+    int replay = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "crh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'c':
+                csv = 1;
+                break;
+            case 'r':
+                replay = 1;
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc - 1 || (csv && replay)) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    TelemetryLog log;
+    if (telemetry_open(&log, argv[optind]) != 0) {
+        perror(argv[optind]);
+        exit(EXIT_FAILURE);
+    }
+    int status = EXIT_SUCCESS;
+    if (csv) {
+        write_telemetry_csv(stdout, &log);
+    } else if (replay) {
+        ReplayResult result;
+        if (telemetry_replay(&log, &result) != 0) {
+            status = EXIT_FAILURE;
+        }
+        print_replay_result(stdout, &result);
+    } else {
+        TelemetrySummary summary;
+        telemetry_summarize(&log, &summary);
+        print_telemetry_summary(stdout, &log, &summary);
+    }
+    telemetry_close(&log);
+    return status;
+}
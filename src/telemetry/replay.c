@@ -0,0 +1,259 @@
+// Deterministic replay of a telemetry recording through the VMU, speed and engine models
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include "replay.h"
+#include "../common/clock.h"
+#include "../ev/ev_model.h"
+#include "../iec/iec_model.h"
+
+// Which loop owns a field of the vehicle state
+typedef enum {
+    OWNER_INPUT,  // Pedals, written by the input thread
+    OWNER_VMU,    // Written by the control law and the speed update
+    OWNER_ENGINE, // Written by the engine modules
+} FieldOwner;
+
+typedef enum { FIELD_DOUBLE, FIELD_INT32, FIELD_UINT8 } FieldType;
+
+typedef struct {
+    const char *name;
+    size_t offset;
+    FieldType type;
+    FieldOwner owner;
+} VehicleField;
+
+#define FIELD(name, type, owner) { #name, offsetof(TelemetryVehicle, name), type, owner }
+
+static const VehicleField vehicle_fields[] = {
+    FIELD(accelerator, FIELD_UINT8, OWNER_INPUT),
+    FIELD(brake, FIELD_UINT8, OWNER_INPUT),
+    FIELD(speed, FIELD_DOUBLE, OWNER_VMU),
+    FIELD(battery, FIELD_DOUBLE, OWNER_VMU),
+    FIELD(fuel, FIELD_DOUBLE, OWNER_VMU),
+    FIELD(power_mode, FIELD_INT32, OWNER_VMU),
+    FIELD(ev_power_level, FIELD_DOUBLE, OWNER_VMU),
+    FIELD(iec_power_level, FIELD_DOUBLE, OWNER_VMU),
+    FIELD(was_accelerating, FIELD_UINT8, OWNER_VMU),
+    FIELD(ev_on, FIELD_UINT8, OWNER_ENGINE),
+    FIELD(rpm_ev, FIELD_INT32, OWNER_ENGINE),
+    FIELD(temp_ev, FIELD_DOUBLE, OWNER_ENGINE),
+    FIELD(iec_on, FIELD_UINT8, OWNER_ENGINE),
+    FIELD(rpm_iec, FIELD_INT32, OWNER_ENGINE),
+    FIELD(temp_iec, FIELD_DOUBLE, OWNER_ENGINE),
+};
+
+#define VEHICLE_FIELD_COUNT (sizeof(vehicle_fields) / sizeof(vehicle_fields[0]))
+
+static const char *stage_names[REPLAY_STAGE_COUNT] = {
+    "state", "engines", "control", "speed",
+};
+
+const char *replay_stage_name(ReplayStage stage) {
+    return stage_names[stage];
+}
+
+static double field_value(const TelemetryVehicle *vehicle, const VehicleField *field) {
+    const char *p = (const char *)vehicle + field->offset;
+    switch (field->type) {
+        case FIELD_DOUBLE: return *(const double *)p;
+        case FIELD_INT32: return *(const int32_t *)p;
+        default: return *(const uint8_t *)p;
+    }
+}
+
+static void diverge(ReplayResult *result, uint64_t tick, ReplayStage stage, const char *field, double recorded, double replayed) {
+    result->diverged = true;
+    result->tick = tick;
+    result->stage = stage;
+    result->field = field;
+    result->recorded = recorded;
+    result->replayed = replayed;
+}
+
+// Compares the fields of `owner` (or of every owner when `all`, attributing each to the stage that
+// writes it) bit for bit, and records the first difference. `skip` names a field left out.
+static bool vehicle_matches(const TelemetryVehicle *recorded, const VehicleState *replayed, bool all, FieldOwner owner,
+                            ReplayStage stage, const char *skip, uint64_t tick, ReplayResult *result) {
+    TelemetryVehicle packed;
+    telemetry_vehicle_pack(replayed, &packed);
+    for (size_t i = 0; i < VEHICLE_FIELD_COUNT; i++) {
+        const VehicleField *field = &vehicle_fields[i];
+        if ((!all && field->owner != owner) || (skip != NULL && strcmp(field->name, skip) == 0)) {
+            continue;
+        }
+        size_t size = field->type == FIELD_DOUBLE ? sizeof(double) : field->type == FIELD_INT32 ? sizeof(int32_t) : sizeof(uint8_t);
+        if (memcmp((const char *)recorded + field->offset, (const char *)&packed + field->offset, size) != 0) {
+            ReplayStage field_stage = all && field->owner == OWNER_ENGINE ? REPLAY_ENGINES : stage;
+            diverge(result, tick, field_stage, field->name, field_value(recorded, field), field_value(&packed, field));
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool command_matches(int8_t recorded, bool send, CommandType type, const char *field, uint64_t tick, ReplayResult *result) {
+    int8_t replayed = send ? (int8_t)type : TELEMETRY_NO_COMMAND;
+    if (recorded != replayed) {
+        diverge(result, tick, REPLAY_CONTROL, field, recorded, replayed);
+        return false;
+    }
+    return true;
+}
+
+// Copies the fields written outside the VMU loop, which a live recording takes as inputs
+static void copy_external_inputs(const TelemetryVehicle *recorded, VehicleState *vehicle) {
+    VehicleState inputs;
+    telemetry_vehicle_unpack(recorded, &inputs);
+    vehicle->accelerator = inputs.accelerator;
+    vehicle->brake = inputs.brake;
+    vehicle->ev_on = inputs.ev_on;
+    vehicle->rpm_ev = inputs.rpm_ev;
+    vehicle->temp_ev = inputs.temp_ev;
+    vehicle->iec_on = inputs.iec_on;
+    vehicle->rpm_iec = inputs.rpm_iec;
+    vehicle->temp_iec = inputs.temp_iec;
+}
+
+// Restarts the replay at `record`: the state recorded before it, with the engine steps in phase.
+// Returns the time of the next engine step of a lockstep recording.
+static unsigned long long replay_seed(const TelemetryHeader *header, const TelemetryRecord *record, bool lockstep, VehicleState *vehicle) {
+    telemetry_vehicle_unpack(&record->before, vehicle);
+    if (!lockstep) {
+        return 0;
+    }
+    // Engine steps due at the same instant as a VMU step have already run before it
+    return (record->tick * header->period_ns / header->engine_period_ns + 1) * header->engine_period_ns;
+}
+
+/*
+Re-executes every kept tick of `log`, as fast as possible, starting from the state recorded before
+the oldest one, and stops at the first field whose replayed value differs from the recording
+(doubles are compared bit for bit).
+
+The VMU state (speed, battery, fuel, mode, power levels) is always carried from one replayed tick
+to the next; the pedals are inputs taken from the recording. In a live recording the engines ran
+in their own processes at their own pace, so their state is an input as well, and calculate_speed()
+gets the pedal and engine status it read at the time. A lockstep recording from bin/sim is
+replayed as bin/sim runs it: the commands are applied right after the VMU step, and the EV/IEC
+models are stepped on the simulated clock between ticks, so every field is recomputed.
+
+Ticks the recorder dropped leave a gap in the tick numbers. The state cannot be carried across it,
+so the replay restarts from the state recorded before the first tick after the gap; gaps are
+counted in `result` and are not divergences.
+
+Returns 0 if the whole recording was reproduced, 1 at the first divergence (see `result`).
+*/
+int telemetry_replay(const TelemetryLog *log, ReplayResult *result) {
+    const TelemetryHeader *header = log->header;
+    uint64_t first = telemetry_first(log);
+    uint64_t count = telemetry_count(log);
+    VehicleState vehicle;
+    ControlCommands commands;
+    unsigned long long next_engine_ns = 0;
+
+    memset(result, 0, sizeof(*result));
+    result->lockstep = header->engine_period_ns != 0;
+    if (first == count) {
+        return 0;
+    }
+
+    unsigned long long start_ns = monotonic_ns();
+    uint64_t previous_tick = telemetry_get(log, first)->tick;
+    next_engine_ns = replay_seed(header, telemetry_get(log, first), result->lockstep, &vehicle);
+
+    for (uint64_t i = first; i < count && !result->diverged; i++) {
+        const TelemetryRecord *record = telemetry_get(log, i);
+        uint64_t tick = record->tick;
+
+        if (i != first && tick != previous_tick + 1) {
+            if (result->gaps++ == 0) {
+                result->first_gap_tick = tick;
+            }
+            result->ticks_missing += tick > previous_tick ? tick - previous_tick - 1 : 0;
+            next_engine_ns = replay_seed(header, record, result->lockstep, &vehicle);
+        }
+        previous_tick = tick;
+
+        // Between ticks: the engines and the pedals
+        if (result->lockstep) {
+            for (unsigned long long vmu_ns = tick * header->period_ns; next_engine_ns <= vmu_ns; next_engine_ns += header->engine_period_ns) {
+                ev_engine_model(vehicle.ev_on, vehicle.ev_power_level, &vehicle.rpm_ev, &vehicle.temp_ev);
+                iec_engine_model(vehicle.iec_on, vehicle.iec_power_level, &vehicle.rpm_iec, &vehicle.temp_iec);
+                result->engine_steps++;
+            }
+            vehicle.accelerator = record->before.accelerator;
+            vehicle.brake = record->before.brake;
+            if (!vehicle_matches(&record->before, &vehicle, true, OWNER_VMU, REPLAY_STATE, NULL, tick, result)) {
+                break;
+            }
+        } else {
+            copy_external_inputs(&record->before, &vehicle);
+            if (!vehicle_matches(&record->before, &vehicle, false, OWNER_VMU, REPLAY_STATE, NULL, tick, result)) {
+                break;
+            }
+        }
+
+        // vmu_control_engines()
+        vmu_control_model(&vehicle, &commands);
+        if (!command_matches(record->ev_command, commands.send_ev, commands.ev.type, "ev_command", tick, result) ||
+            !command_matches(record->iec_command, commands.send_iec, commands.iec.type, "iec_command", tick, result) ||
+            !vehicle_matches(&record->after, &vehicle, false, OWNER_VMU, REPLAY_CONTROL, "speed", tick, result)) {
+            break;
+        }
+
+        // calculate_speed()
+        if (result->lockstep) {
+            vehicle.speed = speed_model(&vehicle);
+        } else {
+            VehicleState speed_input = vehicle;
+            speed_input.accelerator = record->speed_accelerator;
+            speed_input.brake = record->speed_brake;
+            speed_input.ev_on = record->speed_ev_on;
+            speed_input.iec_on = record->speed_iec_on;
+            vehicle.speed = speed_model(&speed_input);
+        }
+        if (!vehicle_matches(&record->after, &vehicle, false, OWNER_VMU, REPLAY_SPEED, NULL, tick, result)) {
+            break;
+        }
+
+        // Delivery of the commands, as in vehicle_vmu_step()
+        if (result->lockstep) {
+            if (commands.send_ev) {
+                ev_apply_command(commands.ev.type, &vehicle.ev_on, &vehicle.rpm_ev);
+            }
+            if (commands.send_iec) {
+                iec_apply_command(commands.iec.type, &vehicle.iec_on, &vehicle.rpm_iec);
+            }
+            if (!vehicle_matches(&record->after, &vehicle, false, OWNER_ENGINE, REPLAY_CONTROL, NULL, tick, result)) {
+                break;
+            }
+        }
+        result->ticks++;
+    }
+    result->wall_s = (monotonic_ns() - start_ns) / 1e9;
+    return result->diverged ? 1 : 0;
+}
+
+void print_replay_result(FILE *out, const ReplayResult *result) {
+    fprintf(out, "Replayed %llu ticks in %.3f s (%.0f ticks/s): ", (unsigned long long)result->ticks, result->wall_s,
+            result->wall_s > 0.0 ? result->ticks / result->wall_s : 0.0);
+    if (result->lockstep) {
+        fprintf(out, "lockstep, %llu engine steps\n", (unsigned long long)result->engine_steps);
+    } else {
+        fprintf(out, "live, engine state taken from the recording\n");
+    }
+    if (result->gaps > 0) {
+        fprintf(out, "%llu gaps (%llu ticks missing, first before tick %llu), replay restarted after each\n",
+                (unsigned long long)result->gaps, (unsigned long long)result->ticks_missing,
+                (unsigned long long)result->first_gap_tick);
+    }
+    if (result->diverged) {
+        fprintf(out, "First divergence at tick %llu in %s: %s recorded %.17g, replayed %.17g\n",
+                (unsigned long long)result->tick, replay_stage_name(result->stage), result->field,
+                result->recorded, result->replayed);
+    } else {
+        fprintf(out, "No divergence\n");
+    }
+}
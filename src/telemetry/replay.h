@@ -0,0 +1,40 @@
+// replay.h
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "../common/telemetry.h"
+
+// Step of a tick where the replayed state first differed from the recording
+typedef enum {
+    REPLAY_STATE,   // State carried over from the previous tick (or changed between ticks by something else)
+    REPLAY_ENGINES, // EV/IEC physics steps between two ticks (lockstep recordings only)
+    REPLAY_CONTROL, // vmu_control_engines(): commands, power levels, battery, fuel, mode
+    REPLAY_SPEED,   // calculate_speed()
+    REPLAY_STAGE_COUNT
+} ReplayStage;
+
+typedef struct {
+    bool lockstep;          // The recording came from bin/sim and the engine models were replayed too
+    uint64_t ticks;         // Ticks replayed
+    uint64_t engine_steps;  // Engine physics steps replayed
+    double wall_s;          // Time taken by the replay
+    // Ticks missing from the recording (dropped by the recorder): the replay restarts after each gap
+    uint64_t gaps;
+    uint64_t ticks_missing;
+    uint64_t first_gap_tick; // First tick recorded after a gap
+    bool diverged;
+    // First divergence
+    uint64_t tick;
+    ReplayStage stage;
+    const char *field;
+    double recorded;
+    double replayed;
+} ReplayResult;
+
+const char *replay_stage_name(ReplayStage stage);
+int telemetry_replay(const TelemetryLog *log, ReplayResult *result);
+void print_replay_result(FILE *out, const ReplayResult *result);
+
+#endif
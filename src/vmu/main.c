@@ -2,24 +2,210 @@
 #include <stdlib.h>
 #include <unistd.h> 
 #include "vmu.c"
+#include "../common/options.h"
+#include "../common/tick.h"
+#include "../common/histogram.h"
+#include "../common/pedal_trace.h"
+#include "../common/telemetry.h"
+#include "../common/observer.h"
+#include "../common/rt.h"
 
-int main() {
+#define RECORDER_POLL_NS 50000000L // The telemetry recorder drains the snapshot stream every 50 ms
+
+static SnapshotStream snapshots; // Per-tick snapshots from the control loop to the observers
+
+// Presses the pedals as the driver would at the terminal
+static void apply_pedal_event(const PedalEvent *event) {
+    if (event->brake) {
+        set_braking(true);
+    } else {
+        set_braking(false);
+        set_acceleration(event->accelerator);
+    }
+}
+
+// Publishes the snapshot of control tick `tick`: what the tick read, what it decided and every
+// SystemState field once it has published. Only memory copies and lock-free snapshots.
+static void publish_tick(unsigned long tick) {
+    TelemetryRecord record;
+    VehicleState after;
+
+    load_vehicle_state(system_state, &after); // As the next control tick will read it
+    telemetry_record_fill(&record, tick, &last_control_input, &last_control_commands, &last_speed_input, &after);
+    // The mailboxes are written only by this loop, so they are read without the seqlock
+    record.ev_mailbox_version = system_state->ev_mailbox.version;
+    record.iec_mailbox_version = system_state->iec_mailbox.version;
+    record.ev_mailbox_power = system_state->ev_mailbox.power_level;
+    record.iec_mailbox_power = system_state->iec_mailbox.power_level;
+    record.time_ns = monotonic_ns();
+
+    snapshot_publish(&snapshots, &record);
+}
+
+// Status screen observer: draws the newest snapshot and times it into the display statistics page,
+// which this thread alone writes (the page of the process belongs to the control loop)
+static void show_snapshot(Observer *observer, const TelemetryRecord *snapshot) {
+    StatsPage *page = (StatsPage *)observer->context;
+    unsigned long long start = page != NULL ? monotonic_ns() : 0;
+    VehicleState vehicle;
+    telemetry_vehicle_unpack(&snapshot->after, &vehicle);
+    display_vehicle(&vehicle);
+    if (page != NULL) {
+        stats_page_record(page, STAT_DISPLAY_STATUS, monotonic_ns() - start);
+    }
+}
+
+// Telemetry observer: appends every snapshot to the ring file
+static void record_snapshot(Observer *observer, const TelemetryRecord *snapshot) {
+    telemetry_append((TelemetryLog *)observer->context, snapshot);
+}
+
+int main(int argc, char *argv[]) {
+    RuntimeOptions options;
+    if (!parse_runtime_options(argc, argv, &options)) {
+        exit(EXIT_FAILURE);
+    }
+    command_transport = options.transport;
+    power_mailbox = options.power_mailbox;
+    state_lock_mode = options.state_lock;
+    module_runtime = options.runtime;
+    if (module_runtime == RUNTIME_THREADS) {
+        // The engine threads share the loop priority: each sleeps on its ring between steps
+        int engine_priority = options.rt.enabled ? options.rt.loop_priority : 0;
+        long engine_period_ns = options.engine_period_ns ? options.engine_period_ns : ENGINE_PERIOD_NS;
+        engine_thread_init(&ev_engine, ENGINE_EV, engine_period_ns, options.tick_policy, engine_priority, options.stats);
+        engine_thread_init(&iec_engine, ENGINE_IEC, engine_period_ns, options.tick_policy, engine_priority, options.stats);
+    }
+    // Pinning and memory locking come first, so every thread and mapping created below inherits them
+    rt_enter(&options.rt, "VMU");
+    input_priority = options.rt.enabled ? options.rt.input_priority : 0;
+
+    // A pedal trace is parsed completely before the run so the loop never touches the file
+    PedalTrace pedal_trace;
+    if (options.pedal_trace != NULL) {
+        if (pedal_trace_load(options.pedal_trace, &pedal_trace) != 0) {
+            exit(EXIT_FAILURE);
+        }
+        interactive_input = false;
+    }
+
+    // The telemetry file is allocated and mapped before the run; recording a tick makes no system call
+    long period_ns = options.period_ns ? options.period_ns : VMU_PERIOD_NS;
+    TelemetryLog telemetry;
+    bool recording = options.telemetry != NULL;
+    if (recording && telemetry_create(&telemetry, options.telemetry, options.telemetry_records, period_ns, 0) != 0) {
+        perror("[VMU] Error creating telemetry file");
+        exit(EXIT_FAILURE);
+    }
 
     // Initialize communication with EV and IEC modules
     init_communication();
+    if (system_state == MAP_FAILED) {
+        exit(EXIT_FAILURE); // The transport reported why and left nothing open
+    }
+
+    // Main loop of the VMU module, paced by absolute deadlines so the time spent
+    // in the loop body does not stretch the period
+    TickScheduler control;
+    unsigned long long start;
+    unsigned long executed_ticks = 0; // Control ticks executed: the trace and telemetry clock, which pauses and skipped ticks do not advance
+    if (options.stats && stats_open(VMU_STATS_NAME, "vmu") == NULL) {
+        perror("[VMU] Error creating statistics segment");
+    }
+    StatsPage *display_stats = options.stats ? stats_page_create(DISPLAY_STATS_NAME, "display") : NULL;
+    if (options.stats && display_stats == NULL) {
+        perror("[VMU] Error creating display statistics segment");
+    }
 
-    system("clear");
-    // Main loop of the VMU module
+    // Presentation and recording run on observer threads below the control loop, fed by the
+    // snapshot each tick publishes; a slow terminal or disk never delays a tick
+    snapshot_stream_init(&snapshots);
+    Observer display = {
+        .name = "display",
+        .on_snapshot = show_snapshot,
+        .context = display_stats,
+        .latest_only = true,
+        .poll_interval_ns = options.display_rate_hz > 0.0 ? (long)(1e9 / options.display_rate_hz) : period_ns,
+        .nice = OBSERVER_NICE,
+        .rt_priority = options.rt.enabled ? options.rt.observer_priority : 0,
+    };
+    Observer recorder = {
+        .name = "telemetry",
+        .on_snapshot = record_snapshot,
+        .context = &telemetry,
+        .poll_interval_ns = RECORDER_POLL_NS,
+        .nice = OBSERVER_NICE,
+        .rt_priority = options.rt.enabled ? options.rt.observer_priority : 0,
+    };
+    if (observer_start(&display, &snapshots) != 0) {
+        perror("[VMU] Error creating display thread");
+        running = 0; // The recorder is not started either
+    } else if (recording && observer_start(&recorder, &snapshots) != 0) {
+        perror("[VMU] Error creating telemetry thread");
+        running = 0;
+    }
+    if (options.rt.enabled) {
+        // Everything the loop touches is resident before the first tick
+        rt_prefault(system_state, sizeof(SystemState));
+        rt_prefault(&snapshots, sizeof(snapshots));
+        for (int channel = 0; channel < TRANSPORT_CHANNELS; channel++) {
+            if (vmu_transport.rings[channel] != NULL) rt_prefault(vmu_transport.rings[channel], sizeof(CommandRing));
+        }
+        if (rt_thread_enter(options.rt.loop_priority) != 0) {
+            perror("[VMU] Error setting control loop priority");
+        }
+    }
+    tick_init(&control, period_ns, options.tick_policy);
     while (running) {
         if (!paused) {
+            executed_ticks++;
+            if (!interactive_input) {
+                // Tick n is at n periods, as in bin/sim; events take effect at the first tick at or
+                // after their timestamp
+                const PedalEvent *event = pedal_trace_due(&pedal_trace, (unsigned long long)executed_ticks * control.period_ns);
+                if (event != NULL) {
+                    apply_pedal_event(event);
+                }
+            }
+
+            start = stats_start();
             vmu_control_engines(); // Control the engines based on the system state
+            stats_record_since(STAT_CONTROL_ENGINES, start);
+
+            start = stats_start();
             calculate_speed(system_state); // Calculate the current speed
-            display_status(system_state);  // Display the current system status
-            usleep(200000); // Sleep for 200 milliseconds
+            stats_record_since(STAT_CALCULATE_SPEED, start);
+
+            start = stats_start();
+            publish_tick(executed_ticks); // Hand the tick to the display and recorder threads
+            stats_record_since(STAT_PUBLISH, start);
+
+            if (!interactive_input && pedal_trace_done(&pedal_trace)) {
+                running = 0; // The last event has been played
+                break;
+            }
+            stats_record(STAT_WAKEUP_LATENESS, tick_wait(&control)); // Sleep until the next deadline
         } else {
             sleep(1); // Sleep for 1 second if paused
+            tick_restart(&control);
         }
     }
+    observer_stop(&display); // Each only if it was started
+    observer_stop(&recorder); // Drains the snapshots still in the stream
+    printf("[VMU] %lu control ticks, %lu overruns, %lu skipped\n", control.ticks, control.overruns, control.skipped);
+    if (system_state->lock_mode == STATE_LOCK_MUTEX) {
+        printf("[VMU] %u dead state writers recovered\n", system_state->state_recoveries);
+    }
+    stats_close(VMU_STATS_NAME);
+    stats_page_destroy(display_stats, DISPLAY_STATS_NAME);
+    if (!interactive_input) {
+        pedal_trace_free(&pedal_trace);
+    }
+    if (recording) {
+        printf("[VMU] %llu ticks recorded in %s, %lu dropped\n", (unsigned long long)telemetry_count(&telemetry),
+               options.telemetry, recorder.dropped);
+        telemetry_close(&telemetry);
+    }
 
     cleanup(); // Cleanup resources before exiting
     return 0;
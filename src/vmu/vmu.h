@@ -7,12 +7,20 @@
 #include <signal.h>
 #include <semaphore.h>
 #include <mqueue.h>
+#include "../common/seqlock.h"
+#include "../common/clock.h"
 
 // Define names for shared memory, semaphore, and message queues
 #define SHARED_MEM_NAME "/hybrid_car_shared_data"
 #define SEMAPHORE_NAME "/hybrid_car_semaphore"
 #define EV_COMMAND_QUEUE_NAME "/ev_command_queue"
 #define IEC_COMMAND_QUEUE_NAME "/iec_command_queue"
+#define EV_COMMAND_RING_NAME "/ev_command_ring"
+#define IEC_COMMAND_RING_NAME "/iec_command_ring"
+#define VMU_STATS_NAME "/hybrid_car_stats_vmu"
+#define EV_STATS_NAME "/hybrid_car_stats_ev"
+#define IEC_STATS_NAME "/hybrid_car_stats_iec"
+#define DISPLAY_STATS_NAME "/hybrid_car_stats_display" // Written by the VMU status screen thread
 
 // Constants
 #define MAX_SPEED 160.0         // Maximum vehicle speed (km/h)
@@ -43,6 +51,10 @@
 #define IEC_RECHARGE_RATE           0.002   // Battery recharge rate when IEC is running (e.g., charging battery)
 
 #define SPEED_CHANGE_SMOOTHING     0.5  // Smoothing factor for speed changes (0-1)
+#define MAX_COMMANDS_PER_BATCH     32   // Upper bound on commands drained by one receive_cmd() call
+#define VMU_PERIOD_NS        200000000L // Control loop period of the VMU (200 ms)
+#define ENGINE_PERIOD_NS      70000000L // Physics step period of the EV and IEC modules (70 ms)
+#define DISPLAY_RATE_HZ       10.0      // Default refresh cap of the VMU status screen
 
 // Vehicle Dynamics and Engine Torque Curve Constants (Simplified)
 #define EV_BASE_RPM             2000    // RPM where EV transitions from constant torque to constant power
@@ -52,25 +64,193 @@
 #define MAX_IEC_RPM             6000    // Maximum RPM for IEC
 
 
+#define CACHE_LINE_SIZE 64 // Alignment of each single-writer block in the shared segment
+
+// Latest-value slot for power setpoints (mailbox mode). Each post overwrites the previous
+// setpoint and bumps `version`, so a slow consumer only ever sees the freshest value.
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) seqcount_t seq;
+    unsigned int version;   // Number of setpoints posted so far
+    double power_level;     // Most recent commanded power level (0.0 to 1.0), a copy for telemetry
+    unsigned long long sent_ns; // CLOCK_MONOTONIC time the setpoint was posted
+} CommandMailbox;
+
+// How writers of the shared segment are serialized against each other and against a dead writer
+typedef enum {
+    STATE_LOCK_SEM,  // Blocks published lock-free; the named semaphore serializes whole-state tools (default)
+    STATE_LOCK_MUTEX // Write sections also hold the process-shared, priority-inheriting, robust state_mutex
+} StateLockMode;
+
 // Structure for system state
+// The shared segment is split into cache-line-aligned blocks, each written by exactly one owner and
+// published through its own sequence counter. Readers take lock-free snapshots (see seqlock.h).
 typedef struct {
-    bool accelerator; // True if accelerator is pressed
-    bool brake;       // True if brake is pressed
-    double speed;     // Current vehicle speed (km/h)
-    int rpm_ev;       // EV motor RPM
-    int rpm_iec;      // IEC engine RPM
-    bool ev_on;       // True if EV motor is running
-    bool iec_on;      // True if IEC engine is running
-    double temp_ev;   // EV motor temperature (C)
-    double temp_iec;  // IEC engine temperature (C)
-    double battery;   // Battery level (%)
-    double fuel;      // Fuel level (%) 
-    int power_mode; // 0: Hybrid, 1: Electric Only, 2: Combustion Only, 3: Regenerative Braking, 4: Parked
-    double ev_power_level; // Commanded power level for EV (0.0 to 1.0)
-    double iec_power_level; // Commanded power level for IEC (0.0 to 1.0)
-    bool was_accelerating; // Tracks if accelerator was pressed in the previous cycle
+    // Input block - written only by the VMU input thread
+    struct {
+        _Alignas(CACHE_LINE_SIZE) seqcount_t input_seq;
+        bool accelerator; // True if accelerator is pressed
+        bool brake;       // True if brake is pressed
+    };
+    // VMU command block - written only by the VMU control loop
+    struct {
+        _Alignas(CACHE_LINE_SIZE) seqcount_t vmu_seq;
+        double speed;     // Current vehicle speed (km/h)
+        double battery;   // Battery level (%)
+        double fuel;      // Fuel level (%) 
+        int power_mode; // 0: Hybrid, 1: Electric Only, 2: Combustion Only, 3: Regenerative Braking, 4: Parked
+        double ev_power_level; // Commanded power level for EV (0.0 to 1.0)
+        double iec_power_level; // Commanded power level for IEC (0.0 to 1.0)
+        bool was_accelerating; // Tracks if accelerator was pressed in the previous cycle
+    };
+    // EV status block - written only by the EV module
+    struct {
+        _Alignas(CACHE_LINE_SIZE) seqcount_t ev_seq;
+        bool ev_on;       // True if EV motor is running
+        int rpm_ev;       // EV motor RPM
+        double temp_ev;   // EV motor temperature (C)
+    };
+    // IEC status block - written only by the IEC module
+    struct {
+        _Alignas(CACHE_LINE_SIZE) seqcount_t iec_seq;
+        bool iec_on;      // True if IEC engine is running
+        int rpm_iec;      // IEC engine RPM
+        double temp_iec;  // IEC engine temperature (C)
+    };
+    // Power setpoint mailboxes - written only by the VMU control loop in mailbox mode
+    CommandMailbox ev_mailbox;
+    CommandMailbox iec_mailbox;
+    // Lock block - set up by the VMU before the engines attach
+    struct {
+        _Alignas(CACHE_LINE_SIZE) pthread_mutex_t state_mutex; // Taken around write sections with STATE_LOCK_MUTEX
+        StateLockMode lock_mode;
+        unsigned int state_recoveries; // Write sections abandoned by a dead holder and repaired
+    };
 } SystemState;
 
+/*
+Whole-state lock (src/common/state_lock.c). With STATE_LOCK_MUTEX every block writer holds
+state_mutex for the length of its write section, and a reader finding a write in progress waits
+on the mutex instead of spinning. The mutex inherits priority, so a high-priority reader boosts
+a preempted low-priority writer instead of spinning against it on the same CPU. It is robust,
+so a writer that dies inside its section hands the next locker EOWNERDEAD, and the state is
+repaired before anyone reads it: odd sequence counters are closed and every field is brought
+back into range (system_state_repair()).
+*/
+int state_lock_init(SystemState *state, StateLockMode mode);
+int state_mutex_lock(SystemState *state);
+void state_lock_failed(void) __attribute__((noreturn));
+seqcount_t state_read_wait(const SystemState *state, const seqcount_t *seq);
+int system_state_repair(SystemState *state);
+
+// Starts a write section of the block protected by `seq`. Returns true if state_mutex was taken, to
+// be passed to state_write_end(). In STATE_LOCK_MUTEX mode no section runs unlocked: an unusable
+// mutex stops the process (state_lock_failed()).
+static inline bool state_write_begin(SystemState *state, seqcount_t *seq) {
+    bool locked = false;
+    if (state->lock_mode == STATE_LOCK_MUTEX) {
+        if (state_mutex_lock(state) < 0) {
+            state_lock_failed();
+        }
+        locked = true;
+    }
+    seqlock_write_begin(seq);
+    return locked;
+}
+
+static inline void state_write_end(SystemState *state, seqcount_t *seq, bool locked) {
+    seqlock_write_end(seq);
+    if (locked) {
+        pthread_mutex_unlock(&state->state_mutex);
+    }
+}
+
+// seqlock_read_begin() for a block of the state: the fast path is the same load, a write in
+// progress goes through state_read_wait()
+static inline seqcount_t state_read_begin(const SystemState *state, const seqcount_t *seq) {
+    seqcount_t start = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+    if (__builtin_expect(start & 1U, 0)) {
+        start = state_read_wait(state, seq);
+    }
+    return start;
+}
+
+// Lock-free snapshots of the blocks owned by another writer
+static inline void snapshot_input_block(const SystemState *state, bool *accelerator, bool *brake) {
+    seqcount_t seq;
+    do {
+        seq = state_read_begin(state, &state->input_seq);
+        *accelerator = state->accelerator;
+        *brake = state->brake;
+    } while (seqlock_read_retry(&state->input_seq, seq));
+}
+
+static inline void snapshot_power_levels(const SystemState *state, double *ev_power_level, double *iec_power_level) {
+    seqcount_t seq;
+    do {
+        seq = state_read_begin(state, &state->vmu_seq);
+        *ev_power_level = state->ev_power_level;
+        *iec_power_level = state->iec_power_level;
+    } while (seqlock_read_retry(&state->vmu_seq, seq));
+}
+
+static inline void snapshot_ev_block(const SystemState *state, bool *ev_on, int *rpm_ev, double *temp_ev) {
+    seqcount_t seq;
+    do {
+        seq = state_read_begin(state, &state->ev_seq);
+        *ev_on = state->ev_on;
+        *rpm_ev = state->rpm_ev;
+        *temp_ev = state->temp_ev;
+    } while (seqlock_read_retry(&state->ev_seq, seq));
+}
+
+static inline void snapshot_iec_block(const SystemState *state, bool *iec_on, int *rpm_iec, double *temp_iec) {
+    seqcount_t seq;
+    do {
+        seq = state_read_begin(state, &state->iec_seq);
+        *iec_on = state->iec_on;
+        *rpm_iec = state->rpm_iec;
+        *temp_iec = state->temp_iec;
+    } while (seqlock_read_retry(&state->iec_seq, seq));
+}
+
+// Publishes a new power setpoint, replacing any setpoint the consumer has not taken yet.
+// The VMU block stays the source of truth: the VMU publishes ev/iec_power_level there before
+// posting, and engine physics reads the level with snapshot_power_levels(). For the engine a post
+// only announces that a new setpoint exists and when it was decided; `power_level` is kept as a
+// copy so the telemetry can show what the mailbox held.
+static inline void cmd_mailbox_post(CommandMailbox *mailbox, double power_level) {
+    seqlock_write_begin(&mailbox->seq);
+    mailbox->power_level = power_level;
+    mailbox->sent_ns = monotonic_ns();
+    mailbox->version++;
+    seqlock_write_end(&mailbox->seq);
+}
+
+// Returns true and the freshest setpoint if one was posted after *last_version (which is updated).
+// `sent_ns` (optional) receives the time the setpoint was posted.
+static inline bool cmd_mailbox_take(const CommandMailbox *mailbox, unsigned int *last_version, double *power_level, unsigned long long *sent_ns) {
+    seqcount_t seq;
+    unsigned int version;
+    double level;
+    unsigned long long sent;
+    do {
+        seq = seqlock_read_begin(&mailbox->seq);
+        version = mailbox->version;
+        level = mailbox->power_level;
+        sent = mailbox->sent_ns;
+    } while (seqlock_read_retry(&mailbox->seq, seq));
+
+    if (version == *last_version) {
+        return false;
+    }
+    *last_version = version;
+    *power_level = level;
+    if (sent_ns != NULL) {
+        *sent_ns = sent;
+    }
+    return true;
+}
+
 // Structure for messages (if needed for communication beyond commands)
 typedef struct {
     char command;
@@ -90,14 +270,31 @@ typedef enum {
 typedef struct {
     CommandType type;
     double power_level;
+    unsigned int seq;           // Per-engine sequence number assigned by the VMU (0 = untraced)
+    unsigned long long sent_ns; // CLOCK_MONOTONIC time the VMU issued the command (0 = untraced)
 } EngineCommand;
 
+// Transport used to deliver EngineCommand messages from the VMU to the engine modules
+typedef enum {
+    TRANSPORT_MQ,   // POSIX message queues (default)
+    TRANSPORT_RING  // Lock-free single-producer/single-consumer rings in shared memory
+} CommandTransport;
+
+// How the EV and IEC modules are run
+typedef enum {
+    RUNTIME_PROCESSES, // Separate executables attached to the named segments (default)
+    RUNTIME_THREADS    // Threads of the VMU process on anonymous memory (see engine_thread.h)
+} ModuleRuntime;
+
+typedef struct VehicleState VehicleState; // See vmu_model.h
+
 // Function prototypes
 void set_acceleration(bool accelerate);
 void set_braking(bool brake);
 double calculate_speed(SystemState *state);
 void vmu_control_engines();
 void init_system_state(SystemState *state);
+void load_vehicle_state(const SystemState *state, VehicleState *vehicle);
 void display_status(const SystemState *state);
 void init_communication();
 void cleanup();
@@ -107,9 +304,13 @@ void handle_signal(int sig);
 // Declare global variables as extern
 extern SystemState *system_state;
 extern sem_t *sem;
-extern mqd_t ev_mq;
-extern mqd_t iec_mq;
 extern volatile sig_atomic_t running; // Main loop control flag
 extern volatile sig_atomic_t paused;  // Pause control flag
+extern CommandTransport command_transport; // Selected command transport
+extern ModuleRuntime module_runtime; // VMU only: engines as processes or as threads of the VMU
+extern bool power_mailbox; // True if CMD_SET_POWER goes through the mailboxes instead of the transport
+extern StateLockMode state_lock_mode; // Lock the VMU sets up in the shared segment
+extern bool interactive_input; // False if the pedals come from a trace file instead of the terminal
+extern int input_priority; // SCHED_FIFO priority of the input thread, 0 for the normal scheduler
 
 #endif
\ No newline at end of file
@@ -0,0 +1,409 @@
+// Vehicle Management Unit control law and vehicle dynamics, free of any shared memory or IPC.
+// Used by the VMU process and by the headless simulation so both run exactly the same model.
+
+#include <math.h>
+#include "vmu_model.h"
+
+// Initial state of a parked vehicle with full battery and tank
+void init_vehicle_state(VehicleState *vehicle) {
+    vehicle->accelerator = false;
+    vehicle->brake = false;
+    vehicle->speed = MIN_SPEED;
+    vehicle->battery = MAX_BATTERY;
+    vehicle->fuel = MAX_FUEL;
+    vehicle->power_mode = 4; // Parked mode initially
+    vehicle->ev_power_level = 0.0;
+    vehicle->iec_power_level = 0.0;
+    vehicle->was_accelerating = false;
+    vehicle->ev_on = false;
+    vehicle->rpm_ev = 0;
+    vehicle->temp_ev = 25.0;
+    vehicle->iec_on = false;
+    vehicle->rpm_iec = 0;
+    vehicle->temp_iec = 25.0;
+}
+
+// One step of the VMU control law. Decides the desired engine states and ramps the commanded
+// power levels from the pedals and the engine status reported in `vehicle`, updates the VMU
+// fields (power levels, mode, battery, fuel) and returns the commands to send to the engines.
+void vmu_control_model(VehicleState *vehicle, ControlCommands *commands) {
+    double current_speed = vehicle->speed;
+    double current_battery = vehicle->battery;
+    double current_fuel = vehicle->fuel;
+    bool current_accelerator = vehicle->accelerator;
+    bool current_brake = vehicle->brake;
+    bool current_ev_on = vehicle->ev_on;
+    bool current_iec_on = vehicle->iec_on;
+    double current_ev_power_level = vehicle->ev_power_level;
+    double current_iec_power_level = vehicle->iec_power_level;
+    bool was_accelerating = vehicle->was_accelerating;
+    int power_mode = vehicle->power_mode;
+
+    double target_ev_power = 0.0;
+    double target_iec_power = 0.0;
+    bool battery_ok = (current_battery > BATTERY_CRITICAL_THRESHOLD);
+    bool fuel_ok = (current_fuel > FUEL_CRITICAL_THRESHOLD);
+
+    // Determine the *desired* state (on/off) and target power levels based on VMU logic
+    bool desired_ev_on;
+    bool desired_iec_on;
+
+    // Use local variables for power levels during calculation and ramping
+    double calculated_ev_power_level = current_ev_power_level; // Start ramp from current commanded level
+    double calculated_iec_power_level = current_iec_power_level; // Start ramp from current commanded level
+
+    bool new_was_accelerating = was_accelerating; // Update was_accelerating locally
+    int new_power_mode = power_mode; // Calculate new power mode
+
+
+    // --- VMU Logic to Determine Desired State and Target Power ---
+    if (current_accelerator) {
+        
+        new_was_accelerating = true;
+
+        if (battery_ok && fuel_ok) {
+            // Common mode (EV Only or Hybrid)
+            if (current_speed < ELECTRIC_ONLY_SPEED_THRESHOLD) {
+                // (< 40 km/h)
+                new_power_mode = 0; // EV Only Mode
+                desired_iec_on = false;
+                target_iec_power = 0.0;
+
+                desired_ev_on = true;
+                target_ev_power = 0.1 + (current_speed - MIN_SPEED) / (ELECTRIC_ONLY_SPEED_THRESHOLD - MIN_SPEED);
+                target_ev_power = fmin(fmax(target_ev_power, 0.0), 1.0);
+
+            } else {
+                // (>= 40 km/h)
+                new_power_mode = 1; // Hybrid Mode
+                desired_ev_on = true;
+                target_ev_power = 1.0; // EV provides full power in hybrid acceleration
+
+                desired_iec_on = true;
+                // IEC power scales with speed after EV_ONLY_SPEED_THRESHOLD
+                target_iec_power = 0.1 + (current_speed - ELECTRIC_ONLY_SPEED_THRESHOLD) / (IEC_MAX_POWER_SPEED - ELECTRIC_ONLY_SPEED_THRESHOLD);
+                target_iec_power = fmin(fmax(target_iec_power, 0.0), 1.0);
+            }
+        } else if (!battery_ok && fuel_ok) {
+            
+             new_power_mode = 2; // IEC Only mode
+             desired_ev_on = false; // Ensure EV motor is off
+             target_ev_power = 0.0; // Ensure EV power is zero
+
+             // Use IEC for propulsion and charging
+             desired_iec_on = true; // Ensure IEC motor is on
+             // IEC power scales with speed for propulsion
+             target_iec_power = 0.1 + (current_speed) / (IEC_MAX_POWER_SPEED);
+             target_iec_power = fmin(fmax(target_iec_power, 0.0), 1.0);
+
+             // Note: The transition back to hybrid is implicitly handled
+             // in the next cycle when battery_ok becomes true.
+
+        } else if (battery_ok && !fuel_ok) {
+            new_power_mode = 0; // EV Only mode
+            desired_iec_on = false; // Ensure IEC motor is off
+            target_iec_power = 0.0; // Ensure IEC power is zero
+
+            desired_ev_on = true; // Ensure EV motor is on
+            if (current_speed < EV_ONLY_SPEED_LIMIT) {
+                 // EV power scales with speed up to limit
+                 target_ev_power = 0.1 + (current_speed - MIN_SPEED) / (EV_ONLY_SPEED_LIMIT - MIN_SPEED);
+                 target_ev_power = fmin(fmax(target_ev_power, 0.0), 1.0);
+            } else {
+                 // Speed limit reached, reduce EV power to maintain speed or slowly decelerate
+                 target_ev_power = fmax(0.0, 0.5 - (current_speed - EV_ONLY_SPEED_LIMIT) * 0.05); // Reduce power gradually above limit
+            }
+
+        } else {
+            new_power_mode = 4; // Emergency/No propulsion
+            desired_ev_on = false;
+            desired_iec_on = false;
+            target_ev_power = 0.0;
+            target_iec_power = 0.0;
+        }
+
+        // Ramp up power levels towards target when accelerating
+        if (calculated_ev_power_level < target_ev_power) {
+            calculated_ev_power_level = fmin(calculated_ev_power_level + POWER_INCREASE_RATE, target_ev_power);
+        } else if (calculated_ev_power_level > target_ev_power) {
+            calculated_ev_power_level = fmax(calculated_ev_power_level - POWER_DECREASE_RATE, target_ev_power);
+        }
+
+        if (calculated_iec_power_level < target_iec_power) {
+            calculated_iec_power_level = fmin(calculated_iec_power_level + POWER_INCREASE_RATE, target_iec_power);
+        } else if (calculated_iec_power_level > target_iec_power) {
+            calculated_iec_power_level = fmax(calculated_iec_power_level - POWER_DECREASE_RATE, target_iec_power);
+        }
+
+
+    } else { // Not accelerating
+        new_was_accelerating = false;
+        target_ev_power = 0.0; // Target is zero when not accelerating
+        target_iec_power = 0.0; // Target is zero when not accelerating (except for charging)
+
+        // Decrease power levels towards zero when not accelerating
+        calculated_ev_power_level = fmax(calculated_ev_power_level - POWER_DECREASE_RATE, 0.0);
+        calculated_iec_power_level = fmax(calculated_iec_power_level - POWER_DECREASE_RATE, 0.0);
+
+        // Determine desired engine states when not accelerating
+        // Default to off, exceptions below
+        desired_ev_on = false;
+        desired_iec_on = false;
+
+        // Keep IEC on for charging if conditions met
+        bool keep_iec_for_charge = (!current_accelerator && !current_brake && // Not actively accelerating or braking
+                                     current_speed > MIN_SPEED && // Vehicle is moving (coast charging)
+                                     current_battery < 100 * 0.8 && // Battery not full
+                                     fuel_ok);
+
+        // If in !battery ok && fuel ok state and not accelerating/braking, keep IEC on for charging regardless of speed (if fuel ok)
+        if (!battery_ok && fuel_ok && !current_brake) {
+             keep_iec_for_charge = true;
+             target_iec_power = 0.2; // Use a fixed power level for charging when stationary or coasting
+             // Ramp up to charging power if below it
+             if (calculated_iec_power_level < target_iec_power) {
+                  calculated_iec_power_level = fmin(calculated_iec_power_level + POWER_INCREASE_RATE, target_iec_power);
+             }
+             desired_iec_on = true; // Ensure IEC is on for charging
+        } 
+
+
+        // Regenerative braking logic determines power mode, but doesn't necessarily keep EV motor 'on' for propulsion
+        if (current_brake && current_speed > MIN_SPEED) {
+            new_power_mode = 3; // Regenerative Braking mode
+             desired_ev_on = false; // VMU is not requesting EV propulsion
+             desired_iec_on = false; // IEC is off during regen braking
+        } else if (current_speed > MIN_SPEED) {
+             // Coasting modes - Engines should ideally be off unless needed for charging
+             desired_ev_on = false; // Not requesting EV propulsion while coasting
+        } else { // Vehicle is stopped or near stopped
+             desired_ev_on = false; // EV is off when stopped and not accelerating/braking
+        }
+
+         // If calculated power levels drop very low, set desired_on to false,
+         // unless kept on for charging.
+         if (!keep_iec_for_charge && calculated_iec_power_level < 0.01) desired_iec_on = false;
+         if (calculated_ev_power_level < 0.01) desired_ev_on = false;
+
+
+        // Determine power mode when not accelerating - based on desired state
+        if (current_brake && current_speed > MIN_SPEED) {
+            new_power_mode = 3; // Regenerative Braking
+        } else if (current_speed > MIN_SPEED) {
+             // Coasting modes - based on which engines are desired to be on
+             if (desired_ev_on && desired_iec_on) new_power_mode = 1; // Hybrid Coasting
+             else if (desired_ev_on) new_power_mode = 0; // EV Only Coasting
+             else if (desired_iec_on) new_power_mode = 2; // IEC Only Coasting (possibly charging)
+             else new_power_mode = 4; // Coasting without propulsion (engines off)
+        } else { // Vehicle stopped
+             if(desired_iec_on) { // IEC kept on for charging while stopped
+                 new_power_mode = 5; // IEC Charging/Idle
+             } else {
+                 new_power_mode = 4; // Engines off
+             }
+        }
+    }
+
+    // --- Command Preparation ---
+    // Based on current actual state (read from shared memory) and desired state (calculated by VMU), prepare commands to send to modules.
+
+    // EV Commands: Prioritize state changes (START/STOP), then send power levels if engine is ON.
+    EngineCommand final_ev_cmd = {0};
+    bool final_send_ev_cmd = false;
+
+    if (desired_ev_on && !current_ev_on) {
+        final_ev_cmd.type = CMD_START;
+        final_send_ev_cmd = true;
+    } else if (!desired_ev_on && current_ev_on) {
+        final_ev_cmd.type = CMD_STOP;
+        final_send_ev_cmd = true;
+    }
+
+    // If engine is ON, always send the current calculated power level.
+    // This will update the module's power even if a START command was sent in a previous cycle
+    // and the module is now reporting ON.
+    if (current_ev_on) {
+         // If a STOP command was prepared in this cycle, don't send SET_POWER.
+         if (final_ev_cmd.type != CMD_STOP) {
+             final_ev_cmd.type = CMD_SET_POWER; // SET_POWER command
+             final_ev_cmd.power_level = calculated_ev_power_level;
+             final_send_ev_cmd = true;
+         }
+    }
+
+    // IEC Commands (Refined Logic similar to EV)
+    EngineCommand final_iec_cmd = {0};
+    bool final_send_iec_cmd = false;
+
+     if (desired_iec_on && !current_iec_on) {
+         final_iec_cmd.type = CMD_START;
+         final_send_iec_cmd = true;
+     } else if (!desired_iec_on && current_iec_on) {
+          final_iec_cmd.type = CMD_STOP;
+          final_send_iec_cmd = true;
+     }
+
+     if (current_iec_on) {
+          if (final_iec_cmd.type != CMD_STOP) {
+              final_iec_cmd.type = CMD_SET_POWER; // SET_POWER command
+              final_iec_cmd.power_level = calculated_iec_power_level;
+              final_send_iec_cmd = true;
+          }
+     }
+
+
+    // Calculate battery and fuel consumption/recharge based on *actual* engine state (from shared memory)
+    // and *commanded* power levels (calculated by VMU for this cycle).
+    double new_battery = current_battery; // Start with current state
+    double new_fuel = current_fuel;       // Start with current state
+
+    // Consume battery when EV is actually ON and commanded to provide power (> 0)
+    if (current_ev_on && calculated_ev_power_level > 0) {
+         new_battery -= calculated_ev_power_level * BATTERY_CONSUMPTION_RATE;
+         if (new_battery < 0.0) new_battery = 0.0;
+    }
+
+    // Consume fuel only when IEC is actually ON and commanded to provide power (> 0)
+    if (current_iec_on && calculated_iec_power_level > 0) {
+          new_fuel -= calculated_iec_power_level * FUEL_CONSUMPTION_RATE;
+          if (new_fuel < 0.0) new_fuel = 0.0;
+    }
+
+    // Recharge when IEC is actually ON and fuel is available.
+    if (current_iec_on && fuel_ok && new_battery < 100) {
+         new_battery += IEC_RECHARGE_RATE;
+         if (new_battery > 100) new_battery = 100;
+    }
+
+    // Regenerative braking logic - recharge battery when braking or coasting
+    // This logic uses current speed and brake state to calculate the regen amount.
+    if (!current_accelerator && current_speed > MIN_SPEED && new_battery < 100) { // Only regenerate if battery is not full and car is moving/braking
+         if (current_brake) {
+             new_battery += REGEN_BRAKE_RATE * (current_speed / MAX_SPEED);
+             if (new_battery > 100) new_battery = 100;
+         } else {
+             // Regenerative braking can happen slightly even when coasting at speed
+             new_battery += REGEN_COAST_RATE * (current_speed / MAX_SPEED);
+             if (new_battery > 100) new_battery = 100;
+         }
+     }
+
+
+    
+    // This represents the mode the VMU is attempting to achieve.
+     if (!current_accelerator && !current_brake && current_speed < MIN_SPEED + 0.1 && !desired_ev_on && !desired_iec_on) {
+           new_power_mode = 4; // Parked/Coasting
+     } else if (current_brake && current_speed > MIN_SPEED) {
+           new_power_mode = 3; // Regenerative Braking
+     } else if (desired_ev_on && !desired_iec_on) {
+           new_power_mode = 0; // EV Only (VMU is requesting EV only)
+     } else if (desired_ev_on && desired_iec_on) {
+           new_power_mode = 1; // Hybrid (VMU is requesting both)
+     } else if (!desired_ev_on && desired_iec_on) {
+           // Differentiate between IEC propulsion and IEC charging based on acceleration
+           if (current_accelerator) {
+               new_power_mode = 2; // IEC Only Propulsion (VMU requesting IEC only while accelerating)
+           } else {
+               new_power_mode = 5; // IEC Charging/Idle (VMU requesting IEC only while not accelerating, likely for charge)
+           }
+     } else {
+           new_power_mode = 4; // Coasting/Emergency without propulsion (Neither engine desired on)
+     }
+
+
+    vehicle->ev_power_level = calculated_ev_power_level;
+    vehicle->iec_power_level = calculated_iec_power_level;
+    vehicle->was_accelerating = new_was_accelerating;
+    vehicle->power_mode = new_power_mode;
+    vehicle->battery = new_battery;
+    vehicle->fuel = new_fuel;
+
+    commands->ev = final_ev_cmd;
+    commands->send_ev = final_send_ev_cmd;
+    commands->iec = final_iec_cmd;
+    commands->send_iec = final_send_iec_cmd;
+}
+
+// Calculates the vehicle speed after one step from the pedals, engine status and commanded power
+// Note: This is a simplified physics model.
+double speed_model(const VehicleState *vehicle) {
+    double current_speed_kmh = vehicle->speed;
+    bool is_accelerating = vehicle->accelerator;
+    bool is_braking = vehicle->brake;
+    double ev_power_level = vehicle->ev_power_level;
+    double iec_power_level = vehicle->iec_power_level;
+    bool ev_on = vehicle->ev_on;
+    bool iec_on = vehicle->iec_on;
+
+    double speed_change = 0.0;
+
+    if (is_accelerating) {
+        // --- For acceleration: simple linear relationship between power and speed increase ---
+        
+        // EV contribution - only up to 70 km/h
+        double ev_contribution = 0.0;
+        if (ev_on && current_speed_kmh <= 70.0) {
+            // Linear contribution based on power level
+            // Reduce contribution as we approach the 70 km/h limit
+            if (current_speed_kmh > 60.0) {
+                double fade_factor = 1.0 - ((current_speed_kmh - 60.0) / 10.0);
+                ev_contribution = ev_power_level * fade_factor; // Simple linear factor
+            } else {
+                ev_contribution = ev_power_level* 5; // Simple acceleration rate
+            }
+        }
+        
+        // IEC contribution at all speeds
+        double iec_contribution = 0.0;
+        if (iec_on) {
+            iec_contribution = iec_power_level * 5; // Simple linear factor
+        }
+        
+        // Total acceleration is the sum of both contributions
+        speed_change = ev_contribution + iec_contribution;
+        
+        // Simple speed-dependent efficiency loss (slower acceleration at higher speeds)
+        double efficiency_factor = 1.0 - (current_speed_kmh / MAX_SPEED) * 0.8;
+        speed_change *= efficiency_factor;
+        
+    } else {
+        // --- When not accelerating: simple deceleration ---
+        
+        // Base deceleration rate (air resistance, rolling resistance, etc.)
+        double base_deceleration = 0.05; // Base deceleration rate when coasting
+        
+        // Speed-dependent deceleration (higher speeds decelerate faster)
+        double speed_factor = current_speed_kmh / 50.0; // Normalized to 50 km/h
+        double deceleration = base_deceleration * (1.0 + speed_factor * 0.5);
+        
+        // Engine braking effect
+        if (current_speed_kmh > 1.0) {
+            if (ev_on) deceleration += 0.2;
+            if (iec_on) deceleration += 0.4;
+        }
+        
+        // Apply deceleration
+        speed_change = -deceleration;
+        
+        // Additional braking force if brake is pressed
+        if (is_braking && current_speed_kmh > 0.001) {
+            // Simple linear braking model
+            double brake_force = 10; // Base braking rate
+            
+            speed_change -= brake_force; 
+        }
+    }
+    
+    // Apply smoothing for more natural feel
+    speed_change *= SPEED_CHANGE_SMOOTHING;
+    
+    // Update speed
+    double new_speed = current_speed_kmh + speed_change;
+    
+    // Ensure speed stays within limits
+    if (new_speed < MIN_SPEED) new_speed = MIN_SPEED;
+    if (new_speed > MAX_SPEED) new_speed = MAX_SPEED;
+
+
+    return new_speed;
+}
@@ -0,0 +1,44 @@
+// vmu_model.h
+#ifndef VMU_MODEL_H
+#define VMU_MODEL_H
+
+#include <stdbool.h>
+#include "vmu.h"
+
+// Plain (unshared) copy of one vehicle's state. The module processes load it from and publish it
+// to the SystemState blocks; the headless simulation steps it directly.
+typedef struct VehicleState {
+    // Pedals
+    bool accelerator;
+    bool brake;
+    // VMU
+    double speed;
+    double battery;
+    double fuel;
+    int power_mode;
+    double ev_power_level;
+    double iec_power_level;
+    bool was_accelerating;
+    // EV
+    bool ev_on;
+    int rpm_ev;
+    double temp_ev;
+    // IEC
+    bool iec_on;
+    int rpm_iec;
+    double temp_iec;
+} VehicleState;
+
+// Commands decided by one control step
+typedef struct {
+    EngineCommand ev;
+    bool send_ev;
+    EngineCommand iec;
+    bool send_iec;
+} ControlCommands;
+
+void init_vehicle_state(VehicleState *vehicle);
+void vmu_control_model(VehicleState *vehicle, ControlCommands *commands);
+double speed_model(const VehicleState *vehicle);
+
+#endif
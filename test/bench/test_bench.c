@@ -0,0 +1,174 @@
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "../../src/bench/bench.h"
+
+// --- Drive cycle tests ---
+
+START_TEST(test_cycles_parse)
+{
+    for (int i = 0; i < drive_cycle_count; i++) {
+        Simulation sim;
+        PedalScript script;
+        ck_assert_msg(bench_cycle_start(&sim, &drive_cycles[i], &script), "Bad script in cycle %s", drive_cycles[i].name);
+        ck_assert(sim.vehicle.battery == drive_cycles[i].battery);
+        ck_assert(sim.vehicle.fuel == drive_cycles[i].fuel);
+        ck_assert_int_ge(drive_cycles[i].repeat, 1);
+        ck_assert_ptr_eq(find_drive_cycle(drive_cycles[i].name), &drive_cycles[i]);
+    }
+    ck_assert_ptr_eq(find_drive_cycle("moon_landing"), NULL);
+}
+END_TEST
+
+START_TEST(test_control_branch)
+{
+    VehicleState vehicle;
+    init_vehicle_state(&vehicle);
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_STOPPED);
+
+    vehicle.accelerator = true;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_ACCEL_EV);
+    vehicle.speed = ELECTRIC_ONLY_SPEED_THRESHOLD;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_ACCEL_HYBRID);
+    vehicle.battery = BATTERY_CRITICAL_THRESHOLD;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_ACCEL_IEC_ONLY);
+    vehicle.fuel = FUEL_CRITICAL_THRESHOLD;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_ACCEL_NO_PROPULSION);
+    vehicle.battery = MAX_BATTERY;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_ACCEL_LOW_FUEL);
+    vehicle.speed = EV_ONLY_SPEED_LIMIT;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_ACCEL_LOW_FUEL_LIMIT);
+
+    vehicle.accelerator = false;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_COAST);
+    vehicle.brake = true;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_REGEN_BRAKE);
+    vehicle.brake = false;
+    vehicle.battery = 5.0;
+    vehicle.fuel = MAX_FUEL;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_COAST_CHARGE);
+    vehicle.speed = MIN_SPEED;
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_STOPPED_CHARGE);
+    vehicle.brake = true; // Holding the brake at a standstill does not charge
+    ck_assert_int_eq(control_branch(&vehicle), BRANCH_STOPPED);
+}
+END_TEST
+
+START_TEST(test_cycles_cover_every_branch)
+{
+    unsigned long covered[BRANCH_COUNT] = {0};
+
+    for (int i = 0; i < drive_cycle_count; i++) {
+        CycleResult result;
+        ck_assert_int_eq(bench_run_cycle(&drive_cycles[i], 1, &result), 0);
+        for (int b = 0; b < BRANCH_COUNT; b++) {
+            covered[b] += result.branches[b];
+        }
+    }
+    for (int b = 0; b < BRANCH_COUNT; b++) {
+        ck_assert_msg(covered[b] > 0, "No drive cycle takes the %s path", control_branch_name(b));
+    }
+}
+END_TEST
+
+START_TEST(test_cycle_matches_sim)
+{
+    // The recorded run behind the report is the same drive bin/sim plays
+    const DriveCycle *cycle = find_drive_cycle("low_battery");
+    CycleResult result;
+    ck_assert_int_eq(bench_run_cycle(cycle, 1, &result), 0);
+
+    Simulation sim;
+    PedalScript script;
+    bench_cycle_start(&sim, cycle, &script);
+    sim_run_script(&sim, &script, cycle->repeat, NULL);
+
+    ck_assert_int_eq(result.vmu_steps, sim.vmu_steps);
+    ck_assert_int_eq(result.engine_steps, sim.engine_steps);
+    ck_assert_int_eq(result.commands, sim.commands);
+    ck_assert(result.battery == sim.vehicle.battery);
+    ck_assert(result.fuel == sim.vehicle.fuel);
+    ck_assert(result.distance_km == sim.distance_km);
+
+    unsigned long steps = 0;
+    for (int b = 0; b < BRANCH_COUNT; b++) {
+        steps += result.branches[b];
+    }
+    ck_assert_int_eq(steps, sim.vmu_steps);
+    ck_assert(result.ticks_per_second > 0.0);
+    for (int f = 0; f < BENCH_FN_COUNT; f++) {
+        ck_assert(result.function_ns[f] > 0.0);
+    }
+}
+END_TEST
+
+START_TEST(test_json_report)
+{
+    CycleResult results[2];
+    ck_assert_int_eq(bench_run_cycle(find_drive_cycle("urban"), 1, &results[0]), 0);
+    ck_assert_int_eq(bench_run_cycle(find_drive_cycle("highway"), 1, &results[1]), 0);
+
+    char buffer[8192] = {0};
+    FILE *out = fmemopen(buffer, sizeof(buffer) - 1, "w");
+    ck_assert_ptr_ne(out, NULL);
+    bench_write_json(out, results, 2, 1);
+    fclose(out);
+
+    ck_assert_ptr_ne(strstr(buffer, "\"format_version\": 1,"), NULL);
+    ck_assert_ptr_ne(strstr(buffer, "\"name\": \"urban\""), NULL);
+    ck_assert_ptr_ne(strstr(buffer, "\"name\": \"highway\""), NULL);
+    ck_assert_ptr_ne(strstr(buffer, "\"ticks_per_second\": "), NULL);
+    ck_assert_ptr_ne(strstr(buffer, "\"vmu_control_model\": "), NULL);
+    ck_assert_ptr_ne(strstr(buffer, "\"end\": {\"battery\": "), NULL);
+    // Neither cycle drives on a critical battery
+    ck_assert_ptr_ne(strstr(buffer, "\"uncovered_branches\": [\"accelerate_iec_only\""), NULL);
+
+    // Balanced braces and brackets, ending the document
+    int depth = 0;
+    for (char *p = buffer; *p != '\0'; p++) {
+        if (*p == '{' || *p == '[') depth++;
+        if (*p == '}' || *p == ']') depth--;
+        ck_assert_int_ge(depth, 0);
+    }
+    ck_assert_int_eq(depth, 0);
+    ck_assert_str_eq(buffer + strlen(buffer) - 2, "}\n");
+}
+END_TEST
+
+// --- Main Test Suite Creation ---
+
+Suite *bench_suite(void) {
+    Suite *s;
+    TCase *tc_cycles; // Drive cycle tests
+
+    s = suite_create("Drive Cycle Benchmark Tests");
+
+    tc_cycles = tcase_create("DriveCycles");
+    tcase_set_timeout(tc_cycles, 30);
+    tcase_add_test(tc_cycles, test_cycles_parse);
+    tcase_add_test(tc_cycles, test_control_branch);
+    tcase_add_test(tc_cycles, test_cycles_cover_every_branch);
+    tcase_add_test(tc_cycles, test_cycle_matches_sim);
+    tcase_add_test(tc_cycles, test_json_report);
+    suite_add_tcase(s, tc_cycles);
+
+    return s;
+}
+
+int main(void) {
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = bench_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1637 @@
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sched.h>
+
+#include "../../src/common/cmd_ring.h"
+#include "../../src/common/options.h"
+#include "../../src/common/tick.h"
+#include "../../src/common/clock.h"
+#include "../../src/common/histogram.h"
+#include "../../src/common/cmd_trace.h"
+#include "../../src/common/pedal_trace.h"
+#include "../../src/common/telemetry.h"
+#include "../../src/common/screen.h"
+#include "../../src/common/observer.h"
+#include "../../src/common/rt.h"
+#include "../../src/common/transport.h"
+#include "../../src/common/engine_thread.h"
+#include "../../src/common/engine_loop.h"
+
+#define TEST_RING_NAME "/test_common_command_ring"
+
+static CommandRing *ring = NULL;
+
+// --- Test Fixture Setup Function ---
+void ring_setup(void) {
+    ring = open_command_ring(TEST_RING_NAME, true);
+    ck_assert_ptr_ne(ring, NULL);
+}
+
+// --- Test Fixture Teardown Function ---
+void ring_teardown(void) {
+    close_command_ring(ring);
+    shm_unlink(TEST_RING_NAME);
+    ring = NULL;
+}
+
+// --- Command ring tests ---
+
+START_TEST(test_ring_pop_empty)
+{
+    EngineCommand cmd;
+    errno = 0;
+    ck_assert_int_eq(cmd_ring_pop(ring, &cmd), -1);
+    ck_assert_int_eq(errno, EAGAIN);
+}
+END_TEST
+
+START_TEST(test_ring_push_pop_order)
+{
+    EngineCommand start = { .type = CMD_START };
+    EngineCommand power = { .type = CMD_SET_POWER, .power_level = 0.4 };
+    EngineCommand end = { .type = CMD_END };
+    EngineCommand out;
+
+    ck_assert_int_eq(cmd_ring_push(ring, &start), 0);
+    ck_assert_int_eq(cmd_ring_push(ring, &power), 0);
+    ck_assert_int_eq(cmd_ring_push(ring, &end), 0);
+
+    // Commands must come out in the order they were sent, like the message queues
+    ck_assert_int_eq(cmd_ring_pop(ring, &out), 0);
+    ck_assert_int_eq(out.type, CMD_START);
+    ck_assert_int_eq(cmd_ring_pop(ring, &out), 0);
+    ck_assert_int_eq(out.type, CMD_SET_POWER);
+    ck_assert_msg(out.power_level == 0.4, "Power level should be carried by the ring");
+    ck_assert_int_eq(cmd_ring_pop(ring, &out), 0);
+    ck_assert_int_eq(out.type, CMD_END);
+    ck_assert_int_eq(cmd_ring_pop(ring, &out), -1);
+}
+END_TEST
+
+START_TEST(test_ring_full)
+{
+    EngineCommand cmd = { .type = CMD_SET_POWER };
+
+    for (int i = 0; i < CMD_RING_CAPACITY; i++) {
+        ck_assert_int_eq(cmd_ring_push(ring, &cmd), 0);
+    }
+
+    // A full ring rejects the command instead of overwriting unread slots
+    errno = 0;
+    ck_assert_int_eq(cmd_ring_push(ring, &cmd), -1);
+    ck_assert_int_eq(errno, EAGAIN);
+}
+END_TEST
+
+START_TEST(test_ring_wraparound)
+{
+    EngineCommand in = { .type = CMD_SET_POWER };
+    EngineCommand out;
+
+    // Cycle through the slots several times to exercise index wraparound
+    for (int i = 0; i < CMD_RING_CAPACITY * 3 + 1; i++) {
+        in.power_level = i;
+        ck_assert_int_eq(cmd_ring_push(ring, &in), 0);
+        ck_assert_int_eq(cmd_ring_pop(ring, &out), 0);
+        ck_assert_msg(out.power_level == i, "Unexpected command after wraparound");
+    }
+}
+END_TEST
+
+START_TEST(test_ring_shared_between_mappings)
+{
+    // A second mapping (as opened by an engine module) sees the producer's commands
+    CommandRing *consumer = open_command_ring(TEST_RING_NAME, false);
+    ck_assert_ptr_ne(consumer, NULL);
+
+    EngineCommand in = { .type = CMD_STOP };
+    EngineCommand out;
+    ck_assert_int_eq(cmd_ring_push(ring, &in), 0);
+    ck_assert_int_eq(cmd_ring_pop(consumer, &out), 0);
+    ck_assert_int_eq(out.type, CMD_STOP);
+
+    close_command_ring(consumer);
+}
+END_TEST
+
+START_TEST(test_ring_reset_discards_pending)
+{
+    EngineCommand in = { .type = CMD_START };
+    EngineCommand out;
+    ck_assert_int_eq(cmd_ring_push(ring, &in), 0);
+
+    // Re-creating the ring (VMU restart) must not replay stale commands
+    CommandRing *fresh = open_command_ring(TEST_RING_NAME, true);
+    ck_assert_ptr_ne(fresh, NULL);
+    ck_assert_int_eq(cmd_ring_pop(fresh, &out), -1);
+    close_command_ring(fresh);
+}
+END_TEST
+
+START_TEST(test_ring_wait_pending)
+{
+    EngineCommand in = { .type = CMD_START };
+    struct timespec timeout = { 1, 0 };
+    ck_assert_int_eq(cmd_ring_push(ring, &in), 0);
+
+    // A pending command is reported without sleeping
+    ck_assert_int_eq(cmd_ring_wait(ring, &timeout), 1);
+}
+END_TEST
+
+START_TEST(test_ring_wait_timeout)
+{
+    struct timespec timeout = { 0, 20000000 }; // 20 ms
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ck_assert_int_eq(cmd_ring_wait(ring, &timeout), 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    ck_assert_msg(elapsed >= 0.015, "Empty ring should block until the timeout");
+    ck_assert_int_eq(ring->sleeping, 0);
+}
+END_TEST
+
+START_TEST(test_ring_wait_woken_by_push)
+{
+    // A producer in another process rings the doorbell while the consumer sleeps
+    pid_t pid = fork();
+    ck_assert_int_ne(pid, -1);
+    if (pid == 0) {
+        CommandRing *producer = open_command_ring(TEST_RING_NAME, false);
+        EngineCommand in = { .type = CMD_STOP };
+        usleep(20000);
+        cmd_ring_push(producer, &in);
+        _exit(0);
+    }
+
+    struct timespec timeout = { 5, 0 };
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ck_assert_int_eq(cmd_ring_wait(ring, &timeout), 1);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    waitpid(pid, NULL, 0);
+
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    ck_assert_msg(elapsed < 1.0, "Push should wake the consumer well before the timeout");
+}
+END_TEST
+
+// --- Power setpoint mailbox tests ---
+
+START_TEST(test_mailbox_empty)
+{
+    CommandMailbox mailbox = {0};
+    unsigned int last_version = 0;
+    double power_level = -1.0;
+
+    ck_assert_msg(!cmd_mailbox_take(&mailbox, &last_version, &power_level, NULL), "Empty mailbox should have nothing to take");
+    ck_assert_msg(power_level == -1.0, "Power level should be untouched when nothing is taken");
+}
+END_TEST
+
+START_TEST(test_mailbox_coalesces_setpoints)
+{
+    CommandMailbox mailbox = {0};
+    unsigned int last_version = 0;
+    double power_level = 0.0;
+
+    cmd_mailbox_post(&mailbox, 0.1);
+    cmd_mailbox_post(&mailbox, 0.2);
+    cmd_mailbox_post(&mailbox, 0.3);
+
+    // Superseded setpoints are never delivered, only the freshest one
+    ck_assert_msg(cmd_mailbox_take(&mailbox, &last_version, &power_level, NULL), "Posted setpoint should be taken");
+    ck_assert_msg(power_level == 0.3, "Only the latest setpoint should be delivered");
+    ck_assert_int_eq(last_version, 3);
+    ck_assert_msg(!cmd_mailbox_take(&mailbox, &last_version, &power_level, NULL), "Setpoint should be taken only once");
+    ck_assert_int_eq(mailbox.seq & 1U, 0);
+}
+END_TEST
+
+START_TEST(test_mailbox_carries_post_time)
+{
+    CommandMailbox mailbox = {0};
+    unsigned int last_version = 0;
+    double power_level = 0.0;
+    unsigned long long sent_ns = 0;
+
+    unsigned long long before_ns = monotonic_ns();
+    cmd_mailbox_post(&mailbox, 0.6);
+    ck_assert_msg(cmd_mailbox_take(&mailbox, &last_version, &power_level, &sent_ns), "Posted setpoint should be taken");
+    ck_assert_uint_ge(sent_ns, before_ns);
+    ck_assert_uint_le(sent_ns, monotonic_ns());
+}
+END_TEST
+
+// --- Command trace tests ---
+
+START_TEST(test_trace_seq_gaps)
+{
+    unsigned int last_seq = 0;
+    ck_assert_int_eq(cmd_trace_seq(&last_seq, 1), 0);
+    ck_assert_int_eq(cmd_trace_seq(&last_seq, 2), 0);
+    ck_assert_int_eq(cmd_trace_seq(&last_seq, 5), 2);
+    ck_assert_int_eq(cmd_trace_seq(&last_seq, 0), 0); // Untraced commands are ignored
+    ck_assert_int_eq(last_seq, 5);
+    ck_assert_int_eq(cmd_trace_seq(&last_seq, 1), 0); // VMU restarted
+    ck_assert_int_eq(last_seq, 1);
+}
+END_TEST
+
+START_TEST(test_trace_records_by_type)
+{
+    ck_assert_ptr_ne(stats_open("/test_common_trace_stats", "iec"), NULL);
+
+    unsigned long long sent_ns = monotonic_ns() - 2000000ULL; // Issued 2 ms ago
+    cmd_trace(CMD_STOP, sent_ns, false);
+    cmd_trace(CMD_STOP, sent_ns, true);
+    cmd_trace(CMD_END, sent_ns, false); // Not traced
+    cmd_trace(CMD_START, 0, false);     // Untraced command
+
+    ck_assert_int_eq(stats_page->hist[STAT_STOP_RECEIVED].count, 1);
+    ck_assert_int_eq(stats_page->hist[STAT_STOP_APPLIED].count, 1);
+    ck_assert_uint_ge(stats_page->hist[STAT_STOP_RECEIVED].max_ns, 2000000ULL);
+    ck_assert_int_eq(stats_page->hist[STAT_START_RECEIVED].count, 0);
+
+    stats_close("/test_common_trace_stats");
+}
+END_TEST
+
+// --- Runtime options tests ---
+
+START_TEST(test_options_default_transport)
+{
+    char *argv[] = {"vmu", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(1, argv, &options), 1);
+    ck_assert_int_eq(options.transport, TRANSPORT_MQ);
+}
+END_TEST
+
+START_TEST(test_options_ring_transport)
+{
+    char *argv[] = {"ev", "--transport=ring", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 1);
+    ck_assert_int_eq(options.transport, TRANSPORT_RING);
+}
+END_TEST
+
+START_TEST(test_options_mailbox)
+{
+    char *argv[] = {"vmu", "--transport=ring", "--mailbox", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(3, argv, &options), 1);
+    ck_assert_int_eq(options.transport, TRANSPORT_RING);
+    ck_assert_msg(options.power_mailbox, "Mailbox mode should be enabled");
+}
+END_TEST
+
+START_TEST(test_options_invalid_transport)
+{
+    char *argv[] = {"iec", "--transport=carrier-pigeon", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 0);
+}
+END_TEST
+
+START_TEST(test_options_period_and_policy)
+{
+    char *argv[] = {"vmu", "--period=12.5", "--tick-policy=skip", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(3, argv, &options), 1);
+    ck_assert_int_eq(options.period_ns, 12500000L);
+    ck_assert_int_eq(options.tick_policy, TICK_SKIP);
+}
+END_TEST
+
+START_TEST(test_options_invalid_period)
+{
+    char *argv[] = {"ev", "--period=0", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 0);
+}
+END_TEST
+
+// --- Tick scheduler tests ---
+
+START_TEST(test_tick_advance_on_time)
+{
+    TickScheduler sched;
+    tick_init(&sched, 10000000L, TICK_CATCH_UP);
+    struct timespec deadline = sched.next;
+
+    ck_assert_msg(!tick_due(&sched, &(struct timespec){ deadline.tv_sec - 1, deadline.tv_nsec }), "Tick should not be due before its deadline");
+    ck_assert_msg(tick_due(&sched, &deadline), "Tick should be due at its deadline");
+
+    tick_advance(&sched, &deadline);
+    timespec_add_ns(&deadline, 10000000L);
+    ck_assert_int_eq(timespec_cmp(&sched.next, &deadline), 0); // Exactly one period later, no drift
+    ck_assert_int_eq(sched.ticks, 1);
+    ck_assert_int_eq(sched.overruns, 0);
+}
+END_TEST
+
+START_TEST(test_tick_catch_up)
+{
+    TickScheduler sched;
+    tick_init(&sched, 10000000L, TICK_CATCH_UP);
+    struct timespec first = sched.next;
+    struct timespec now = first;
+    timespec_add_ns(&now, 25000000L); // 2.5 periods late
+
+    tick_advance(&sched, &now);
+    ck_assert_int_eq(sched.overruns, 1);
+    ck_assert_int_eq(sched.skipped, 0);
+    ck_assert_msg(tick_due(&sched, &now), "Missed ticks should be due immediately when catching up");
+
+    tick_advance(&sched, &now);
+    tick_advance(&sched, &now);
+    ck_assert_msg(!tick_due(&sched, &now), "Schedule should be back on time after catching up");
+    ck_assert_int_eq(sched.ticks, 3);
+}
+END_TEST
+
+START_TEST(test_tick_catch_up_bounded)
+{
+    TickScheduler sched;
+    tick_init(&sched, 10000000L, TICK_CATCH_UP);
+    struct timespec now = sched.next;
+    timespec_add_ns(&now, (TICK_MAX_CATCH_UP + 3) * 10000000L); // e.g. stopped in a debugger
+
+    tick_advance(&sched, &now);
+    ck_assert_int_eq(sched.skipped, TICK_MAX_CATCH_UP + 3);
+    ck_assert_msg(!tick_due(&sched, &now), "A long stall should realign instead of bursting");
+}
+END_TEST
+
+START_TEST(test_tick_skip)
+{
+    TickScheduler sched;
+    tick_init(&sched, 10000000L, TICK_SKIP);
+    struct timespec first = sched.next;
+    struct timespec now = first;
+    timespec_add_ns(&now, 25000000L);
+
+    tick_advance(&sched, &now);
+    ck_assert_int_eq(sched.overruns, 1);
+    ck_assert_int_eq(sched.skipped, 2);
+
+    // Next deadline stays on the original grid
+    timespec_add_ns(&first, 30000000L);
+    ck_assert_int_eq(timespec_cmp(&sched.next, &first), 0);
+}
+END_TEST
+
+START_TEST(test_tick_wait_lateness)
+{
+    TickScheduler sched;
+    tick_init(&sched, 10000000L, TICK_CATCH_UP);
+    usleep(25000); // Miss two deadlines
+
+    long long late_ns = tick_wait(&sched);
+    ck_assert_msg(late_ns >= 15000000LL, "Lateness should be reported, got %lld ns", late_ns);
+    ck_assert_int_eq(sched.overruns, 1);
+}
+END_TEST
+
+START_TEST(test_tick_wait_rate)
+{
+    TickScheduler sched;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    tick_init(&sched, 5000000L, TICK_CATCH_UP);
+
+    for (int i = 0; i < 10; i++) {
+        usleep(2000); // Loop body cost must not stretch the period
+        tick_wait(&sched);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    ck_assert_int_eq(sched.ticks, 10);
+    ck_assert_msg(elapsed >= 0.050 && elapsed < 0.065, "10 ticks of 5 ms should take ~50 ms, took %f s", elapsed);
+}
+END_TEST
+
+// --- Latency histogram tests ---
+
+START_TEST(test_hist_bucket_bounds)
+{
+    // Exact below 16 ns, then every value lies within its bucket's range
+    ck_assert_int_eq(hist_bucket(0), 0);
+    ck_assert_int_eq(hist_bucket(15), 15);
+    unsigned long long values[] = {16, 17, 31, 32, 1000, 70000000ULL, 123456789ULL};
+    for (unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        unsigned int bucket = hist_bucket(values[i]);
+        ck_assert_uint_ge(hist_bucket_upper(bucket), values[i]);
+        ck_assert_uint_lt(hist_bucket_upper(bucket - 1), values[i]);
+    }
+    ck_assert_int_eq(hist_bucket(1ULL << 50), HIST_BUCKETS - 1); // Clamped
+}
+END_TEST
+
+START_TEST(test_hist_percentiles)
+{
+    LatencyHistogram hist;
+    memset(&hist, 0, sizeof(hist));
+    ck_assert_int_eq(hist_percentile(&hist, 50.0), 0);
+
+    for (int i = 1; i <= 1000; i++) {
+        hist_add(&hist, i * 1000ULL); // 1 us .. 1 ms
+    }
+    ck_assert_int_eq(hist.count, 1000);
+    ck_assert_int_eq(hist.max_ns, 1000000);
+
+    // Log-linear buckets keep the relative error within 1/16
+    unsigned long long p50 = hist_percentile(&hist, 50.0);
+    unsigned long long p99 = hist_percentile(&hist, 99.0);
+    ck_assert_uint_ge(p50, 500000);
+    ck_assert_uint_le(p50, 500000 + 500000 / 16);
+    ck_assert_uint_ge(p99, 990000);
+    ck_assert_uint_le(p99, 1000000);
+    ck_assert_int_eq(hist_percentile(&hist, 100.0), 1000000);
+}
+END_TEST
+
+START_TEST(test_stats_disabled)
+{
+    // Without a page, recording is a no-op and timestamps are free
+    ck_assert_ptr_eq(stats_page, NULL);
+    ck_assert_int_eq(stats_start(), 0);
+    stats_record(STAT_ENGINE, 1000);
+    stats_record_since(STAT_ENGINE, 0);
+}
+END_TEST
+
+START_TEST(test_options_pedal_trace)
+{
+    char *argv[] = {"vmu", "--pedal-trace=drive.trace", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 1);
+    ck_assert_str_eq(options.pedal_trace, "drive.trace");
+
+    ck_assert_int_eq(parse_runtime_options(1, argv, &options), 1);
+    ck_assert_ptr_eq(options.pedal_trace, NULL);
+}
+END_TEST
+
+START_TEST(test_options_telemetry)
+{
+    char *argv[] = {"vmu", "--telemetry=run.tlm", "--telemetry-records=1000", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(3, argv, &options), 1);
+    ck_assert_str_eq(options.telemetry, "run.tlm");
+    ck_assert_uint_eq(options.telemetry_records, 1000);
+
+    ck_assert_int_eq(parse_runtime_options(1, argv, &options), 1);
+    ck_assert_ptr_eq(options.telemetry, NULL);
+    ck_assert_uint_eq(options.telemetry_records, TELEMETRY_DEFAULT_RECORDS);
+
+    char *invalid[] = {"vmu", "--telemetry-records=0", NULL};
+    ck_assert_int_eq(parse_runtime_options(2, invalid, &options), 0);
+    invalid[1] = "--telemetry-records=-5";
+    ck_assert_int_eq(parse_runtime_options(2, invalid, &options), 0);
+}
+END_TEST
+
+START_TEST(test_options_display_rate)
+{
+    char *argv[] = {"vmu", "--display-rate=2.5", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(1, argv, &options), 1);
+    ck_assert(options.display_rate_hz == DISPLAY_RATE_HZ);
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 1);
+    ck_assert(options.display_rate_hz == 2.5);
+    argv[1] = "--display-rate=0";
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 1);
+    ck_assert(options.display_rate_hz == 0.0);
+    argv[1] = "--display-rate=-1";
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 0);
+    argv[1] = "--display-rate=fast";
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 0);
+}
+END_TEST
+
+START_TEST(test_options_realtime)
+{
+    char *argv[] = {"vmu", "--cpus=0,2-3", "--rt-priority=90,50", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(1, argv, &options), 1);
+    ck_assert(!options.rt.enabled);
+    ck_assert_uint_eq(options.rt.cpu_mask, 0);
+
+    ck_assert_int_eq(parse_runtime_options(3, argv, &options), 1);
+    ck_assert(options.rt.enabled); // A priority implies the profile
+    ck_assert_uint_eq(options.rt.cpu_mask, 0xD);
+    ck_assert_int_eq(options.rt.loop_priority, 90);
+    ck_assert_int_eq(options.rt.input_priority, 50);
+    ck_assert_int_eq(options.rt.observer_priority, RT_OBSERVER_PRIORITY);
+
+    argv[1] = "--rt";
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 1);
+    ck_assert(options.rt.enabled);
+    ck_assert_int_eq(options.rt.loop_priority, RT_LOOP_PRIORITY);
+
+    argv[1] = "--rt-priority=80,60,20,10";
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 0);
+    argv[1] = "--cpus=3-1";
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 0);
+}
+END_TEST
+
+START_TEST(test_options_state_lock)
+{
+    char *argv[] = {"vmu", "--state-lock=mutex", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(1, argv, &options), 1);
+    ck_assert_int_eq(options.state_lock, STATE_LOCK_SEM);
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 1);
+    ck_assert_int_eq(options.state_lock, STATE_LOCK_MUTEX);
+    argv[1] = "--state-lock=spinlock";
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 0);
+}
+END_TEST
+
+START_TEST(test_options_runtime)
+{
+    char *argv[] = {"vmu", "--runtime=threads", "--engine-period=35", NULL};
+    RuntimeOptions options;
+
+    ck_assert_int_eq(parse_runtime_options(1, argv, &options), 1);
+    ck_assert_int_eq(options.runtime, RUNTIME_PROCESSES);
+    ck_assert_int_eq(options.engine_period_ns, 0);
+    ck_assert_int_eq(parse_runtime_options(3, argv, &options), 1);
+    ck_assert_int_eq(options.runtime, RUNTIME_THREADS);
+    ck_assert_int_eq(options.engine_period_ns, 35000000L);
+    ck_assert_int_eq(options.period_ns, 0); // The VMU period is separate
+    argv[1] = "--runtime=fibers";
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 0);
+    argv[1] = "--engine-period=0";
+    ck_assert_int_eq(parse_runtime_options(2, argv, &options), 0);
+}
+END_TEST
+
+// --- Pedal Trace Tests ---
+
+START_TEST(test_pedal_trace_parse_formats)
+{
+    // Not NUL terminated, like a mapped file: the parser must stop at the length
+    const char text[] = "# warm up\n0 1\n\n2.5 0.8 0.0  # analog\n4 0.9 0.5\n6.25 0\n7 2x";
+    PedalTrace trace;
+
+    ck_assert_int_eq(pedal_trace_parse(text, strstr(text, "7 2x") - text, &trace), 0);
+    ck_assert_int_eq(trace.count, 4);
+    ck_assert_uint_eq(trace.events[0].time_ns, 0);
+    ck_assert(trace.events[0].accelerator && !trace.events[0].brake);
+    ck_assert_uint_eq(trace.events[1].time_ns, 2500000000ULL);
+    ck_assert(trace.events[1].accelerator && !trace.events[1].brake);
+    // Both pedals pressed: the brake wins
+    ck_assert(!trace.events[2].accelerator && trace.events[2].brake);
+    ck_assert_uint_eq(trace.events[3].time_ns, 6250000000ULL);
+    ck_assert(!trace.events[3].accelerator && !trace.events[3].brake);
+    pedal_trace_free(&trace);
+    ck_assert_ptr_eq(trace.events, NULL);
+}
+END_TEST
+
+START_TEST(test_pedal_trace_parse_invalid)
+{
+    PedalTrace trace;
+    const char *invalid[] = {
+        "1 3\n",          // Unknown pedal code
+        "1\n",            // Missing pedal
+        "1 0.5 1.5\n",    // Position out of range
+        "1 1 0 0\n",      // Too many columns
+        "-1 1\n",         // Negative time
+        "inf 1\n",        // Infinite time
+        "nan 1\n",        // Not a time
+        "1e30 1\n",       // Beyond the nanosecond clock
+        "18446744074 1\n", // Just beyond it
+        "2 1\n1 0\n",     // Time goes backwards
+        "one 1\n",        // Not a number
+        "# nothing\n\n",  // No events
+    };
+
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        ck_assert_msg(pedal_trace_parse(invalid[i], strlen(invalid[i]), &trace) == -1, "Accepted '%s'", invalid[i]);
+        ck_assert_ptr_eq(trace.events, NULL);
+    }
+}
+END_TEST
+
+START_TEST(test_pedal_trace_due)
+{
+    const char *text = "0 1\n1 0\n1 2\n3 0\n";
+    PedalTrace trace;
+    ck_assert_int_eq(pedal_trace_parse(text, strlen(text), &trace), 0);
+
+    ck_assert(pedal_trace_due(&trace, 0)->accelerator);
+    ck_assert_ptr_eq(pedal_trace_due(&trace, 999999999ULL), NULL);
+    // Events sharing a tick collapse to the last one
+    const PedalEvent *event = pedal_trace_due(&trace, 2000000000ULL);
+    ck_assert_ptr_ne(event, NULL);
+    ck_assert(event->brake);
+    ck_assert(!pedal_trace_done(&trace));
+    event = pedal_trace_due(&trace, 3000000000ULL);
+    ck_assert(!event->accelerator && !event->brake);
+    ck_assert(pedal_trace_done(&trace));
+    ck_assert_ptr_eq(pedal_trace_due(&trace, 4000000000ULL), NULL);
+    pedal_trace_free(&trace);
+}
+END_TEST
+
+START_TEST(test_pedal_trace_load)
+{
+    char path[] = "/tmp/test_pedal_trace_XXXXXX";
+    const char *text = "0 1\n10 0\n12 2\n";
+    int fd = mkstemp(path);
+    ck_assert_int_ne(fd, -1);
+    ck_assert_int_eq(write(fd, text, strlen(text)), (ssize_t)strlen(text));
+    close(fd);
+
+    PedalTrace trace;
+    ck_assert_int_eq(pedal_trace_load(path, &trace), 0);
+    ck_assert_int_eq(trace.count, 3);
+    ck_assert_uint_eq(trace.events[2].time_ns, 12000000000ULL);
+    ck_assert(trace.events[2].brake);
+    pedal_trace_free(&trace);
+
+    unlink(path);
+    ck_assert_int_eq(pedal_trace_load(path, &trace), -1);
+}
+END_TEST
+
+// --- Telemetry Tests ---
+
+static char telemetry_path[] = "/tmp/test_telemetry_XXXXXX";
+
+static void telemetry_setup(void) {
+    strcpy(telemetry_path, "/tmp/test_telemetry_XXXXXX");
+    int fd = mkstemp(telemetry_path);
+    ck_assert_int_ne(fd, -1);
+    close(fd);
+}
+
+static void telemetry_teardown(void) {
+    unlink(telemetry_path);
+}
+
+static void make_record(TelemetryRecord *record, uint64_t tick) {
+    VehicleState vehicle;
+    init_vehicle_state(&vehicle);
+    vehicle.speed = (double)tick;
+    vehicle.accelerator = tick % 2 == 0;
+    vehicle.rpm_iec = (int)tick * 10;
+
+    memset(record, 0, sizeof(*record));
+    record->tick = tick;
+    record->time_ns = tick * 200000000ULL;
+    telemetry_vehicle_pack(&vehicle, &record->before);
+    vehicle.speed += 0.5;
+    telemetry_vehicle_pack(&vehicle, &record->after);
+    record->ev_command = tick % 3 == 0 ? CMD_SET_POWER : TELEMETRY_NO_COMMAND;
+    record->iec_command = TELEMETRY_NO_COMMAND;
+}
+
+START_TEST(test_telemetry_create_append_open)
+{
+    TelemetryLog writer, reader;
+    TelemetryRecord record;
+
+    ck_assert_int_eq(telemetry_create(&writer, telemetry_path, 16, 200000000ULL, 0), 0);
+    ck_assert_uint_eq(telemetry_count(&writer), 0);
+    // The reader maps the file while it is being recorded
+    ck_assert_int_eq(telemetry_open(&reader, telemetry_path), 0);
+    ck_assert_uint_eq(reader.header->period_ns, 200000000ULL);
+    ck_assert_uint_eq(reader.header->capacity, 16);
+
+    for (uint64_t tick = 1; tick <= 5; tick++) {
+        make_record(&record, tick);
+        telemetry_append(&writer, &record);
+    }
+    ck_assert_uint_eq(telemetry_count(&reader), 5);
+    ck_assert_uint_eq(telemetry_first(&reader), 0);
+    const TelemetryRecord *last = telemetry_get(&reader, 4);
+    ck_assert_uint_eq(last->tick, 5);
+    ck_assert(last->before.speed == 5.0 && last->after.speed == 5.5);
+    ck_assert_int_eq(last->before.rpm_iec, 50);
+    ck_assert_int_eq(last->ev_command, TELEMETRY_NO_COMMAND);
+    ck_assert_int_eq(telemetry_get(&reader, 2)->ev_command, CMD_SET_POWER);
+
+    VehicleState vehicle;
+    telemetry_vehicle_unpack(&telemetry_get(&reader, 3)->before, &vehicle);
+    ck_assert(vehicle.accelerator && vehicle.speed == 4.0 && vehicle.rpm_iec == 40);
+    ck_assert(vehicle.battery == MAX_BATTERY);
+
+    telemetry_close(&reader);
+    telemetry_close(&writer);
+
+    // Records survive the writer
+    ck_assert_int_eq(telemetry_open(&reader, telemetry_path), 0);
+    ck_assert_uint_eq(telemetry_count(&reader), 5);
+    ck_assert_uint_eq(telemetry_get(&reader, 0)->tick, 1);
+    telemetry_close(&reader);
+}
+END_TEST
+
+START_TEST(test_telemetry_wraparound)
+{
+    TelemetryLog log;
+    TelemetryRecord record;
+
+    ck_assert_int_eq(telemetry_create(&log, telemetry_path, 4, 1000000ULL, 0), 0);
+    for (uint64_t tick = 1; tick <= 10; tick++) {
+        make_record(&record, tick);
+        telemetry_append(&log, &record);
+    }
+    // Only the last 4 ticks are kept
+    ck_assert_uint_eq(telemetry_count(&log), 10);
+    ck_assert_uint_eq(telemetry_first(&log), 6);
+    for (uint64_t i = 6; i < 10; i++) {
+        ck_assert_uint_eq(telemetry_get(&log, i)->tick, i + 1);
+    }
+    telemetry_close(&log);
+}
+END_TEST
+
+START_TEST(test_telemetry_invalid_file)
+{
+    TelemetryLog log;
+
+    ck_assert_int_eq(telemetry_create(&log, telemetry_path, 0, 1000000ULL, 0), -1);
+    ck_assert_int_eq(errno, EINVAL);
+
+    // A pedal trace is not a telemetry file
+    FILE *file = fopen(telemetry_path, "w");
+    ck_assert_ptr_ne(file, NULL);
+    for (int i = 0; i < 1000; i++) {
+        fprintf(file, "%d 1\n", i);
+    }
+    fclose(file);
+    ck_assert_int_eq(telemetry_open(&log, telemetry_path), -1);
+    ck_assert_int_eq(errno, EINVAL);
+
+    // Nor is a telemetry file cut short
+    ck_assert_int_eq(telemetry_create(&log, telemetry_path, 8, 1000000ULL, 0), 0);
+    telemetry_close(&log);
+    ck_assert_int_eq(truncate(telemetry_path, TELEMETRY_HEADER_SIZE + 4 * sizeof(TelemetryRecord)), 0);
+    ck_assert_int_eq(telemetry_open(&log, telemetry_path), -1);
+
+    unlink(telemetry_path);
+    ck_assert_int_eq(telemetry_open(&log, telemetry_path), -1);
+    ck_assert_int_eq(errno, ENOENT);
+}
+END_TEST
+
+// --- Screen Renderer Tests ---
+
+static Screen screen;
+static int screen_pipe[2];
+static char screen_output[SCREEN_OUT_SIZE + 1];
+
+static void screen_setup(void) {
+    ck_assert_int_eq(pipe(screen_pipe), 0);
+    fcntl(screen_pipe[0], F_SETFL, O_NONBLOCK);
+    screen_init(&screen, screen_pipe[1]);
+}
+
+static void screen_teardown(void) {
+    close(screen_pipe[0]);
+    close(screen_pipe[1]);
+}
+
+// Everything written since the last call
+static const char *screen_read(void) {
+    ssize_t n = read(screen_pipe[0], screen_output, sizeof(screen_output) - 1);
+    screen_output[n > 0 ? n : 0] = '\0';
+    return screen_output;
+}
+
+static void draw_frame(double speed, const char *mode) {
+    screen_begin(&screen);
+    screen_line(&screen, "=== System State ===");
+    screen_line(&screen, "Speed: %06.2f km/h", speed);
+    screen_line(&screen, "Power mode: %s", mode);
+    screen_flush(&screen);
+}
+
+START_TEST(test_screen_first_frame_full)
+{
+    draw_frame(12.5, "Hybrid");
+    ck_assert_str_eq(screen_read(), "\033[H\033[2J\033[1;1H=== System State ===\033[K\033[2;1HSpeed: 012.50 km/h\033[K"
+                                    "\033[3;1HPower mode: Hybrid\033[K\033[4;1H");
+    ck_assert_uint_eq(screen.lines_written, 3);
+}
+END_TEST
+
+START_TEST(test_screen_only_changed_lines)
+{
+    draw_frame(12.5, "Hybrid");
+    screen_read();
+
+    // Unchanged frame: no write at all
+    draw_frame(12.5, "Hybrid");
+    ck_assert_str_eq(screen_read(), "");
+
+    draw_frame(13.0, "Hybrid");
+    ck_assert_str_eq(screen_read(), "\033[2;1HSpeed: 013.00 km/h\033[K\033[4;1H");
+    ck_assert_uint_eq(screen.frames, 3);
+    ck_assert_uint_eq(screen.lines_written, 4);
+
+    // A shorter frame blanks the lines it no longer has
+    screen_begin(&screen);
+    screen_line(&screen, "=== System State ===");
+    screen_flush(&screen);
+    ck_assert_str_eq(screen_read(), "\033[2;1H\033[K\033[3;1H\033[K\033[2;1H");
+}
+END_TEST
+
+START_TEST(test_screen_redraw_after_error)
+{
+    draw_frame(1.0, "Hybrid");
+    screen_read();
+
+    screen.fd = -1;
+    screen_begin(&screen);
+    screen_line(&screen, "lost");
+    ck_assert_int_eq(screen_flush(&screen), -1);
+
+    // The terminal state is unknown, so the next frame is sent in full
+    screen.fd = screen_pipe[1];
+    draw_frame(1.0, "Hybrid");
+    ck_assert(strncmp(screen_read(), "\033[H\033[2J", 7) == 0);
+}
+END_TEST
+
+START_TEST(test_screen_long_lines_cut)
+{
+    char long_text[2 * SCREEN_LINE_SIZE];
+    memset(long_text, 'x', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+
+    screen_begin(&screen);
+    for (int i = 0; i < SCREEN_MAX_LINES + 5; i++) {
+        screen_line(&screen, "%s", long_text);
+    }
+    ck_assert_int_eq(screen.lines, SCREEN_MAX_LINES);
+    ck_assert_uint_eq(strlen(screen.frame[0]), SCREEN_LINE_SIZE - 1);
+    // Every line redrawn still fits the output buffer
+    ck_assert_int_gt(screen_flush(&screen), SCREEN_MAX_LINES * (SCREEN_LINE_SIZE - 1));
+}
+END_TEST
+
+// --- Snapshot Observer Tests ---
+
+static SnapshotStream stream;
+
+// Remembers what it was handed: the count, the last tick and whether ticks came in order
+typedef struct {
+    unsigned long count;
+    uint64_t last_tick;
+    bool in_order;
+} SnapshotLog;
+
+static void log_snapshot(Observer *observer, const TelemetryRecord *snapshot) {
+    SnapshotLog *log = (SnapshotLog *)observer->context;
+    if (log->count > 0 && snapshot->tick != log->last_tick + 1) {
+        log->in_order = false;
+    }
+    log->count++;
+    log->last_tick = snapshot->tick;
+}
+
+static void publish_ticks(uint64_t first, uint64_t last) {
+    TelemetryRecord record;
+    memset(&record, 0, sizeof(record));
+    for (uint64_t tick = first; tick <= last; tick++) {
+        record.tick = tick;
+        record.after.speed = (double)tick;
+        snapshot_publish(&stream, &record);
+    }
+}
+
+static void observer_setup(void) {
+    snapshot_stream_init(&stream);
+}
+
+START_TEST(test_snapshot_read_and_overwrite)
+{
+    TelemetryRecord record;
+    publish_ticks(1, 3);
+    ck_assert(snapshot_read(&stream, 2, &record));
+    ck_assert_uint_eq(record.tick, 3);
+    ck_assert(record.after.speed == 3.0);
+
+    // Once the ring has wrapped, the slot holds a newer snapshot
+    publish_ticks(4, SNAPSHOT_RING_SIZE + 1);
+    ck_assert(!snapshot_read(&stream, 0, &record));
+    ck_assert(snapshot_read(&stream, SNAPSHOT_RING_SIZE, &record));
+    ck_assert_uint_eq(record.tick, SNAPSHOT_RING_SIZE + 1);
+}
+END_TEST
+
+START_TEST(test_observer_every_snapshot_in_order)
+{
+    SnapshotLog log = { .in_order = true };
+    Observer observer = { .on_snapshot = log_snapshot, .context = &log, .stream = &stream };
+
+    ck_assert_int_eq(observer_poll(&observer), 0);
+    publish_ticks(1, 10);
+    ck_assert_int_eq(observer_poll(&observer), 10);
+    publish_ticks(11, 12);
+    ck_assert_int_eq(observer_poll(&observer), 2);
+    ck_assert_uint_eq(log.count, 12);
+    ck_assert_uint_eq(log.last_tick, 12);
+    ck_assert(log.in_order);
+    ck_assert_uint_eq(observer.dropped, 0);
+}
+END_TEST
+
+START_TEST(test_observer_lapped_counts_drops)
+{
+    SnapshotLog log = { .in_order = true };
+    Observer observer = { .on_snapshot = log_snapshot, .context = &log, .stream = &stream };
+
+    publish_ticks(1, SNAPSHOT_RING_SIZE + 100);
+    ck_assert_int_eq(observer_poll(&observer), SNAPSHOT_RING_SIZE);
+    ck_assert_uint_eq(observer.dropped, 100);
+    ck_assert_uint_eq(log.last_tick, SNAPSHOT_RING_SIZE + 100);
+    ck_assert(log.in_order); // The oldest ones are lost, the rest arrive in order
+}
+END_TEST
+
+START_TEST(test_observer_latest_only)
+{
+    SnapshotLog log = { .in_order = true };
+    Observer observer = { .on_snapshot = log_snapshot, .context = &log, .stream = &stream, .latest_only = true };
+
+    publish_ticks(1, 50);
+    ck_assert_int_eq(observer_poll(&observer), 1);
+    ck_assert_uint_eq(log.last_tick, 50);
+    ck_assert_int_eq(observer_poll(&observer), 0); // Nothing new
+    publish_ticks(51, 52);
+    ck_assert_int_eq(observer_poll(&observer), 1);
+    ck_assert_uint_eq(log.last_tick, 52);
+    ck_assert_uint_eq(observer.dropped, 0);
+}
+END_TEST
+
+START_TEST(test_observer_threads_share_stream)
+{
+    SnapshotLog every = { .in_order = true }, latest = { .in_order = true };
+    Observer recorder = { .on_snapshot = log_snapshot, .context = &every, .poll_interval_ns = 1000000L };
+    Observer display = { .on_snapshot = log_snapshot, .context = &latest, .latest_only = true, .poll_interval_ns = 5000000L };
+
+    ck_assert_int_eq(observer_start(&recorder, &stream), 0);
+    ck_assert_int_eq(observer_start(&display, &stream), 0);
+    for (uint64_t tick = 1; tick <= 500; tick++) {
+        publish_ticks(tick, tick);
+        if (tick % 50 == 0) {
+            usleep(2000);
+        }
+    }
+    observer_stop(&recorder);
+    observer_stop(&display);
+
+    // Stopping drains the stream: the recorder saw every tick, the display at least the last one
+    ck_assert_uint_eq(every.count, 500);
+    ck_assert(every.in_order);
+    ck_assert_uint_eq(recorder.dropped, 0);
+    ck_assert_uint_eq(latest.last_tick, 500);
+    ck_assert_uint_le(latest.count, 500);
+    ck_assert(!recorder.started);
+}
+END_TEST
+
+START_TEST(test_observer_stop_without_start)
+{
+    // As when the VMU gives up on its observers after one failed to start: no thread to join
+    Observer observer = { .on_snapshot = log_snapshot };
+    observer_stop(&observer);
+    ck_assert(!observer.started);
+    ck_assert(!observer.stop);
+}
+END_TEST
+
+// --- Real-Time Profile Tests ---
+
+START_TEST(test_rt_parse_cpus)
+{
+    uint64_t mask = 42;
+    ck_assert_int_eq(rt_parse_cpus("2", &mask), 1);
+    ck_assert_uint_eq(mask, 0x4);
+    ck_assert_int_eq(rt_parse_cpus("0,4-6,63", &mask), 1);
+    ck_assert_uint_eq(mask, 0x8000000000000071ULL);
+
+    const char *invalid[] = { "", "a", "1,", ",1", "2-", "5-3", "64", "1 2", "-1" };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        mask = 42;
+        ck_assert_msg(rt_parse_cpus(invalid[i], &mask) == 0, "'%s' accepted", invalid[i]);
+        ck_assert_uint_eq(mask, 42); // Untouched
+    }
+}
+END_TEST
+
+START_TEST(test_rt_parse_priorities)
+{
+    RtProfile profile;
+    rt_profile_default(&profile);
+    ck_assert(!profile.enabled);
+    ck_assert_uint_eq(profile.cpu_mask, 0);
+
+    ck_assert_int_eq(rt_parse_priorities("70", &profile), 1);
+    ck_assert_int_eq(profile.loop_priority, 70);
+    ck_assert_int_eq(profile.input_priority, RT_INPUT_PRIORITY);
+    ck_assert_int_eq(rt_parse_priorities("99,1,0", &profile), 1);
+    ck_assert_int_eq(profile.loop_priority, 99);
+    ck_assert_int_eq(profile.input_priority, 1);
+    ck_assert_int_eq(profile.observer_priority, 0);
+
+    ck_assert_int_eq(rt_parse_priorities("100", &profile), 0);
+    ck_assert_int_eq(rt_parse_priorities("50,", &profile), 0);
+    ck_assert_int_eq(rt_parse_priorities("50,-1", &profile), 0);
+    ck_assert_int_eq(profile.loop_priority, 99); // Untouched by a rejected list
+}
+END_TEST
+
+START_TEST(test_rt_prefault_keeps_contents)
+{
+    size_t size = 3 * 4096 + 100;
+    char *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ck_assert_ptr_ne(buffer, MAP_FAILED);
+    buffer[5000] = 'x';
+
+    // An unaligned range inside the mapping is widened to whole pages
+    rt_prefault(buffer + 10, size - 10);
+    unsigned char resident[4];
+    ck_assert_int_eq(mincore(buffer, size, resident), 0);
+    for (int page = 0; page < 4; page++) {
+        ck_assert_msg(resident[page] & 1, "Page %d not resident", page);
+    }
+    ck_assert_int_eq(buffer[5000], 'x');
+    ck_assert_int_eq(buffer[0], 0);
+    munmap(buffer, size);
+}
+END_TEST
+
+START_TEST(test_rt_thread_enter)
+{
+    RtProfile profile;
+    rt_profile_default(&profile);
+    ck_assert_int_eq(rt_enter(&profile, "test"), 0); // Disabled, unpinned: nothing to do
+
+    // Unprivileged processes may not get SCHED_FIFO; then the thread keeps its policy
+    int policy;
+    struct sched_param param;
+    if (rt_thread_enter(10) == 0) {
+        pthread_getschedparam(pthread_self(), &policy, &param);
+        ck_assert_int_eq(policy, SCHED_FIFO);
+        ck_assert_int_eq(param.sched_priority, 10);
+    } else {
+        ck_assert_int_eq(errno, EPERM);
+    }
+    ck_assert_int_eq(rt_thread_enter(0), 0);
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    ck_assert_int_eq(policy, SCHED_OTHER);
+}
+END_TEST
+
+// --- Transport Tests ---
+
+// Points a POSIX endpoint at objects of its own, so the tests never touch a running simulation
+static void use_test_names(Transport *transport) {
+    transport->names.state = "/test_common_transport_state";
+    transport->names.semaphore = "/test_common_transport_sem";
+    transport->names.queues[TRANSPORT_EV] = "/test_common_transport_ev_queue";
+    transport->names.queues[TRANSPORT_IEC] = "/test_common_transport_iec_queue";
+    transport->names.rings[TRANSPORT_EV] = "/test_common_transport_ev_ring";
+    transport->names.rings[TRANSPORT_IEC] = "/test_common_transport_iec_ring";
+}
+
+// VMU and engine endpoints of one backend share the state and deliver commands in order per channel
+static void check_round_trip(const TransportOps *ops, CommandTransport commands) {
+    Transport vmu, ev, iec;
+    EngineCommand cmd = { .type = CMD_START, .seq = 1 };
+    struct timespec no_wait = { 0, 0 };
+
+    transport_init(&vmu, ops, TRANSPORT_ROLE_VMU, commands, "VMU");
+    transport_init(&ev, ops, TRANSPORT_ROLE_EV, commands, "EV");
+    transport_init(&iec, ops, TRANSPORT_ROLE_IEC, commands, "IEC");
+    use_test_names(&vmu);
+    use_test_names(&ev);
+    use_test_names(&iec);
+    ck_assert_int_eq(transport_open(&vmu), 0);
+    ck_assert_int_eq(transport_open(&ev), 0);
+    ck_assert_int_eq(transport_open(&iec), 0);
+    ck_assert_int_eq(vmu.shm_fd, -1); // Closed once the state is mapped
+    ck_assert_int_eq(ev.shm_fd, -1);
+
+    // Published by one endpoint, seen by the others
+    vmu.state->ev_power_level = 0.25;
+    ck_assert(ev.state->ev_power_level == 0.25);
+    ck_assert(iec.state->ev_power_level == 0.25);
+
+    ck_assert_int_eq(transport_wait(&ev, &no_wait), 0);
+    ck_assert_int_eq(transport_send(&vmu, TRANSPORT_EV, &cmd), 0);
+    cmd.type = CMD_STOP;
+    cmd.seq = 2;
+    ck_assert_int_eq(transport_send(&vmu, TRANSPORT_EV, &cmd), 0);
+    ck_assert_int_eq(transport_wait(&ev, &no_wait), 1);
+    ck_assert_int_eq(transport_receive(&ev, &cmd), 0);
+    ck_assert_int_eq(cmd.type, CMD_START);
+    ck_assert_int_eq(transport_receive(&ev, &cmd), 0);
+    ck_assert_int_eq(cmd.type, CMD_STOP);
+    ck_assert_uint_eq(cmd.seq, 2);
+    ck_assert_int_eq(transport_receive(&ev, &cmd), -1);
+    ck_assert_int_eq(errno, EAGAIN);
+    ck_assert_int_eq(transport_receive(&iec, &cmd), -1); // Nothing crossed over to the IEC channel
+
+    transport_close(&iec);
+    transport_close(&ev);
+    transport_close(&vmu);
+    ck_assert_ptr_eq(vmu.state, MAP_FAILED);
+}
+
+START_TEST(test_transport_posix_round_trip)
+{
+    check_round_trip(&posix_transport, TRANSPORT_MQ);
+    check_round_trip(&posix_transport, TRANSPORT_RING);
+
+    // The VMU removed everything it created: an engine cannot attach any more
+    Transport ev;
+    transport_init(&ev, &posix_transport, TRANSPORT_ROLE_EV, TRANSPORT_MQ, "EV");
+    use_test_names(&ev);
+    ck_assert_int_eq(transport_open(&ev), -1);
+    ck_assert_int_eq(ev.shm_fd, -1);
+    ck_assert_ptr_eq(ev.state, MAP_FAILED);
+}
+END_TEST
+
+START_TEST(test_transport_inproc_round_trip)
+{
+    check_round_trip(&inproc_transport, TRANSPORT_MQ); // Always command rings, whatever is asked
+}
+END_TEST
+
+START_TEST(test_transport_inproc_needs_vmu)
+{
+    Transport vmu, other, ev;
+
+    transport_init(&ev, &inproc_transport, TRANSPORT_ROLE_EV, TRANSPORT_RING, "EV");
+    ck_assert_int_eq(transport_open(&ev), -1);
+    ck_assert_int_eq(errno, ENOENT);
+
+    // One bus per process
+    transport_init(&vmu, &inproc_transport, TRANSPORT_ROLE_VMU, TRANSPORT_RING, "VMU");
+    transport_init(&other, &inproc_transport, TRANSPORT_ROLE_VMU, TRANSPORT_RING, "VMU");
+    ck_assert_int_eq(transport_open(&vmu), 0);
+    ck_assert_ptr_eq(vmu.sem, SEM_FAILED);
+    ck_assert_int_eq(transport_open(&other), -1);
+    ck_assert_int_eq(errno, EBUSY);
+    transport_close(&vmu);
+    ck_assert_int_eq(transport_open(&ev), -1);
+}
+END_TEST
+
+// --- Engine Thread Tests ---
+
+static Transport bus;       // VMU end of the in-process transport
+static SystemState *engine_state;
+static EngineThread engine;
+
+void engine_setup(void) {
+    transport_init(&bus, &inproc_transport, TRANSPORT_ROLE_VMU, TRANSPORT_RING, "VMU");
+    ck_assert_int_eq(transport_open(&bus), 0);
+    engine_state = bus.state; // Zero-filled
+    engine_state->temp_ev = 25.0;
+    engine_thread_init(&engine, ENGINE_EV, 1000000L, TICK_CATCH_UP, 0, false);
+}
+
+void engine_teardown(void) {
+    transport_close(&engine.transport);
+    transport_close(&bus);
+}
+
+static void push_command(CommandType type, unsigned int seq) {
+    EngineCommand cmd = { .type = type, .seq = seq };
+    ck_assert_int_eq(transport_send(&bus, TRANSPORT_EV, &cmd), 0);
+}
+
+START_TEST(test_engine_receive_collapses_batch)
+{
+    ck_assert_int_eq(engine_thread_attach(&engine, false, NULL), 0);
+    push_command(CMD_START, 1);
+    push_command(CMD_STOP, 2);
+    push_command(CMD_START, 4); // 3 never arrived
+
+    engine_receive_commands(&engine.loop);
+    ck_assert(engine_state->ev_on);
+    ck_assert_uint_eq(engine.loop.commands, 3);
+    ck_assert_uint_eq(engine.loop.commands_lost, 1);
+    // One write section for the whole batch
+    ck_assert_uint_eq(engine_state->ev_seq, 2);
+
+    // Nothing pending: nothing published
+    engine_receive_commands(&engine.loop);
+    ck_assert_uint_eq(engine_state->ev_seq, 2);
+    ck_assert_int_eq(engine.running, 1);
+
+    push_command(CMD_END, 0);
+    engine_receive_commands(&engine.loop);
+    ck_assert_int_eq(engine.running, 0);
+}
+END_TEST
+
+START_TEST(test_engine_mailbox_and_physics)
+{
+    ck_assert_int_eq(engine_thread_attach(&engine, true, NULL), 0);
+    push_command(CMD_START, 1);
+    cmd_mailbox_post(&engine_state->ev_mailbox, 0.5);
+    engine_receive_commands(&engine.loop);
+    ck_assert_uint_eq(engine.loop.commands, 2); // START, then the setpoint from the mailbox
+    ck_assert_uint_eq(engine.loop.commands_lost, 0);
+
+    engine_state->ev_power_level = 0.5;
+    engine_physics_step(&engine.loop);
+    ck_assert_int_gt(engine_state->rpm_ev, 0);
+    ck_assert_uint_eq(engine_state->ev_seq % 2, 0);
+
+    // The IEC engine steps its own block
+    transport_close(&engine.transport);
+    engine_thread_init(&engine, ENGINE_IEC, 1000000L, TICK_CATCH_UP, 0, false);
+    ck_assert_int_eq(engine_thread_attach(&engine, false, NULL), 0);
+    engine_state->iec_on = true;
+    engine_state->iec_power_level = 0.5;
+    engine_physics_step(&engine.loop);
+    ck_assert_int_gt(engine_state->rpm_iec, 0);
+    ck_assert_uint_eq(engine_state->iec_seq, 2);
+}
+END_TEST
+
+START_TEST(test_engine_thread_runs_until_end)
+{
+    struct timespec pause = { 0, 1000000L };
+    bool on = false;
+    int rpm = 0;
+    double temp;
+
+    ck_assert_int_eq(engine_thread_start(&engine, false, NULL), 0);
+    engine_state->ev_power_level = 1.0;
+    push_command(CMD_START, 1);
+    for (int i = 0; i < 1000 && !(on && rpm > 0); i++) {
+        nanosleep(&pause, NULL);
+        snapshot_ev_block(engine_state, &on, &rpm, &temp);
+    }
+    ck_assert(on);
+    ck_assert_int_gt(rpm, 0);
+
+    push_command(CMD_END, 0);
+    engine_thread_stop(&engine);
+    ck_assert(!engine_state->ev_on); // Switched off on the way out
+    ck_assert_int_eq(engine_state->rpm_ev, 0);
+    ck_assert_uint_gt(engine.loop.physics.ticks, 0);
+    ck_assert_uint_eq(engine.loop.commands_lost, 0);
+}
+END_TEST
+
+START_TEST(test_engine_thread_pauses_with_the_vmu)
+{
+    volatile sig_atomic_t paused = 1;
+    struct timespec pause = { 0, 20000000L };
+
+    ck_assert_int_eq(engine_thread_start(&engine, false, &paused), 0);
+    push_command(CMD_START, 1);
+    nanosleep(&pause, NULL);
+    ck_assert(!engine_state->ev_on); // Nothing received while paused
+    ck_assert_uint_eq(engine.loop.physics.ticks, 0);
+
+    engine_thread_stop(&engine); // Ends within the one-second pause poll
+    ck_assert_uint_eq(engine.loop.commands, 0);
+}
+END_TEST
+
+START_TEST(test_engine_thread_records_own_stats)
+{
+    struct timespec pause = { 0, 1000000L };
+    EngineCommand start = { .type = CMD_START, .seq = 1, .sent_ns = monotonic_ns() };
+
+    engine_thread_init(&engine, ENGINE_EV, 1000000L, TICK_CATCH_UP, 0, true);
+    ck_assert_int_eq(engine_thread_start(&engine, false, NULL), 0);
+    ck_assert_ptr_ne(engine.page, NULL);
+    ck_assert_ptr_eq(stats_page, NULL); // The page of the process is left to the VMU loop
+    ck_assert_int_eq(transport_send(&bus, TRANSPORT_EV, &start), 0);
+    for (int i = 0; i < 1000 && engine.page->hist[STAT_ENGINE].count < 2; i++) {
+        nanosleep(&pause, NULL);
+    }
+    ck_assert_uint_eq(engine.page->hist[STAT_START_RECEIVED].count, 1);
+    ck_assert_uint_eq(engine.page->hist[STAT_START_APPLIED].count, 1);
+    ck_assert_uint_ge(engine.page->hist[STAT_ENGINE].count, 2);
+    ck_assert_uint_ge(engine.page->hist[STAT_WAKEUP_LATENESS].count, 2);
+    ck_assert_str_eq(engine.page->module, "ev");
+
+    engine_thread_stop(&engine);
+    ck_assert_ptr_eq(engine.page, NULL);
+    ck_assert_int_eq(shm_open(EV_STATS_NAME, O_RDONLY, 0), -1); // Removed with the thread
+}
+END_TEST
+
+// --- Same engine loop in both runtimes ---
+
+#define LOOP_TRACE_EVENTS 64
+
+// What an engine loop reported: its trace events in order (values dropped, they are timings) and
+// its counters. Lives in shared memory so an engine process can fill it in.
+typedef struct {
+    int events;
+    int event[LOOP_TRACE_EVENTS]; // StatId of a record, or 100 + 2 * CommandType + applied
+    unsigned long commands;
+    unsigned long commands_lost;
+    unsigned long ticks;
+    SystemState state;            // Copy of the state once the engine shut down
+} LoopRun;
+
+static unsigned long long run_trace_start(void *context) {
+    (void)context;
+    return 1; // Always recorded
+}
+
+static void run_trace_record(void *context, StatId id, unsigned long long value_ns) {
+    LoopRun *run = (LoopRun *)context;
+    (void)value_ns;
+    if (run->events < LOOP_TRACE_EVENTS) {
+        run->event[run->events++] = (int)id;
+    }
+}
+
+static void run_trace_command(void *context, CommandType type, unsigned long long sent_ns, bool applied) {
+    LoopRun *run = (LoopRun *)context;
+    (void)sent_ns;
+    if (run->events < LOOP_TRACE_EVENTS) {
+        run->event[run->events++] = 100 + 2 * (int)type + (applied ? 1 : 0);
+    }
+}
+
+static EngineTrace run_trace(LoopRun *run) {
+    return (EngineTrace){ run_trace_start, run_trace_record, run_trace_command, run };
+}
+
+static void finish_run(LoopRun *run, const EngineLoop *loop, const SystemState *state) {
+    run->commands = loop->commands;
+    run->commands_lost = loop->commands_lost;
+    run->ticks = loop->physics.ticks;
+    memcpy(&run->state, state, sizeof(SystemState));
+}
+
+// Same state and commands for both runs, all pending before the engine starts: one batch (with a gap
+// in the sequence numbers and CMD_END), then the one physics step the loop takes on its way out
+static void queue_script(Transport *vmu) {
+    static const struct { CommandType type; unsigned int seq; } script[] = {
+        { CMD_START, 1 }, { CMD_SET_POWER, 2 }, { CMD_STOP, 3 }, { CMD_START, 5 }, { CMD_END, 0 }
+    };
+    memset(vmu->state, 0, sizeof(SystemState));
+    vmu->state->temp_ev = 25.0;
+    vmu->state->temp_iec = 25.0;
+    vmu->state->ev_power_level = 0.5;
+    for (size_t i = 0; i < sizeof(script) / sizeof(script[0]); i++) {
+        EngineCommand cmd = { .type = script[i].type, .seq = script[i].seq, .sent_ns = i + 1 };
+        ck_assert_int_eq(transport_send(vmu, TRANSPORT_EV, &cmd), 0);
+    }
+}
+
+START_TEST(test_engine_loop_same_in_process_and_thread)
+{
+    LoopRun *runs = mmap(NULL, 2 * sizeof(LoopRun), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ck_assert_ptr_ne(runs, MAP_FAILED);
+    memset(runs, 0, 2 * sizeof(LoopRun));
+
+    // Processes: the EV executable's loop on its own end of the named objects
+    Transport vmu;
+    transport_init(&vmu, &posix_transport, TRANSPORT_ROLE_VMU, TRANSPORT_RING, "VMU");
+    use_test_names(&vmu);
+    ck_assert_int_eq(transport_open(&vmu), 0);
+    queue_script(&vmu);
+    fflush(stdout);
+    pid_t pid = fork();
+    ck_assert_int_ne(pid, -1);
+    if (pid == 0) {
+        volatile sig_atomic_t running = 1, paused = 0;
+        Transport ev;
+        EngineLoop loop;
+        transport_init(&ev, &posix_transport, TRANSPORT_ROLE_EV, TRANSPORT_RING, "EV");
+        use_test_names(&ev);
+        if (transport_open(&ev) != 0) {
+            _exit(1);
+        }
+        engine_loop_init(&loop, &ev_engine_ops, &ev, &running, &paused);
+        loop.period_ns = 1;
+        loop.trace = run_trace(&runs[0]);
+        engine_loop_run(&loop);
+        engine_loop_shutdown(&loop);
+        finish_run(&runs[0], &loop, ev.state);
+        transport_close(&ev);
+        _exit(0);
+    }
+    int status;
+    ck_assert_int_eq(waitpid(pid, &status, 0), pid);
+    ck_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    ck_assert_int_eq(memcmp(&runs[0].state, vmu.state, sizeof(SystemState)), 0);
+    transport_close(&vmu);
+
+    // Threads: the engine thread of the VMU process on the in-process transport
+    engine_thread_init(&engine, ENGINE_EV, 1, TICK_CATCH_UP, 0, false);
+    ck_assert_int_eq(engine_thread_attach(&engine, false, NULL), 0);
+    engine.loop.trace = run_trace(&runs[1]);
+    queue_script(&bus);
+    ck_assert_int_eq(engine_thread_launch(&engine), 0);
+    pthread_join(engine.thread, NULL); // Ends on CMD_END by itself
+    engine.started = false;
+    finish_run(&runs[1], &engine.loop, engine_state);
+
+    // The receive batch and the physics step, traced the same way, leave the same state
+    ck_assert_int_eq(runs[0].events, runs[1].events);
+    ck_assert_int_eq(memcmp(runs[0].event, runs[1].event, sizeof(runs[0].event)), 0);
+    ck_assert_int_eq(runs[0].event[0], 100 + 2 * CMD_START); // First event: START received
+    ck_assert_int_eq(runs[0].event[runs[0].events - 1], STAT_WAKEUP_LATENESS);
+    ck_assert_uint_eq(runs[0].commands, 5);
+    ck_assert_uint_eq(runs[1].commands, 5);
+    ck_assert_uint_eq(runs[0].commands_lost, 1);
+    ck_assert_uint_eq(runs[1].commands_lost, 1);
+    ck_assert_uint_eq(runs[0].ticks, 1);
+    ck_assert_uint_eq(runs[1].ticks, 1);
+    ck_assert_int_eq(memcmp(&runs[0].state, &runs[1].state, sizeof(SystemState)), 0);
+    ck_assert(!runs[1].state.ev_on); // Shut down
+    ck_assert(runs[1].state.temp_ev > 0.0);
+
+    munmap(runs, 2 * sizeof(LoopRun));
+}
+END_TEST
+
+// --- Main Test Suite Creation ---
+
+Suite *common_suite(void) {
+    Suite *s;
+    TCase *tc_ring;    // Shared-memory command ring tests
+    TCase *tc_mailbox; // Power setpoint mailbox tests
+    TCase *tc_options; // Command line option tests
+    TCase *tc_tick;    // Tick scheduler tests
+    TCase *tc_hist;    // Latency histogram tests
+    TCase *tc_trace;   // Command trace tests
+    TCase *tc_pedal;   // Pedal trace tests
+    TCase *tc_telemetry; // Telemetry recorder tests
+    TCase *tc_screen;  // Terminal renderer tests
+    TCase *tc_observer; // Snapshot stream and observer tests
+    TCase *tc_rt;      // Real-time profile tests
+    TCase *tc_transport; // Transport backend tests
+    TCase *tc_engine;  // In-process engine tests
+
+    s = suite_create("Common Infrastructure Tests");
+
+    tc_ring = tcase_create("CommandRing");
+    tcase_add_checked_fixture(tc_ring, ring_setup, ring_teardown);
+    tcase_add_test(tc_ring, test_ring_pop_empty);
+    tcase_add_test(tc_ring, test_ring_push_pop_order);
+    tcase_add_test(tc_ring, test_ring_full);
+    tcase_add_test(tc_ring, test_ring_wraparound);
+    tcase_add_test(tc_ring, test_ring_shared_between_mappings);
+    tcase_add_test(tc_ring, test_ring_reset_discards_pending);
+    tcase_add_test(tc_ring, test_ring_wait_pending);
+    tcase_add_test(tc_ring, test_ring_wait_timeout);
+    tcase_add_test(tc_ring, test_ring_wait_woken_by_push);
+    suite_add_tcase(s, tc_ring);
+
+    tc_mailbox = tcase_create("Mailbox");
+    tcase_add_test(tc_mailbox, test_mailbox_empty);
+    tcase_add_test(tc_mailbox, test_mailbox_coalesces_setpoints);
+    tcase_add_test(tc_mailbox, test_mailbox_carries_post_time);
+    suite_add_tcase(s, tc_mailbox);
+
+    tc_options = tcase_create("Options");
+    tcase_add_test(tc_options, test_options_default_transport);
+    tcase_add_test(tc_options, test_options_ring_transport);
+    tcase_add_test(tc_options, test_options_mailbox);
+    tcase_add_test(tc_options, test_options_invalid_transport);
+    tcase_add_test(tc_options, test_options_period_and_policy);
+    tcase_add_test(tc_options, test_options_invalid_period);
+    tcase_add_test(tc_options, test_options_pedal_trace);
+    tcase_add_test(tc_options, test_options_telemetry);
+    tcase_add_test(tc_options, test_options_display_rate);
+    tcase_add_test(tc_options, test_options_realtime);
+    tcase_add_test(tc_options, test_options_state_lock);
+    tcase_add_test(tc_options, test_options_runtime);
+    suite_add_tcase(s, tc_options);
+
+    tc_tick = tcase_create("TickScheduler");
+    tcase_add_test(tc_tick, test_tick_advance_on_time);
+    tcase_add_test(tc_tick, test_tick_catch_up);
+    tcase_add_test(tc_tick, test_tick_catch_up_bounded);
+    tcase_add_test(tc_tick, test_tick_skip);
+    tcase_add_test(tc_tick, test_tick_wait_lateness);
+    tcase_add_test(tc_tick, test_tick_wait_rate);
+    suite_add_tcase(s, tc_tick);
+
+    tc_hist = tcase_create("Histogram");
+    tcase_add_test(tc_hist, test_hist_bucket_bounds);
+    tcase_add_test(tc_hist, test_hist_percentiles);
+    tcase_add_test(tc_hist, test_stats_disabled);
+    suite_add_tcase(s, tc_hist);
+
+    tc_trace = tcase_create("CommandTrace");
+    tcase_add_test(tc_trace, test_trace_seq_gaps);
+    tcase_add_test(tc_trace, test_trace_records_by_type);
+    suite_add_tcase(s, tc_trace);
+
+    tc_pedal = tcase_create("PedalTrace");
+    tcase_add_test(tc_pedal, test_pedal_trace_parse_formats);
+    tcase_add_test(tc_pedal, test_pedal_trace_parse_invalid);
+    tcase_add_test(tc_pedal, test_pedal_trace_due);
+    tcase_add_test(tc_pedal, test_pedal_trace_load);
+    suite_add_tcase(s, tc_pedal);
+
+    tc_telemetry = tcase_create("Telemetry");
+    tcase_add_checked_fixture(tc_telemetry, telemetry_setup, telemetry_teardown);
+    tcase_add_test(tc_telemetry, test_telemetry_create_append_open);
+    tcase_add_test(tc_telemetry, test_telemetry_wraparound);
+    tcase_add_test(tc_telemetry, test_telemetry_invalid_file);
+    suite_add_tcase(s, tc_telemetry);
+
+    tc_screen = tcase_create("Screen");
+    tcase_add_checked_fixture(tc_screen, screen_setup, screen_teardown);
+    tcase_add_test(tc_screen, test_screen_first_frame_full);
+    tcase_add_test(tc_screen, test_screen_only_changed_lines);
+    tcase_add_test(tc_screen, test_screen_redraw_after_error);
+    tcase_add_test(tc_screen, test_screen_long_lines_cut);
+    suite_add_tcase(s, tc_screen);
+
+    tc_observer = tcase_create("Observer");
+    tcase_add_checked_fixture(tc_observer, observer_setup, NULL);
+    tcase_add_test(tc_observer, test_snapshot_read_and_overwrite);
+    tcase_add_test(tc_observer, test_observer_every_snapshot_in_order);
+    tcase_add_test(tc_observer, test_observer_lapped_counts_drops);
+    tcase_add_test(tc_observer, test_observer_latest_only);
+    tcase_add_test(tc_observer, test_observer_threads_share_stream);
+    tcase_add_test(tc_observer, test_observer_stop_without_start);
+    suite_add_tcase(s, tc_observer);
+
+    tc_rt = tcase_create("Realtime");
+    tcase_add_test(tc_rt, test_rt_parse_cpus);
+    tcase_add_test(tc_rt, test_rt_parse_priorities);
+    tcase_add_test(tc_rt, test_rt_prefault_keeps_contents);
+    tcase_add_test(tc_rt, test_rt_thread_enter);
+    suite_add_tcase(s, tc_rt);
+
+    tc_transport = tcase_create("Transport");
+    tcase_add_test(tc_transport, test_transport_posix_round_trip);
+    tcase_add_test(tc_transport, test_transport_inproc_round_trip);
+    tcase_add_test(tc_transport, test_transport_inproc_needs_vmu);
+    suite_add_tcase(s, tc_transport);
+
+    tc_engine = tcase_create("EngineThread");
+    tcase_add_checked_fixture(tc_engine, engine_setup, engine_teardown);
+    tcase_add_test(tc_engine, test_engine_receive_collapses_batch);
+    tcase_add_test(tc_engine, test_engine_mailbox_and_physics);
+    tcase_add_test(tc_engine, test_engine_thread_runs_until_end);
+    tcase_add_test(tc_engine, test_engine_thread_pauses_with_the_vmu);
+    tcase_add_test(tc_engine, test_engine_thread_records_own_stats);
+    tcase_add_test(tc_engine, test_engine_loop_same_in_process_and_thread);
+    suite_add_tcase(s, tc_engine);
+
+    return s;
+}
+
+int main(void) {
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = common_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -15,19 +15,25 @@
 
 #include "../../src/ev/ev.h"
 #include "../../src/vmu/vmu.h"
+#include "../../src/common/transport.h"
+#include "../../src/common/histogram.h"
+#include "../../src/common/engine_loop.h"
 
 // --- Declare external globals from ev.c ---
 extern SystemState *system_state;
 extern sem_t *sem;
-extern mqd_t ev_mq_receive;
+extern Transport ev_transport; // End of the transport opened by init_communication_ev()
 extern volatile sig_atomic_t running;
 extern volatile sig_atomic_t paused;
-extern int shm_fd;
+extern CommandTransport command_transport;
+extern bool power_mailbox;
+extern EngineLoop ev_loop; // Loop state set up by init_communication_ev()
 
 // --- Test infrastructure variables (simulating VMU) ---
 static SystemState *test_vmu_system_state = NULL;
 static sem_t *test_vmu_sem = NULL;
 static mqd_t test_vmu_ev_mq_send = (mqd_t)-1; // MQ descriptor for sending commands *to* EV
+static CommandRing *test_vmu_ev_ring = NULL; // Command ring used *to* EV with TRANSPORT_RING
 
 // --- Helper function to simulate VMU's resource creation ---
 // Sets up the environment that ev.c's init_communication expects.
@@ -132,6 +138,22 @@ void ev_teardown(void) {
     printf("Test Teardown EV: EV cleanup and VMU resources cleaned.\n");
 }
 
+// --- Fixture for the shared-memory command ring transport ---
+void ev_ring_setup(void) {
+    command_transport = TRANSPORT_RING;
+    test_vmu_ev_ring = open_command_ring(EV_COMMAND_RING_NAME, true); // Simulate VMU creating the ring
+    ck_assert_ptr_ne(test_vmu_ev_ring, NULL);
+    ev_setup();
+}
+
+void ev_ring_teardown(void) {
+    ev_teardown();
+    close_command_ring(test_vmu_ev_ring);
+    shm_unlink(EV_COMMAND_RING_NAME);
+    test_vmu_ev_ring = NULL;
+    command_transport = TRANSPORT_MQ;
+}
+
 // --- Individual Test Cases ---
 
 START_TEST(test_ev_init_communication_success)
@@ -139,7 +161,8 @@ START_TEST(test_ev_init_communication_success)
     // Verify that setup (which calls init_communication) succeeded
     ck_assert_ptr_ne(system_state, MAP_FAILED);
     ck_assert_ptr_ne(sem, SEM_FAILED);
-    ck_assert_int_ne(ev_mq_receive, (mqd_t)-1);
+    ck_assert_int_ne(ev_transport.queues[TRANSPORT_EV], (mqd_t)-1);
+    ck_assert_int_eq(ev_transport.shm_fd, -1); // Closed once the state is mapped
     ck_assert_int_eq(running, 1);
     ck_assert_int_eq(paused, 0);
 }
@@ -148,7 +171,7 @@ END_TEST
 START_TEST(test_init_communication_shm_fd_fail) {
     // Test failure to open Shared Memory File Descriptor
     init_communication_ev("fail_shm", "fail_sem", "fail_mq");
-    ck_assert_int_eq(shm_fd, -1); // shm_fd is extern from ev.c
+    ck_assert_int_eq(ev_transport.shm_fd, -1);
 }
 END_TEST
 
@@ -249,6 +272,27 @@ START_TEST(test_ev_receive_cmd_unknown)
 }
 END_TEST
 
+START_TEST(test_ev_receive_cmd_mailbox)
+{
+    ev_loop.power_mailbox = true;
+
+    // Two setpoints posted before the EV gets to run, plus an ordered START event
+    cmd_mailbox_post(&test_vmu_system_state->ev_mailbox, 0.3);
+    cmd_mailbox_post(&test_vmu_system_state->ev_mailbox, 0.5);
+    EngineCommand start = { .type = CMD_START };
+    ck_assert_int_ne(mq_send(test_vmu_ev_mq_send, (const char *)&start, sizeof(start), 0), -1);
+
+    receive_cmd(); // Ordered events first, then the freshest setpoint, once
+    ck_assert_msg(test_vmu_system_state->ev_on == true, "EV should be ON after START command");
+    ck_assert_int_eq(ev_loop.mailbox_version, 2);
+
+    receive_cmd(); // Nothing new to take
+    ck_assert_int_eq(ev_loop.mailbox_version, 2);
+
+    ev_loop.power_mailbox = false;
+}
+END_TEST
+
 START_TEST(test_ev_engine_rpm_increase)
 {
     sem_wait(test_vmu_sem);
@@ -386,6 +430,24 @@ START_TEST(test_ev_engine_temperature_exactly_at_cap)
 }
 END_TEST
 
+START_TEST(test_ev_engine_publishes_sequence)
+{
+    sem_wait(test_vmu_sem);
+    test_vmu_system_state->ev_on = true;
+    test_vmu_system_state->rpm_ev = 1000;
+    test_vmu_system_state->ev_power_level = 0.5;
+    sem_post(test_vmu_sem);
+
+    seqcount_t seq_before = test_vmu_system_state->ev_seq;
+
+    engine();
+
+    // engine() must publish its update as one complete write section
+    ck_assert_msg(test_vmu_system_state->ev_seq == seq_before + 2, "Sequence should advance by one write section");
+    ck_assert_msg(test_vmu_system_state->rpm_ev > 1000, "RPM update should be visible after the write section");
+}
+END_TEST
+
 START_TEST(test_ev_engine_rpm_close_to_target)
 {
     int target_rpm = (int)(0.6 * MAX_EV_RPM);
@@ -447,7 +509,7 @@ START_TEST(test_ev_receive_cmd_empty_queue)
 {
     // Ensure the queue is empty
     EngineCommand dummy;
-    while (mq_receive(ev_mq_receive, (char *)&dummy, sizeof(dummy), NULL) != -1);
+    while (mq_receive(ev_transport.queues[TRANSPORT_EV], (char *)&dummy, sizeof(dummy), NULL) != -1);
 
     int initial_running = running;
     int initial_paused = paused;
@@ -459,6 +521,103 @@ START_TEST(test_ev_receive_cmd_empty_queue)
 }
 END_TEST
 
+START_TEST(test_ev_wait_cmd_ready)
+{
+    EngineCommand start = { .type = CMD_START };
+    struct timespec timeout = { 1, 0 };
+    mq_send(test_vmu_ev_mq_send, (const char *)&start, sizeof(start), 0);
+
+    // The queue descriptor polls readable as soon as a command is queued
+    ck_assert_int_eq(wait_cmd(&timeout), 1);
+    receive_cmd();
+    ck_assert_msg(test_vmu_system_state->ev_on == true, "EV should be ON after START command");
+}
+END_TEST
+
+START_TEST(test_ev_wait_cmd_timeout)
+{
+    struct timespec timeout = { 0, 10000000 }; // 10 ms
+    ck_assert_int_eq(wait_cmd(&timeout), 0);
+}
+END_TEST
+
+START_TEST(test_ev_trace_command_latency)
+{
+    ck_assert_ptr_ne(stats_open("/test_ev_trace_stats", "ev"), NULL);
+
+    EngineCommand start = { .type = CMD_START, .seq = 1, .sent_ns = monotonic_ns() };
+    EngineCommand power = { .type = CMD_SET_POWER, .power_level = 0.5, .seq = 2, .sent_ns = monotonic_ns() };
+    mq_send(test_vmu_ev_mq_send, (const char *)&start, sizeof(start), 0);
+    mq_send(test_vmu_ev_mq_send, (const char *)&power, sizeof(power), 0);
+
+    receive_cmd();
+    ck_assert_int_eq(stats_page->hist[STAT_START_RECEIVED].count, 1);
+    ck_assert_int_eq(stats_page->hist[STAT_START_APPLIED].count, 1);
+    ck_assert_int_eq(stats_page->hist[STAT_POWER_RECEIVED].count, 1);
+    ck_assert_int_eq(stats_page->hist[STAT_POWER_APPLIED].count, 0); // Not until engine() acts on it
+
+    engine();
+    ck_assert_int_eq(stats_page->hist[STAT_POWER_APPLIED].count, 1);
+    ck_assert_uint_ge(stats_page->hist[STAT_POWER_APPLIED].max_ns, stats_page->hist[STAT_POWER_RECEIVED].max_ns);
+
+    engine(); // Applied only once
+    ck_assert_int_eq(stats_page->hist[STAT_POWER_APPLIED].count, 1);
+
+    stats_close("/test_ev_trace_stats");
+}
+END_TEST
+
+START_TEST(test_ev_trace_detects_lost_commands)
+{
+    ev_loop.last_command_seq = 0;
+    ev_loop.commands_lost = 0;
+    EngineCommand first = { .type = CMD_SET_POWER, .seq = 7 };
+    EngineCommand after_gap = { .type = CMD_SET_POWER, .seq = 10 };
+    EngineCommand untraced = { .type = CMD_SET_POWER, .seq = 0 };
+    mq_send(test_vmu_ev_mq_send, (const char *)&first, sizeof(first), 0);
+    mq_send(test_vmu_ev_mq_send, (const char *)&after_gap, sizeof(after_gap), 0);
+    mq_send(test_vmu_ev_mq_send, (const char *)&untraced, sizeof(untraced), 0);
+
+    receive_cmd();
+    ck_assert_int_eq(ev_loop.commands_lost, 2); // Sequence numbers 8 and 9 never arrived
+    ck_assert_int_eq(ev_loop.last_command_seq, 10);
+}
+END_TEST
+
+START_TEST(test_ev_receive_cmd_batch_start_set_power)
+{
+    EngineCommand start = { .type = CMD_START };
+    EngineCommand power = { .type = CMD_SET_POWER, .power_level = 0.4 };
+    mq_send(test_vmu_ev_mq_send, (const char *)&start, sizeof(start), 0);
+    mq_send(test_vmu_ev_mq_send, (const char *)&power, sizeof(power), 0);
+
+    seqcount_t seq_before = test_vmu_system_state->ev_seq;
+    receive_cmd(); // A single call drains the whole burst
+
+    struct mq_attr attr;
+    mq_getattr(ev_transport.queues[TRANSPORT_EV], &attr);
+    ck_assert_int_eq(attr.mq_curmsgs, 0);
+    ck_assert_msg(test_vmu_system_state->ev_on == true, "EV should be ON after the batch");
+    ck_assert_msg(test_vmu_system_state->ev_seq == seq_before + 2, "Batch should be applied in one write section");
+}
+END_TEST
+
+START_TEST(test_ev_receive_cmd_batch_start_then_stop)
+{
+    test_vmu_system_state->rpm_ev = 1500;
+    EngineCommand start = { .type = CMD_START };
+    EngineCommand stop = { .type = CMD_STOP };
+    mq_send(test_vmu_ev_mq_send, (const char *)&start, sizeof(start), 0);
+    mq_send(test_vmu_ev_mq_send, (const char *)&stop, sizeof(stop), 0);
+
+    receive_cmd();
+
+    // The last state change wins, with the same side effects as applying them one by one
+    ck_assert_msg(test_vmu_system_state->ev_on == false, "EV should be OFF when STOP follows START");
+    ck_assert_msg(test_vmu_system_state->rpm_ev == 0, "EV RPM should be 0 after STOP");
+}
+END_TEST
+
 START_TEST(test_ev_receive_multiple_commands)
 {
     EngineCommand cmd1 = { .type = CMD_START };
@@ -797,6 +956,42 @@ END_TEST
 
 // --- Signal handler testing (Optional and Advanced) ---
 // Testing signal handlers directly in unit tests is complex.
+START_TEST(test_ev_ring_receive_start_and_end)
+{
+    ck_assert_ptr_ne(ev_transport.rings[TRANSPORT_EV], NULL);
+
+    EngineCommand start = { .type = CMD_START };
+    ck_assert_int_eq(cmd_ring_push(test_vmu_ev_ring, &start), 0);
+    receive_cmd();
+    ck_assert_msg(test_vmu_system_state->ev_on == true, "EV should be ON after START over the ring");
+
+    EngineCommand end = { .type = CMD_END };
+    ck_assert_int_eq(cmd_ring_push(test_vmu_ev_ring, &end), 0);
+    receive_cmd();
+    ck_assert_msg(running == 0, "Running flag should be 0 after END over the ring");
+}
+END_TEST
+
+START_TEST(test_ev_ring_wait_cmd)
+{
+    struct timespec timeout = { 0, 10000000 }; // 10 ms
+    ck_assert_int_eq(wait_cmd(&timeout), 0);
+
+    EngineCommand start = { .type = CMD_START };
+    ck_assert_int_eq(cmd_ring_push(test_vmu_ev_ring, &start), 0);
+    ck_assert_int_eq(wait_cmd(&timeout), 1);
+}
+END_TEST
+
+START_TEST(test_ev_ring_receive_empty)
+{
+    int initial_running = running;
+    receive_cmd(); // Nothing pending: must return without blocking or changing state
+    ck_assert_msg(running == initial_running, "Running flag should not change on empty ring");
+    ck_assert_msg(test_vmu_system_state->ev_on == false, "EV state should not change on empty ring");
+}
+END_TEST
+
 // You would typically test the *logic* inside the handler or use mocking.
 // For handle_signal, it modifies global volatile flags. We can test if those flags
 // are modified when a signal *would* be received, but we can't easily send a real signal
@@ -851,6 +1046,7 @@ Suite *ev_suite(void) {
     TCase *tc_signals; // Signal handler tests (direct call)
     TCase *tc_edge_cases; // Edge case tests
     TCase *tc_init_comm_fail; // Init communication tests fails
+    TCase *tc_ring; // Shared-memory command ring transport tests
 
     s = suite_create("EV Module Tests");
 
@@ -875,9 +1071,24 @@ Suite *ev_suite(void) {
     tcase_add_test(tc_commands, test_ev_receive_cmd_end);
     tcase_add_test(tc_commands, test_ev_receive_cmd_unknown); // Test for unknown command
     tcase_add_test(tc_commands, test_ev_receive_cmd_empty_queue); // Test empty queue
+    tcase_add_test(tc_commands, test_ev_wait_cmd_ready); // Test wake-up on a queued command
+    tcase_add_test(tc_commands, test_ev_wait_cmd_timeout); // Test wait timeout on an empty queue
     tcase_add_test(tc_commands, test_ev_receive_multiple_commands); // Test multiple commands
+    tcase_add_test(tc_commands, test_ev_receive_cmd_batch_start_set_power); // Test drain-all batch
+    tcase_add_test(tc_commands, test_ev_receive_cmd_batch_start_then_stop); // Test batch collapse
+    tcase_add_test(tc_commands, test_ev_trace_command_latency); // Test end-to-end latency tracing
+    tcase_add_test(tc_commands, test_ev_trace_detects_lost_commands); // Test sequence gap detection
+    tcase_add_test(tc_commands, test_ev_receive_cmd_mailbox); // Test mailbox setpoints
     suite_add_tcase(s, tc_commands);
 
+    // Command processing over the shared-memory ring
+    tc_ring = tcase_create("RingTransport");
+    tcase_add_checked_fixture(tc_ring, ev_ring_setup, ev_ring_teardown);
+    tcase_add_test(tc_ring, test_ev_ring_receive_start_and_end);
+    tcase_add_test(tc_ring, test_ev_ring_receive_empty);
+    tcase_add_test(tc_ring, test_ev_ring_wait_cmd);
+    suite_add_tcase(s, tc_ring);
+
     // Engine simulation logic tests
     tc_engine = tcase_create("EngineLogic");
     tcase_add_checked_fixture(tc_engine, ev_setup, ev_teardown);
@@ -888,6 +1099,7 @@ Suite *ev_suite(void) {
     tcase_add_test(tc_engine, test_ev_engine_rpm_exactly_at_target); // Test RPM at target
     tcase_add_test(tc_engine, test_ev_engine_temperature_at_ambient); // Test temp at ambient
     tcase_add_test(tc_engine, test_ev_engine_temperature_exactly_at_cap); // Test temp at cap
+    tcase_add_test(tc_engine, test_ev_engine_publishes_sequence); // Test seqlock publication
     suite_add_tcase(s, tc_engine);
 
     // Signal handling tests (by direct function call)
@@ -0,0 +1,473 @@
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "../../src/fleet/fleet.h"
+#include "../../src/fleet/fleet_simd.h"
+#include "../../src/fleet/fleet_pool.h"
+
+static Fleet fleet;
+
+// --- Test Fixture Setup/Teardown Functions ---
+void fleet_setup(void) {
+    ck_assert_int_eq(fleet_init(&fleet, 13, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+}
+
+void fleet_teardown(void) {
+    fleet_free(&fleet);
+}
+
+// Checks that vehicle i of the fleet is bit-for-bit the vehicle of `sim`
+static void assert_same_vehicle(const Fleet *f, int i, const Simulation *sim) {
+    VehicleState vehicle;
+    memset(&vehicle, 0, sizeof(vehicle));
+    fleet_get_vehicle(f, i, &vehicle);
+    VehicleState expected = sim->vehicle;
+    ck_assert_int_eq(memcmp(&vehicle.speed, &expected.speed, sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(&vehicle.battery, &expected.battery, sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(&vehicle.fuel, &expected.fuel, sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(&vehicle.ev_power_level, &expected.ev_power_level, sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(&vehicle.iec_power_level, &expected.iec_power_level, sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(&vehicle.temp_ev, &expected.temp_ev, sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(&vehicle.temp_iec, &expected.temp_iec, sizeof(double)), 0);
+    ck_assert_int_eq(vehicle.power_mode, expected.power_mode);
+    ck_assert_int_eq(vehicle.was_accelerating, expected.was_accelerating);
+    ck_assert_int_eq(vehicle.ev_on, expected.ev_on);
+    ck_assert_int_eq(vehicle.rpm_ev, expected.rpm_ev);
+    ck_assert_int_eq(vehicle.iec_on, expected.iec_on);
+    ck_assert_int_eq(vehicle.rpm_iec, expected.rpm_iec);
+    ck_assert_int_eq(vehicle.accelerator, expected.accelerator);
+    ck_assert_int_eq(vehicle.brake, expected.brake);
+    ck_assert_int_eq(f->commands[i], sim->commands);
+    ck_assert_msg(f->distance_km[i] == sim->distance_km, "Distance of vehicle %d differs", i);
+    ck_assert_msg(f->max_speed[i] == sim->max_speed, "Max speed of vehicle %d differs", i);
+}
+
+// Picks a random value, often one of the thresholds of the control law
+static double random_value(const double *special, int count, double max) {
+    if (rand() % 3 == 0) {
+        return special[rand() % count];
+    }
+    return max * rand() / RAND_MAX;
+}
+
+// Fills the fleet with random, valid vehicle states
+static void randomize_fleet(Fleet *f) {
+    static const double speeds[] = {0.0, 0.05, 0.1, 1.0, 39.99, 40.0, 59.99, 60.0, 70.0, 80.0, 159.9, 160.0};
+    static const double charges[] = {0.0, 4.9, 5.0, 5.1, 9.99, 10.0, 10.01, 79.9, 80.0, 99.999, 100.0};
+    static const double levels[] = {0.0, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0};
+    static const double temps[] = {25.0, 25.005, 25.01, 89.99, 90.0, 104.99, 105.0};
+    static const double rpms[] = {0.0, 200.0, 800.0, 1000.0, 4960.0, 5000.0, 6000.0, 10000.0};
+
+    for (int i = 0; i < f->count; i++) {
+        VehicleState vehicle;
+        init_vehicle_state(&vehicle);
+        vehicle.accelerator = rand() % 2;
+        vehicle.brake = !vehicle.accelerator && rand() % 2;
+        vehicle.speed = random_value(speeds, 12, MAX_SPEED);
+        vehicle.battery = random_value(charges, 11, MAX_BATTERY);
+        vehicle.fuel = random_value(charges, 11, MAX_FUEL);
+        vehicle.ev_power_level = random_value(levels, 9, 1.0);
+        vehicle.iec_power_level = random_value(levels, 9, 1.0);
+        vehicle.was_accelerating = rand() % 2;
+        vehicle.power_mode = rand() % 6;
+        vehicle.ev_on = rand() % 2;
+        vehicle.iec_on = rand() % 2;
+        vehicle.rpm_ev = (int)random_value(rpms, 8, MAX_EV_RPM);
+        vehicle.rpm_iec = (int)random_value(rpms, 7, MAX_IEC_RPM);
+        vehicle.temp_ev = fmax(random_value(temps, 5, MAX_EV_TEMP), 25.0);
+        vehicle.temp_iec = fmax(random_value(temps, 7, MAX_IEC_TEMP), 25.0);
+        fleet_put_vehicle(f, i, &vehicle);
+    }
+}
+
+// Checks that the control outputs of two fleets are bit-for-bit identical
+static void assert_same_control(const Fleet *a, const Fleet *b) {
+    size_t n = (size_t)a->count;
+    ck_assert_int_eq(memcmp(a->ev_power_level, b->ev_power_level, n * sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(a->iec_power_level, b->iec_power_level, n * sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(a->battery, b->battery, n * sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(a->fuel, b->fuel, n * sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(a->power_mode, b->power_mode, n * sizeof(int)), 0);
+    ck_assert_int_eq(memcmp(a->ev_command, b->ev_command, n * sizeof(int)), 0);
+    ck_assert_int_eq(memcmp(a->iec_command, b->iec_command, n * sizeof(int)), 0);
+    ck_assert_int_eq(memcmp(a->was_accelerating, b->was_accelerating, n * sizeof(bool)), 0);
+}
+
+// Checks that the physics outputs of two fleets are bit-for-bit identical
+static void assert_same_physics(const Fleet *a, const Fleet *b) {
+    size_t n = (size_t)a->count;
+    ck_assert_int_eq(memcmp(a->speed, b->speed, n * sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(a->rpm_ev, b->rpm_ev, n * sizeof(int)), 0);
+    ck_assert_int_eq(memcmp(a->temp_ev, b->temp_ev, n * sizeof(double)), 0);
+    ck_assert_int_eq(memcmp(a->rpm_iec, b->rpm_iec, n * sizeof(int)), 0);
+    ck_assert_int_eq(memcmp(a->temp_iec, b->temp_iec, n * sizeof(double)), 0);
+}
+
+// --- Storage tests ---
+
+START_TEST(test_fleet_init)
+{
+    ck_assert_int_eq(fleet.count, 13);
+    ck_assert_int_eq(fleet.capacity, 16);
+    ck_assert_int_eq((uintptr_t)fleet.speed % FLEET_ALIGNMENT, 0);
+    ck_assert_int_eq((uintptr_t)fleet.rpm_iec % FLEET_ALIGNMENT, 0);
+    ck_assert_int_eq((uintptr_t)fleet.ev_on % FLEET_ALIGNMENT, 0);
+
+    // Every vehicle, padding included, starts parked
+    Simulation sim;
+    sim_init(&sim, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    for (int i = 0; i < fleet.capacity; i++) {
+        assert_same_vehicle(&fleet, i, &sim);
+    }
+
+    Fleet empty;
+    ck_assert_int_eq(fleet_init(&empty, 0, VMU_PERIOD_NS, ENGINE_PERIOD_NS), -1);
+}
+END_TEST
+
+START_TEST(test_fleet_get_put_vehicle)
+{
+    VehicleState vehicle, read;
+    memset(&vehicle, 0, sizeof(vehicle)); // Compare padding bytes too
+    memset(&read, 0, sizeof(read));
+    init_vehicle_state(&vehicle);
+    vehicle.speed = 42.5;
+    vehicle.battery = 55.0;
+    vehicle.rpm_iec = 3100;
+    vehicle.iec_on = true;
+    vehicle.power_mode = 1;
+    fleet_put_vehicle(&fleet, 7, &vehicle);
+
+    fleet_get_vehicle(&fleet, 7, &read);
+    ck_assert_int_eq(memcmp(&read, &vehicle, sizeof(vehicle)), 0);
+
+    // Neighbours are untouched
+    ck_assert_msg(fleet.speed[6] == MIN_SPEED && fleet.speed[8] == MIN_SPEED, "Only vehicle 7 should change");
+}
+END_TEST
+
+// --- Pedal script tests ---
+
+START_TEST(test_fleet_script_pedal)
+{
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("1:1,0:0.5,2:0.5", &script), 1);
+    FleetScript fleet_script;
+    fleet_script_init(&fleet_script, &script, 500000000ULL);
+    ck_assert_int_eq(fleet_script.length_ns, 2000000000ULL);
+
+    // Vehicle 0: boundaries belong to the segment ending there
+    ck_assert_int_eq(fleet_script_pedal(&fleet_script, 0, 200000000ULL), PEDAL_ACCELERATE);
+    ck_assert_int_eq(fleet_script_pedal(&fleet_script, 0, 1000000000ULL), PEDAL_ACCELERATE);
+    ck_assert_int_eq(fleet_script_pedal(&fleet_script, 0, 1200000000ULL), PEDAL_RELEASED);
+    ck_assert_int_eq(fleet_script_pedal(&fleet_script, 0, 1800000000ULL), PEDAL_BRAKE);
+    ck_assert_int_eq(fleet_script_pedal(&fleet_script, 0, 2000000000ULL), PEDAL_BRAKE);
+    ck_assert_int_eq(fleet_script_pedal(&fleet_script, 0, 2200000000ULL), PEDAL_ACCELERATE);
+
+    // Vehicle 1 is half a second ahead, vehicle 3 wraps around
+    ck_assert_int_eq(fleet_script_pedal(&fleet_script, 1, 800000000ULL), PEDAL_RELEASED);
+    ck_assert_int_eq(fleet_script_pedal(&fleet_script, 3, 800000000ULL), PEDAL_ACCELERATE);
+}
+END_TEST
+
+// --- Equivalence with the single-vehicle simulation ---
+
+START_TEST(test_fleet_matches_sim)
+{
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("1:45,0:20,1:30,2:15,0:3.3", &script), 1);
+    FleetScript fleet_script;
+    fleet_script_init(&fleet_script, &script, 0);
+
+    Simulation sim;
+    sim_init(&sim, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    sim_run_script(&sim, &script, 3, NULL);
+
+    // Every control kernel the CPU supports reproduces the single-vehicle simulation
+    for (int k = FLEET_KERNEL_SCALAR; k <= FLEET_KERNEL_AVX2; k++) {
+        if (!fleet_kernel_supported((FleetKernel)k)) {
+            continue;
+        }
+        ck_assert_int_eq(fleet_set_kernel((FleetKernel)k), k);
+
+        Fleet f;
+        ck_assert_int_eq(fleet_init(&f, 13, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+        fleet_advance(&f, fleet_script.length_ns * 3, &fleet_script);
+        ck_assert_int_eq(f.vmu_steps, sim.vmu_steps);
+        ck_assert_int_eq(f.engine_steps, sim.engine_steps);
+        ck_assert_int_eq(f.time_ns, sim.time_ns);
+        for (int i = 0; i < f.count; i++) {
+            assert_same_vehicle(&f, i, &sim);
+        }
+        fleet_free(&f);
+    }
+    fleet_set_kernel(FLEET_KERNEL_AUTO);
+}
+END_TEST
+
+// --- Vector kernel conformance ---
+
+START_TEST(test_fleet_kernel_selection)
+{
+    FleetKernel kernel;
+    ck_assert_int_eq(parse_fleet_kernel("avx2", &kernel), 1);
+    ck_assert_int_eq(kernel, FLEET_KERNEL_AVX2);
+    ck_assert_int_eq(parse_fleet_kernel("auto", &kernel), 1);
+    ck_assert_int_eq(kernel, FLEET_KERNEL_AUTO);
+    ck_assert_int_eq(parse_fleet_kernel("neon", &kernel), 0);
+
+    ck_assert_int_eq(fleet_set_kernel(FLEET_KERNEL_SCALAR), FLEET_KERNEL_SCALAR);
+    ck_assert_int_eq(fleet_get_kernel(), FLEET_KERNEL_SCALAR);
+
+    // Auto picks a supported kernel, never itself
+    kernel = fleet_set_kernel(FLEET_KERNEL_AUTO);
+    ck_assert_int_ne(kernel, FLEET_KERNEL_AUTO);
+    ck_assert_msg(fleet_kernel_supported(kernel), "Selected kernel must be supported");
+}
+END_TEST
+
+START_TEST(test_fleet_control_conformance)
+{
+    // Odd count so the vector kernels also run their scalar tail
+    Fleet reference, vectorized;
+    ck_assert_int_eq(fleet_init(&reference, 1003, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+    ck_assert_int_eq(fleet_init(&vectorized, 1003, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+
+    for (int k = FLEET_KERNEL_SSE2; k <= FLEET_KERNEL_AVX2; k++) {
+        if (!fleet_kernel_supported((FleetKernel)k)) {
+            continue;
+        }
+        for (int round = 0; round < 50; round++) {
+            srand(round + 1);
+            randomize_fleet(&reference);
+            srand(round + 1);
+            randomize_fleet(&vectorized);
+
+            fleet_control_scalar(&reference, 0, reference.count);
+            if (k == FLEET_KERNEL_SSE2) {
+                fleet_control_sse2(&vectorized, 0, vectorized.count);
+            } else {
+                fleet_control_avx2(&vectorized, 0, vectorized.count);
+            }
+            assert_same_control(&reference, &vectorized);
+        }
+
+        // Unaligned sub-ranges leave the vehicles outside them untouched
+        srand(7);
+        randomize_fleet(&reference);
+        srand(7);
+        randomize_fleet(&vectorized);
+        fleet_control_scalar(&reference, 3, 500);
+        if (k == FLEET_KERNEL_SSE2) {
+            fleet_control_sse2(&vectorized, 3, 500);
+        } else {
+            fleet_control_avx2(&vectorized, 3, 500);
+        }
+        assert_same_control(&reference, &vectorized);
+    }
+
+    fleet_free(&reference);
+    fleet_free(&vectorized);
+}
+END_TEST
+
+START_TEST(test_fleet_staggered_matches_sim)
+{
+    // With a stagger of one full script each vehicle drives exactly the same cycle
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("1:50,2:10", &script), 1);
+    FleetScript fleet_script;
+    fleet_script_init(&fleet_script, &script, 60000000000ULL);
+
+    Simulation sim;
+    sim_init(&sim, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    sim_run_script(&sim, &script, 2, NULL);
+
+    fleet_advance(&fleet, fleet_script.length_ns * 2, &fleet_script);
+    for (int i = 0; i < fleet.count; i++) {
+        assert_same_vehicle(&fleet, i, &sim);
+    }
+}
+END_TEST
+
+START_TEST(test_fleet_vehicles_independent)
+{
+    // Without a script every vehicle keeps the pedals set in the arrays
+    for (int i = 0; i < fleet.count; i++) {
+        fleet.accelerator[i] = (i % 2 == 0);
+    }
+    fleet_advance(&fleet, 30000000000ULL, NULL);
+
+    Simulation driving, parked;
+    sim_init(&driving, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    sim_init(&parked, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    sim_set_pedal(&driving, PEDAL_ACCELERATE);
+    sim_advance(&driving, 30000000000ULL, NULL);
+    sim_advance(&parked, 30000000000ULL, NULL);
+
+    for (int i = 0; i < fleet.count; i++) {
+        assert_same_vehicle(&fleet, i, i % 2 == 0 ? &driving : &parked);
+    }
+    // Padding vehicles are never stepped
+    ck_assert_int_eq(fleet.commands[fleet.count], 0);
+}
+END_TEST
+
+START_TEST(test_fleet_physics_conformance)
+{
+    Fleet reference, vectorized;
+    ck_assert_int_eq(fleet_init(&reference, 1001, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+    ck_assert_int_eq(fleet_init(&vectorized, 1001, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+
+    for (int k = FLEET_KERNEL_SSE2; k <= FLEET_KERNEL_AVX2; k++) {
+        if (!fleet_kernel_supported((FleetKernel)k)) {
+            continue;
+        }
+        for (int round = 0; round < 50; round++) {
+            srand(round + 100);
+            randomize_fleet(&reference);
+            srand(round + 100);
+            randomize_fleet(&vectorized);
+
+            fleet_speed_scalar(&reference, 0, reference.count);
+            fleet_engines_scalar(&reference, 0, reference.count);
+            if (k == FLEET_KERNEL_SSE2) {
+                fleet_speed_sse2(&vectorized, 0, vectorized.count);
+                fleet_engines_sse2(&vectorized, 0, vectorized.count);
+            } else {
+                fleet_speed_avx2(&vectorized, 0, vectorized.count);
+                fleet_engines_avx2(&vectorized, 0, vectorized.count);
+            }
+            assert_same_physics(&reference, &vectorized);
+        }
+    }
+
+    fleet_free(&reference);
+    fleet_free(&vectorized);
+}
+END_TEST
+
+// --- Thread pool tests ---
+
+START_TEST(test_fleet_pool_deterministic)
+{
+    // 5000 vehicles: five chunks, the last one partial
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("1:40,0:10,2:8,1:20", &script), 1);
+    FleetScript fleet_script;
+    fleet_script_init(&fleet_script, &script, 300000000ULL);
+
+    Fleet serial;
+    ck_assert_int_eq(fleet_init(&serial, 5000, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+    fleet_advance(&serial, fleet_script.length_ns, &fleet_script);
+    uint64_t expected = fleet_checksum(&serial);
+
+    static const int thread_counts[] = {1, 2, 3, 8};
+    for (int t = 0; t < 4; t++) {
+        Fleet parallel;
+        static FleetPool pool;
+        ck_assert_int_eq(fleet_init(&parallel, 5000, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+        ck_assert_int_eq(fleet_pool_init(&pool, &parallel, thread_counts[t]), 0);
+        ck_assert_int_eq(pool.chunks, 5);
+
+        fleet_pool_advance(&pool, fleet_script.length_ns, &fleet_script);
+        ck_assert_int_eq(parallel.vmu_steps, serial.vmu_steps);
+        ck_assert_int_eq(parallel.engine_steps, serial.engine_steps);
+        ck_assert_msg(fleet_checksum(&parallel) == expected, "%d threads should give the serial result", thread_counts[t]);
+
+        // Every chunk ran exactly once per phase
+        unsigned long chunks = 0;
+        for (int w = 0; w < pool.threads; w++) {
+            chunks += pool.workers[w].chunks;
+        }
+        ck_assert_int_eq(chunks, 5 * (serial.vmu_steps + serial.engine_steps));
+
+        fleet_pool_destroy(&pool);
+        fleet_free(&parallel);
+    }
+    fleet_free(&serial);
+}
+END_TEST
+
+START_TEST(test_fleet_pool_invalid)
+{
+    static FleetPool pool;
+    ck_assert_int_eq(fleet_pool_init(&pool, &fleet, 0), -1);
+    ck_assert_int_eq(fleet_pool_init(&pool, &fleet, FLEET_MAX_THREADS + 1), -1);
+}
+END_TEST
+
+START_TEST(test_fleet_checksum)
+{
+    Fleet other;
+    ck_assert_int_eq(fleet_init(&other, 13, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+    ck_assert_msg(fleet_checksum(&fleet) == fleet_checksum(&other), "Identical fleets should hash equally");
+    other.rpm_iec[12] = 1;
+    ck_assert_msg(fleet_checksum(&fleet) != fleet_checksum(&other), "Any field change should change the hash");
+    fleet_free(&other);
+}
+END_TEST
+
+// --- Main Test Suite Creation ---
+
+Suite *fleet_suite(void) {
+    Suite *s;
+    TCase *tc_storage; // Structure-of-arrays storage tests
+    TCase *tc_script;  // Pedal script tests
+    TCase *tc_step;    // Equivalence with the single-vehicle simulation
+    TCase *tc_kernel;  // Vector kernel conformance
+    TCase *tc_pool;    // Thread pool tests
+
+    s = suite_create("Fleet Simulation Tests");
+
+    tc_storage = tcase_create("Storage");
+    tcase_add_checked_fixture(tc_storage, fleet_setup, fleet_teardown);
+    tcase_add_test(tc_storage, test_fleet_init);
+    tcase_add_test(tc_storage, test_fleet_get_put_vehicle);
+    suite_add_tcase(s, tc_storage);
+
+    tc_script = tcase_create("FleetScript");
+    tcase_add_test(tc_script, test_fleet_script_pedal);
+    suite_add_tcase(s, tc_script);
+
+    tc_step = tcase_create("Step");
+    tcase_add_checked_fixture(tc_step, fleet_setup, fleet_teardown);
+    tcase_add_test(tc_step, test_fleet_matches_sim);
+    tcase_add_test(tc_step, test_fleet_staggered_matches_sim);
+    tcase_add_test(tc_step, test_fleet_vehicles_independent);
+    suite_add_tcase(s, tc_step);
+
+    tc_kernel = tcase_create("Kernels");
+    tcase_add_test(tc_kernel, test_fleet_kernel_selection);
+    tcase_add_test(tc_kernel, test_fleet_control_conformance);
+    tcase_add_test(tc_kernel, test_fleet_physics_conformance);
+    suite_add_tcase(s, tc_kernel);
+
+    tc_pool = tcase_create("Pool");
+    tcase_add_checked_fixture(tc_pool, fleet_setup, fleet_teardown);
+    tcase_add_test(tc_pool, test_fleet_pool_deterministic);
+    tcase_add_test(tc_pool, test_fleet_pool_invalid);
+    tcase_add_test(tc_pool, test_fleet_checksum);
+    suite_add_tcase(s, tc_pool);
+
+    return s;
+}
+
+int main(void) {
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = fleet_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
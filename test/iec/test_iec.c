@@ -15,14 +15,14 @@
 
 #include "../../src/iec/iec.h"
 #include "../../src/vmu/vmu.h"
+#include "../../src/common/transport.h"
 
 // --- Declare external globals from iec.c ---
 extern SystemState *system_state;
 extern sem_t *sem;
-extern mqd_t iec_mq_receive;
+extern Transport iec_transport; // End of the transport opened by init_communication_iec()
 extern volatile sig_atomic_t running;
 extern volatile sig_atomic_t paused;
-extern int shm_fd; //Shared Memory File Descriptor
 
 // --- Test infrastructure variables (simulating VMU) ---
 static SystemState *test_vmu_system_state = NULL;
@@ -150,7 +150,7 @@ START_TEST(test_iec_init_communication_success)
 {
     ck_assert_ptr_ne(system_state, MAP_FAILED);
     ck_assert_ptr_ne(sem, SEM_FAILED);
-    ck_assert_int_ne(iec_mq_receive, (mqd_t)-1);
+    ck_assert_int_ne(iec_transport.queues[TRANSPORT_IEC], (mqd_t)-1);
     ck_assert_int_eq(running, 1);
     ck_assert_int_eq(paused, 0);
 }
@@ -159,13 +159,13 @@ END_TEST
 // Fail to open the Shared Memory File Descriptor
 START_TEST(test_init_communication_shm_fd_fail) {
     init_communication_iec("fail 1", "fail 2", "fail 3");
-    ck_assert_int_eq(shm_fd, -1);
+    ck_assert_int_eq(iec_transport.shm_fd, -1);
 }
 END_TEST
 
 // Fail to open the Semaphore
 START_TEST(test_init_communication_sem_fail) {
-    shm_fd = shm_open(SHARED_MEM_NAME, O_CREAT | O_RDWR, 0666);
+    int shm_fd = shm_open(SHARED_MEM_NAME, O_CREAT | O_RDWR, 0666);
     if(shm_fd == -1){
         perror("[IEC] Error opening shared Memory");
         exit(EXIT_FAILURE);
@@ -180,7 +180,7 @@ END_TEST
 
 // Fail to open IEC's Message Queue
 START_TEST(test_init_communication_iec_queue_fail) {
-    shm_fd = shm_open(SHARED_MEM_NAME, O_CREAT | O_RDWR, 0666);
+    int shm_fd = shm_open(SHARED_MEM_NAME, O_CREAT | O_RDWR, 0666);
     if(shm_fd == -1){
         perror("[IEC] Error opening shared Memory");
         exit(EXIT_FAILURE);
@@ -195,7 +195,7 @@ START_TEST(test_init_communication_iec_queue_fail) {
     sem_close(sem);
 
     init_communication_iec(SHARED_MEM_NAME, SEMAPHORE_NAME, "fail 3");
-    ck_assert_int_eq(iec_mq_receive, (mqd_t) - 1);
+    ck_assert_int_eq(iec_transport.queues[TRANSPORT_IEC], (mqd_t) - 1);
     shm_unlink(SHARED_MEM_NAME);
     sem_unlink(SEMAPHORE_NAME);
 }
@@ -290,7 +290,7 @@ END_TEST
 START_TEST(test_iec_receive_cmd_empty_queue)
 {
     EngineCommand dummy;
-    while (mq_receive(iec_mq_receive, (char *)&dummy, sizeof(dummy), NULL) != -1) {
+    while (mq_receive(iec_transport.queues[TRANSPORT_IEC], (char *)&dummy, sizeof(dummy), NULL) != -1) {
         // Keep reading until queue is empty
     }
 
@@ -301,6 +301,36 @@ START_TEST(test_iec_receive_cmd_empty_queue)
 }
 END_TEST
 
+START_TEST(test_iec_wait_cmd)
+{
+    struct timespec timeout = { 0, 10000000 }; // 10 ms
+    ck_assert_int_eq(wait_cmd(&timeout), 0); // Nothing queued: times out
+
+    EngineCommand start = { .type = CMD_START };
+    mq_send(test_vmu_iec_mq_send, (const char *)&start, sizeof(start), 0);
+    ck_assert_int_eq(wait_cmd(&timeout), 1); // Queued command wakes the engine
+}
+END_TEST
+
+START_TEST(test_iec_receive_cmd_batch_stop_then_start)
+{
+    test_vmu_system_state->iec_on = true;
+    test_vmu_system_state->rpm_iec = 3000;
+    EngineCommand stop = { .type = CMD_STOP };
+    EngineCommand start = { .type = CMD_START };
+    EngineCommand end = { .type = CMD_END };
+    mq_send(test_vmu_iec_mq_send, (const char *)&stop, sizeof(stop), 0);
+    mq_send(test_vmu_iec_mq_send, (const char *)&start, sizeof(start), 0);
+    mq_send(test_vmu_iec_mq_send, (const char *)&end, sizeof(end), 0);
+
+    receive_cmd(); // One call applies the whole burst
+
+    ck_assert_msg(test_vmu_system_state->iec_on == true, "IEC should be ON when START follows STOP");
+    ck_assert_int_eq(test_vmu_system_state->rpm_iec, IEC_IDLE_RPM);
+    ck_assert_msg(running == 0, "END in the same batch should stop the main loop");
+}
+END_TEST
+
 START_TEST(test_iec_engine_rpm_at_target)
 {
     int target_rpm = IEC_IDLE_RPM + (int)(0.5 * (MAX_IEC_RPM - IEC_IDLE_RPM));
@@ -715,7 +745,7 @@ START_TEST(test_iec_receive_cmd_mq_error_simulation)
 {
     // Verify the function handles empty queue gracefully
     EngineCommand dummy;
-    while (mq_receive(iec_mq_receive, (char *)&dummy, sizeof(dummy), NULL) != -1) {
+    while (mq_receive(iec_transport.queues[TRANSPORT_IEC], (char *)&dummy, sizeof(dummy), NULL) != -1) {
         // Keep reading until queue is empty
     }
 
@@ -840,6 +870,8 @@ Suite *iec_suite(void) {
     tcase_add_test(tc_commands, test_iec_receive_cmd_end);
     tcase_add_test(tc_commands, test_iec_receive_cmd_unknown);
     tcase_add_test(tc_commands, test_iec_receive_cmd_empty_queue);
+    tcase_add_test(tc_commands, test_iec_receive_cmd_batch_stop_then_start);
+    tcase_add_test(tc_commands, test_iec_wait_cmd);
     tcase_add_test(tc_commands, test_iec_receive_cmd_mq_error_simulation);
     suite_add_tcase(s, tc_commands);
 
@@ -0,0 +1,111 @@
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "../../src/ipcbench/ipcbench.h"
+
+// --- Transport tests ---
+
+START_TEST(test_transport_names)
+{
+    for (int t = 0; t < IPC_TRANSPORT_COUNT; t++) {
+        IpcTransport parsed;
+        ck_assert_int_eq(parse_ipc_transport(ipc_transport_name((IpcTransport)t), &parsed), 1);
+        ck_assert_int_eq(parsed, t);
+    }
+    IpcTransport parsed;
+    ck_assert_int_eq(parse_ipc_transport("carrier-pigeon", &parsed), 0);
+}
+END_TEST
+
+START_TEST(test_path_delivers_in_order)
+{
+    // Every transport holds a few commands without a reader (mq depth 10, ring 16)
+    for (int t = 0; t < IPC_TRANSPORT_COUNT; t++) {
+        IpcPath path;
+        ck_assert_int_eq(ipc_path_open(&path, (IpcTransport)t), 0);
+
+        for (unsigned int i = 1; i <= 5; i++) {
+            EngineCommand cmd = { .type = CMD_SET_POWER, .power_level = i / 10.0, .seq = i, .sent_ns = 1000ULL * i };
+            ck_assert_int_eq(ipc_send(&path, &cmd), 0);
+        }
+        for (unsigned int i = 1; i <= 5; i++) {
+            EngineCommand cmd;
+            ck_assert_int_eq(ipc_receive(&path, &cmd), 0);
+            ck_assert_msg(cmd.seq == i, "%s delivered seq %u, expected %u", ipc_transport_name((IpcTransport)t), cmd.seq, i);
+            ck_assert_int_eq(cmd.type, CMD_SET_POWER);
+            ck_assert(cmd.power_level == i / 10.0);
+            ck_assert_uint_eq(cmd.sent_ns, 1000ULL * i);
+        }
+        ipc_path_close(&path);
+    }
+}
+END_TEST
+
+// --- Benchmark tests ---
+
+START_TEST(test_round_trip_between_processes)
+{
+    for (int t = 0; t < IPC_TRANSPORT_COUNT; t++) {
+        IpcResult result;
+        ck_assert_msg(ipc_bench_round_trip((IpcTransport)t, 200, &result) == 0, "%s round trip failed", ipc_transport_name((IpcTransport)t));
+        ck_assert_int_eq(result.transport, t);
+        ck_assert_int_eq(result.rtt.count, 200);
+        ck_assert_uint_gt(hist_percentile(&result.rtt, 50.0), 0);
+        ck_assert_uint_le(hist_percentile(&result.rtt, 50.0), hist_percentile(&result.rtt, 99.0));
+        ck_assert(result.rtt_cpu_ns >= 0.0);
+    }
+}
+END_TEST
+
+START_TEST(test_stream_delivers_every_command)
+{
+    // Many more commands than any transport holds, so the sender is held back by a full queue
+    for (int t = 0; t < IPC_TRANSPORT_COUNT; t++) {
+        IpcResult result;
+        ck_assert_msg(ipc_bench_stream((IpcTransport)t, 5000, &result) == 0, "%s stream failed", ipc_transport_name((IpcTransport)t));
+        ck_assert_int_eq(result.messages, 5000);
+        ck_assert(result.messages_per_s > 0.0);
+    }
+}
+END_TEST
+
+// --- Main Test Suite Creation ---
+
+Suite *ipcbench_suite(void) {
+    Suite *s;
+    TCase *tc_transport; // Single-process transport tests
+    TCase *tc_bench;     // Two-process benchmark tests
+
+    s = suite_create("IPC Benchmark Tests");
+
+    tc_transport = tcase_create("Transports");
+    tcase_add_test(tc_transport, test_transport_names);
+    tcase_add_test(tc_transport, test_path_delivers_in_order);
+    suite_add_tcase(s, tc_transport);
+
+    tc_bench = tcase_create("Benchmark");
+    tcase_set_timeout(tc_bench, 30);
+    tcase_add_test(tc_bench, test_round_trip_between_processes);
+    tcase_add_test(tc_bench, test_stream_delivers_every_command);
+    suite_add_tcase(s, tc_bench);
+
+    return s;
+}
+
+int main(void) {
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = ipcbench_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
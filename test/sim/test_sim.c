@@ -0,0 +1,269 @@
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "../../src/sim/sim.h"
+
+static Simulation sim;
+
+// --- Test Fixture Setup Function ---
+void sim_setup(void) {
+    sim_init(&sim, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+}
+
+// --- Pedal script tests ---
+
+START_TEST(test_parse_script)
+{
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("1:30,0:10.5,2:5", &script), 1);
+    ck_assert_int_eq(script.count, 3);
+    ck_assert_int_eq(script.segments[0].pedal, PEDAL_ACCELERATE);
+    ck_assert_msg(script.segments[0].duration_s == 30.0, "First segment should last 30 s");
+    ck_assert_int_eq(script.segments[1].pedal, PEDAL_RELEASED);
+    ck_assert_msg(script.segments[1].duration_s == 10.5, "Fractional durations should be accepted");
+    ck_assert_int_eq(script.segments[2].pedal, PEDAL_BRAKE);
+}
+END_TEST
+
+START_TEST(test_parse_script_invalid)
+{
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("", &script), 0);
+    ck_assert_int_eq(parse_pedal_script("3:10", &script), 0);  // Unknown pedal
+    ck_assert_int_eq(parse_pedal_script("1:0", &script), 0);   // Empty segment
+    ck_assert_int_eq(parse_pedal_script("1:10;0:5", &script), 0);
+    ck_assert_int_eq(parse_pedal_script("1", &script), 0);
+}
+END_TEST
+
+// --- Lockstep simulation tests ---
+
+START_TEST(test_lockstep_step_counts)
+{
+    // 1.4 s is a common multiple of both periods: 7 VMU steps and 20 engine steps
+    sim_advance(&sim, 1400000000ULL, NULL);
+    ck_assert_int_eq(sim.vmu_steps, 7);
+    ck_assert_int_eq(sim.engine_steps, 20);
+    ck_assert_int_eq(sim.time_ns, 1400000000ULL);
+
+    // Advancing in small slices runs the same steps
+    Simulation sliced;
+    sim_init(&sliced, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    for (int i = 0; i < 140; i++) {
+        sim_advance(&sliced, 10000000ULL, NULL);
+    }
+    ck_assert_int_eq(sliced.vmu_steps, 7);
+    ck_assert_int_eq(sliced.engine_steps, 20);
+}
+END_TEST
+
+// Step hook counting the steps of each loop and pressing the accelerator from the third VMU step
+static void count_steps(Simulation *hooked, SimStep step, void *context) {
+    unsigned long *counts = (unsigned long *)context;
+    ck_assert_uint_eq(hooked->time_ns, step == SIM_STEP_VMU ? hooked->next_vmu_ns : hooked->next_engine_ns);
+    if (++counts[step] == 3 && step == SIM_STEP_VMU) {
+        sim_set_pedal(hooked, PEDAL_ACCELERATE);
+    }
+}
+
+START_TEST(test_step_hook)
+{
+    unsigned long counts[2] = {0, 0};
+    sim.step_hook = count_steps;
+    sim.step_hook_context = counts;
+    sim_advance(&sim, 1400000000ULL, NULL);
+    ck_assert_uint_eq(counts[SIM_STEP_VMU], 7);
+    ck_assert_uint_eq(counts[SIM_STEP_ENGINE], 20);
+
+    // Same run as setting the pedal between two sim_advance() calls at the third VMU step
+    Simulation other;
+    sim_init(&other, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    sim_advance(&other, 2 * VMU_PERIOD_NS, NULL);
+    sim_set_pedal(&other, PEDAL_ACCELERATE);
+    sim_advance(&other, 1400000000ULL - 2 * VMU_PERIOD_NS, NULL);
+    ck_assert_int_eq(memcmp(&sim.vehicle, &other.vehicle, sizeof(VehicleState)), 0);
+    ck_assert_int_eq(sim.commands, other.commands);
+}
+END_TEST
+
+START_TEST(test_parked_stays_parked)
+{
+    sim_set_pedal(&sim, PEDAL_RELEASED);
+    sim_advance(&sim, 10000000000ULL, NULL);
+    ck_assert_msg(sim.vehicle.speed == MIN_SPEED, "Vehicle should not move without input");
+    ck_assert_int_eq(sim.vehicle.power_mode, 4);
+    ck_assert_int_eq(sim.commands, 0);
+}
+END_TEST
+
+START_TEST(test_accelerate_starts_ev_then_hybrid)
+{
+    sim_set_pedal(&sim, PEDAL_ACCELERATE);
+    sim_advance(&sim, VMU_PERIOD_NS, NULL);
+    ck_assert_msg(sim.vehicle.ev_on, "First VMU step should start the EV");
+    ck_assert_msg(!sim.vehicle.iec_on, "IEC should stay off at low speed");
+
+    sim_advance(&sim, 60000000000ULL, NULL);
+    ck_assert_msg(sim.vehicle.speed >= ELECTRIC_ONLY_SPEED_THRESHOLD, "Vehicle should accelerate past the EV-only range");
+    ck_assert_msg(sim.vehicle.iec_on, "IEC should join in hybrid mode");
+    ck_assert_int_eq(sim.vehicle.power_mode, 1);
+    ck_assert_int_gt(sim.vehicle.rpm_ev, 0);
+    ck_assert_msg(sim.vehicle.battery < MAX_BATTERY, "Driving should use battery");
+    ck_assert_msg(sim.vehicle.fuel < MAX_FUEL, "Hybrid driving should use fuel");
+}
+END_TEST
+
+START_TEST(test_brake_to_stop)
+{
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("1:30,2:20", &script), 1);
+    sim_run_script(&sim, &script, 1, NULL);
+
+    ck_assert_msg(sim.vehicle.speed == MIN_SPEED, "Braking should bring the vehicle to a stop");
+    ck_assert_msg(!sim.vehicle.ev_on && !sim.vehicle.iec_on, "Engines should be stopped");
+    ck_assert_msg(sim.distance_km > 0.0, "Distance should be accumulated");
+}
+END_TEST
+
+START_TEST(test_deterministic)
+{
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("1:45,0:20,1:30,2:15", &script), 1);
+
+    Simulation other;
+    sim_init(&other, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    sim_run_script(&sim, &script, 3, NULL);
+    sim_run_script(&other, &script, 3, NULL);
+
+    ck_assert_int_eq(memcmp(&sim.vehicle, &other.vehicle, sizeof(VehicleState)), 0);
+    ck_assert_int_eq(sim.commands, other.commands);
+}
+END_TEST
+
+START_TEST(test_trace_rows)
+{
+    char buffer[8192] = {0};
+    FILE *trace = fmemopen(buffer, sizeof(buffer) - 1, "w");
+    ck_assert_ptr_ne(trace, NULL);
+
+    sim_trace_header(trace);
+    sim_set_pedal(&sim, PEDAL_ACCELERATE);
+    sim_advance(&sim, 1000000000ULL, trace);
+    fclose(trace);
+
+    // Header plus one row per VMU step
+    int lines = 0;
+    for (char *p = buffer; *p != '\0'; p++) {
+        if (*p == '\n') lines++;
+    }
+    ck_assert_int_eq(lines, 1 + 5);
+    ck_assert_ptr_ne(strstr(buffer, "\n0.200,1,0,"), NULL);
+}
+END_TEST
+
+START_TEST(test_pedal_trace_matches_script)
+{
+    // Segment boundaries belong to the segment that ends there, so the equivalent trace events sit
+    // just after them; the last event only marks the end of the drive
+    const char *text = "0 1\n60.1 0\n90.1 2\n100 2\n";
+    PedalTrace pedal_trace;
+    ck_assert_int_eq(pedal_trace_parse(text, strlen(text), &pedal_trace), 0);
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("1:60,0:30,2:10", &script), 1);
+
+    Simulation other;
+    sim_init(&other, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    sim_run_pedal_trace(&sim, &pedal_trace, NULL);
+    sim_run_script(&other, &script, 1, NULL);
+    pedal_trace_free(&pedal_trace);
+
+    ck_assert_uint_eq(sim.time_ns, other.time_ns);
+    ck_assert_int_eq(sim.vmu_steps, other.vmu_steps);
+    ck_assert_int_eq(sim.engine_steps, other.engine_steps);
+    ck_assert_int_eq(sim.commands, other.commands);
+    ck_assert_int_eq(memcmp(&sim.vehicle, &other.vehicle, sizeof(VehicleState)), 0);
+    ck_assert(sim.distance_km == other.distance_km);
+}
+END_TEST
+
+START_TEST(test_telemetry_records_vmu_steps)
+{
+    char path[] = "/tmp/test_sim_telemetry_XXXXXX";
+    int fd = mkstemp(path);
+    ck_assert_int_ne(fd, -1);
+    close(fd);
+    TelemetryLog telemetry;
+    ck_assert_int_eq(telemetry_create(&telemetry, path, 1024, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+    sim.telemetry = &telemetry;
+
+    Simulation other; // Recording does not change the run
+    sim_init(&other, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script("1:20,2:5", &script), 1);
+    sim_run_script(&sim, &script, 1, NULL);
+    sim_run_script(&other, &script, 1, NULL);
+    ck_assert_int_eq(memcmp(&sim.vehicle, &other.vehicle, sizeof(VehicleState)), 0);
+
+    ck_assert_uint_eq(telemetry_count(&telemetry), sim.vmu_steps);
+    const TelemetryRecord *first = telemetry_get(&telemetry, 0);
+    ck_assert_uint_eq(first->tick, 1);
+    ck_assert_uint_eq(first->time_ns, VMU_PERIOD_NS);
+    ck_assert(first->before.speed == 0.0 && first->before.accelerator);
+    ck_assert_int_eq(first->ev_command, CMD_START); // The EV starts on the first press
+    const TelemetryRecord *last = telemetry_get(&telemetry, sim.vmu_steps - 1);
+    ck_assert_uint_eq(last->tick, sim.vmu_steps);
+    ck_assert(last->after.speed == sim.vehicle.speed && last->after.battery == sim.vehicle.battery);
+
+    telemetry_close(&telemetry);
+    unlink(path);
+}
+END_TEST
+
+// --- Main Test Suite Creation ---
+
+Suite *sim_suite(void) {
+    Suite *s;
+    TCase *tc_script; // Pedal script tests
+    TCase *tc_sim;    // Lockstep simulation tests
+
+    s = suite_create("Headless Simulation Tests");
+
+    tc_script = tcase_create("PedalScript");
+    tcase_add_test(tc_script, test_parse_script);
+    tcase_add_test(tc_script, test_parse_script_invalid);
+    suite_add_tcase(s, tc_script);
+
+    tc_sim = tcase_create("Lockstep");
+    tcase_add_checked_fixture(tc_sim, sim_setup, NULL);
+    tcase_add_test(tc_sim, test_lockstep_step_counts);
+    tcase_add_test(tc_sim, test_step_hook);
+    tcase_add_test(tc_sim, test_parked_stays_parked);
+    tcase_add_test(tc_sim, test_accelerate_starts_ev_then_hybrid);
+    tcase_add_test(tc_sim, test_brake_to_stop);
+    tcase_add_test(tc_sim, test_deterministic);
+    tcase_add_test(tc_sim, test_trace_rows);
+    tcase_add_test(tc_sim, test_pedal_trace_matches_script);
+    tcase_add_test(tc_sim, test_telemetry_records_vmu_steps);
+    suite_add_tcase(s, tc_sim);
+
+    return s;
+}
+
+int main(void) {
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = sim_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
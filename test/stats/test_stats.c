@@ -0,0 +1,178 @@
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <stdbool.h>
+#include <sys/wait.h>
+
+#include "../../src/stats/stats.h"
+
+#define TEST_STATS_NAME "/test_stats_page"
+#define TEST_DISPLAY_STATS_NAME "/test_stats_display_page"
+
+// --- Test Fixture Setup Function ---
+void stats_setup(void) {
+    // Simulate a module publishing its statistics
+    ck_assert_ptr_ne(stats_open(TEST_STATS_NAME, "ev"), NULL);
+}
+
+// --- Test Fixture Teardown Function ---
+void stats_teardown(void) {
+    stats_close(TEST_STATS_NAME);
+}
+
+START_TEST(test_map_missing_page)
+{
+    ck_assert_ptr_eq(map_stats_page("/test_stats_not_running"), NULL);
+}
+END_TEST
+
+START_TEST(test_copy_sees_writer_records)
+{
+    stats_record(STAT_ENGINE, 1500);
+    stats_record(STAT_ENGINE, 2500);
+    stats_record(STAT_RECEIVE_CMD, 300);
+
+    const StatsPage *page = map_stats_page(TEST_STATS_NAME);
+    ck_assert_ptr_ne(page, NULL);
+
+    StatsPage copy;
+    ck_assert_int_eq(copy_stats_page(page, &copy), 1);
+    ck_assert_str_eq(copy.module, "ev");
+    ck_assert_int_eq(copy.hist[STAT_ENGINE].count, 2);
+    ck_assert_int_eq(copy.hist[STAT_ENGINE].max_ns, 2500);
+    ck_assert_int_eq(copy.hist[STAT_RECEIVE_CMD].count, 1);
+    ck_assert_int_eq(copy.hist[STAT_DISPLAY_STATUS].count, 0); // Recorded in the display page only
+    unmap_stats_page(page);
+}
+END_TEST
+
+START_TEST(test_page_is_read_only_for_readers)
+{
+    const StatsPage *page = map_stats_page(TEST_STATS_NAME);
+    ck_assert_ptr_ne(page, NULL);
+
+    // Writing through the reader's mapping must fault
+    pid_t pid = fork();
+    if (pid == 0) {
+        ((StatsPage *)page)->hist[0].count = 42;
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    ck_assert_msg(WIFSIGNALED(status), "Reader mapping should be read-only");
+    unmap_stats_page(page);
+}
+END_TEST
+
+START_TEST(test_copy_waits_for_write_in_progress)
+{
+    const StatsPage *page = map_stats_page(TEST_STATS_NAME);
+    ck_assert_ptr_ne(page, NULL);
+
+    // A writer stuck mid-update (odd sequence) must not yield a torn copy
+    StatsPage copy;
+    seqlock_write_begin(&stats_page->seq);
+    pid_t pid = fork();
+    if (pid == 0) {
+        alarm(1);
+        _exit(copy_stats_page(page, &copy)); // Spins on the odd sequence
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    ck_assert_msg(WIFSIGNALED(status), "Reader should wait for the write to finish");
+    seqlock_write_end(&stats_page->seq);
+
+    ck_assert_int_eq(copy_stats_page(page, &copy), 1);
+    unmap_stats_page(page);
+}
+END_TEST
+
+START_TEST(test_print_stats)
+{
+    char buffer[1024] = {0};
+    FILE *out = fmemopen(buffer, sizeof(buffer) - 1, "w");
+    ck_assert_ptr_ne(out, NULL);
+
+    for (int i = 1; i <= 100; i++) {
+        stats_record(STAT_ENGINE, i * 1000ULL); // 1..100 us
+    }
+    print_stats(out, stats_page);
+    fclose(out);
+
+    // Only histograms with samples are printed, one line each
+    ck_assert_ptr_ne(strstr(buffer, "engine"), NULL);
+    ck_assert_ptr_eq(strstr(buffer, "display_status"), NULL);
+    ck_assert_ptr_ne(strstr(buffer, "100.0\n"), NULL); // max in microseconds
+}
+END_TEST
+
+START_TEST(test_display_page_beside_process_page)
+{
+    // The status screen thread writes a page of its own, next to the page of the control loop
+    StatsPage *display = stats_page_create(TEST_DISPLAY_STATS_NAME, "display");
+    ck_assert_ptr_ne(display, NULL);
+    ck_assert_ptr_ne(display, stats_page);
+    stats_page_record(display, STAT_DISPLAY_STATUS, 250000);
+    stats_record(STAT_PUBLISH, 1000);
+
+    const StatsPage *page = map_stats_page(TEST_DISPLAY_STATS_NAME);
+    ck_assert_ptr_ne(page, NULL);
+    StatsPage copy;
+    ck_assert_int_eq(copy_stats_page(page, &copy), 1);
+    ck_assert_str_eq(copy.module, "display");
+    ck_assert_int_eq(copy.hist[STAT_DISPLAY_STATUS].count, 1);
+    ck_assert_int_eq(copy.hist[STAT_PUBLISH].count, 0);
+    ck_assert_int_eq(stats_page->hist[STAT_DISPLAY_STATUS].count, 0);
+
+    char buffer[512] = {0};
+    FILE *out = fmemopen(buffer, sizeof(buffer) - 1, "w");
+    ck_assert_ptr_ne(out, NULL);
+    print_stats(out, &copy);
+    fclose(out);
+    ck_assert_ptr_ne(strstr(buffer, "display display_status"), NULL);
+    unmap_stats_page(page);
+
+    stats_page_destroy(display, TEST_DISPLAY_STATS_NAME);
+    ck_assert_ptr_eq(map_stats_page(TEST_DISPLAY_STATS_NAME), NULL);
+}
+END_TEST
+
+// --- Main Test Suite Creation ---
+
+Suite *stats_suite(void) {
+    Suite *s;
+    TCase *tc_reader; // Statistics reader tests
+
+    s = suite_create("Stats Reader Tests");
+
+    tc_reader = tcase_create("Reader");
+    tcase_add_checked_fixture(tc_reader, stats_setup, stats_teardown);
+    tcase_add_test(tc_reader, test_map_missing_page);
+    tcase_add_test(tc_reader, test_copy_sees_writer_records);
+    tcase_add_test(tc_reader, test_page_is_read_only_for_readers);
+    tcase_add_test(tc_reader, test_copy_waits_for_write_in_progress);
+    tcase_add_test(tc_reader, test_print_stats);
+    tcase_add_test(tc_reader, test_display_page_beside_process_page);
+    suite_add_tcase(s, tc_reader);
+
+    return s;
+}
+
+int main(void) {
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = stats_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,372 @@
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "../../src/telemetry/dump.h"
+#include "../../src/telemetry/replay.h"
+#include "../../src/sim/sim.h"
+
+static char path[] = "/tmp/test_telemetry_dump_XXXXXX";
+static TelemetryLog log_file;
+
+static void setup(void) {
+    strcpy(path, "/tmp/test_telemetry_dump_XXXXXX");
+    int fd = mkstemp(path);
+    ck_assert_int_ne(fd, -1);
+    close(fd);
+    ck_assert_int_eq(telemetry_create(&log_file, path, 8, 200000000ULL, 0), 0);
+}
+
+static void teardown(void) {
+    telemetry_close(&log_file);
+    unlink(path);
+}
+
+// Appends ticks first..last, 200 ms apart except for one late tick at `late` (0 for none)
+static void append_ticks(uint64_t first, uint64_t last, uint64_t late) {
+    for (uint64_t tick = first; tick <= last; tick++) {
+        TelemetryRecord record;
+        VehicleState vehicle;
+        init_vehicle_state(&vehicle);
+        vehicle.speed = (double)tick;
+        memset(&record, 0, sizeof(record));
+        record.tick = tick;
+        record.time_ns = tick * 200000000ULL + (tick >= late && late != 0 ? 50000000ULL : 0);
+        telemetry_vehicle_pack(&vehicle, &record.before);
+        telemetry_vehicle_pack(&vehicle, &record.after);
+        record.ev_command = tick == 2 ? CMD_START : TELEMETRY_NO_COMMAND;
+        record.iec_command = TELEMETRY_NO_COMMAND;
+        telemetry_append(&log_file, &record);
+    }
+}
+
+// --- Summary tests ---
+
+START_TEST(test_summary_empty)
+{
+    TelemetrySummary summary;
+    telemetry_summarize(&log_file, &summary);
+    ck_assert_uint_eq(summary.appended, 0);
+    ck_assert_uint_eq(summary.kept, 0);
+}
+END_TEST
+
+START_TEST(test_summary_intervals)
+{
+    append_ticks(1, 5, 4);
+
+    TelemetrySummary summary;
+    telemetry_summarize(&log_file, &summary);
+    ck_assert_uint_eq(summary.appended, 5);
+    ck_assert_uint_eq(summary.kept, 5);
+    ck_assert_uint_eq(summary.first_tick, 1);
+    ck_assert_uint_eq(summary.last_tick, 5);
+    ck_assert_uint_eq(summary.tick_gaps, 0);
+    ck_assert_double_eq_tol(summary.span_s, 0.85, 1e-9);
+    ck_assert_double_eq_tol(summary.max_interval_ms, 250.0, 1e-6);
+    ck_assert_double_eq_tol(summary.mean_interval_ms, 212.5, 1e-6);
+}
+END_TEST
+
+START_TEST(test_summary_wrapped_ring)
+{
+    append_ticks(1, 3, 0);
+    append_ticks(5, 15, 0); // Tick 4 missing
+
+    TelemetrySummary summary;
+    telemetry_summarize(&log_file, &summary);
+    ck_assert_uint_eq(summary.appended, 14);
+    ck_assert_uint_eq(summary.kept, 8);
+    ck_assert_uint_eq(summary.first_tick, 8);
+    ck_assert_uint_eq(summary.last_tick, 15);
+    ck_assert_uint_eq(summary.tick_gaps, 0); // The gap has been overwritten
+}
+END_TEST
+
+// --- CSV tests ---
+
+START_TEST(test_csv_rows)
+{
+    append_ticks(1, 3, 0);
+
+    char buffer[4096] = {0};
+    FILE *out = fmemopen(buffer, sizeof(buffer) - 1, "w");
+    ck_assert_ptr_ne(out, NULL);
+    write_telemetry_csv(out, &log_file);
+    fclose(out);
+
+    ck_assert(strncmp(buffer, "tick,time_ns,accelerator,brake,speed,", 37) == 0);
+    int lines = 0;
+    for (char *p = buffer; *p != '\0'; p++) {
+        lines += *p == '\n';
+    }
+    ck_assert_int_eq(lines, 4);
+    ck_assert_ptr_ne(strstr(buffer, "\n1,200000000,0,0,1.000000,"), NULL);
+    ck_assert_ptr_ne(strstr(buffer, ",start,,"), NULL);
+    ck_assert_ptr_ne(strstr(buffer, "\n3,600000000,"), NULL);
+}
+END_TEST
+
+// --- Replay tests ---
+
+// Records a bin/sim run of `script` into a new lockstep log of `capacity` ticks
+static void record_sim(const char *script_text, uint64_t capacity, Simulation *sim) {
+    telemetry_close(&log_file);
+    ck_assert_int_eq(telemetry_create(&log_file, path, capacity, VMU_PERIOD_NS, ENGINE_PERIOD_NS), 0);
+    PedalScript script;
+    ck_assert_int_eq(parse_pedal_script(script_text, &script), 1);
+    sim_init(sim, VMU_PERIOD_NS, ENGINE_PERIOD_NS);
+    sim->telemetry = &log_file;
+    sim_run_script(sim, &script, 1, NULL);
+}
+
+// Writable copy of a recorded tick, for planting a divergence
+static TelemetryRecord *record_of_tick(uint64_t tick) {
+    return (TelemetryRecord *)telemetry_get(&log_file, tick - 1);
+}
+
+START_TEST(test_replay_sim_recording)
+{
+    Simulation sim;
+    record_sim("1:60,0:30,2:10,1:200", 4096, &sim);
+
+    ReplayResult result;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 0);
+    ck_assert(result.lockstep);
+    ck_assert(!result.diverged);
+    ck_assert_uint_eq(result.ticks, sim.vmu_steps);
+    // Engine steps between the first and the last VMU step
+    ck_assert_uint_eq(result.engine_steps, sim.vmu_steps * VMU_PERIOD_NS / ENGINE_PERIOD_NS - VMU_PERIOD_NS / ENGINE_PERIOD_NS);
+}
+END_TEST
+
+START_TEST(test_replay_wrapped_recording)
+{
+    // Replay starts mid-run from the oldest kept tick, with the engine steps in phase
+    Simulation sim;
+    record_sim("1:60,0:30,2:10,1:200", 101, &sim);
+
+    ReplayResult result;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 0);
+    ck_assert_uint_eq(result.ticks, 101);
+}
+END_TEST
+
+START_TEST(test_replay_flags_first_divergence)
+{
+    Simulation sim;
+    record_sim("1:60,0:30,2:10", 4096, &sim);
+    ReplayResult result;
+
+    // A control decision off by one bit, then a speed update
+    double battery = record_of_tick(120)->after.battery;
+    record_of_tick(120)->after.battery = nextafter(battery, 0.0);
+    record_of_tick(200)->after.speed = 0.0;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 1);
+    ck_assert_uint_eq(result.tick, 120);
+    ck_assert_int_eq(result.stage, REPLAY_CONTROL);
+    ck_assert_str_eq(result.field, "battery");
+    ck_assert(result.recorded == nextafter(battery, 0.0) && result.replayed == battery);
+    ck_assert_uint_eq(result.ticks, 119);
+    record_of_tick(120)->after.battery = battery;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 1);
+    ck_assert_uint_eq(result.tick, 200);
+    ck_assert_int_eq(result.stage, REPLAY_SPEED);
+
+    // Rebuild the log and damage an engine step and a command instead
+    record_sim("1:60,0:30,2:10", 4096, &sim);
+    double temp_iec = record_of_tick(40)->before.temp_iec;
+    record_of_tick(40)->before.temp_iec += 0.5;
+    record_of_tick(60)->ev_command = TELEMETRY_NO_COMMAND;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 1);
+    ck_assert_uint_eq(result.tick, 40);
+    ck_assert_int_eq(result.stage, REPLAY_ENGINES);
+    ck_assert_str_eq(result.field, "temp_iec");
+    record_of_tick(40)->before.temp_iec = temp_iec;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 1);
+    ck_assert_uint_eq(result.tick, 60);
+    ck_assert_str_eq(result.field, "ev_command");
+}
+END_TEST
+
+// Records ticks the way the VMU process does: the engines move on their own, and may change
+// between the control law and the speed update
+static void record_live(int ticks) {
+    VehicleState vehicle;
+    init_vehicle_state(&vehicle);
+    for (int tick = 1; tick <= ticks; tick++) {
+        vehicle.accelerator = tick % 50 < 35;
+        vehicle.brake = tick % 50 >= 45;
+        // Engines: whatever the other processes last published
+        vehicle.ev_on = tick > 2;
+        vehicle.iec_on = tick > 30 && tick % 7 != 0;
+        vehicle.rpm_ev = tick * 13 % 5000;
+        vehicle.temp_ev = 25.0 + tick * 0.01;
+        vehicle.rpm_iec = vehicle.iec_on ? 800 + tick % 300 : 0;
+        vehicle.temp_iec = 40.0 + tick * 0.02;
+
+        VehicleState before = vehicle;
+        ControlCommands commands;
+        vmu_control_model(&vehicle, &commands);
+        VehicleState speed_input = vehicle;
+        speed_input.iec_on = tick % 11 == 0 ? !vehicle.iec_on : vehicle.iec_on;
+        vehicle.speed = speed_model(&speed_input);
+
+        TelemetryRecord record;
+        telemetry_record_fill(&record, (uint64_t)tick, &before, &commands, &speed_input, &vehicle);
+        record.time_ns = (uint64_t)tick * 200000000ULL;
+        telemetry_append(&log_file, &record);
+    }
+}
+
+START_TEST(test_replay_live_recording)
+{
+    telemetry_close(&log_file);
+    ck_assert_int_eq(telemetry_create(&log_file, path, 1000, VMU_PERIOD_NS, 0), 0);
+    record_live(500);
+
+    ReplayResult result;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 0);
+    ck_assert(!result.lockstep);
+    ck_assert_uint_eq(result.ticks, 500);
+    ck_assert_uint_eq(result.engine_steps, 0);
+
+    // calculate_speed() gets the engine status it read, not the one the control law read
+    record_of_tick(77)->speed_ev_on = 0;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 1);
+    ck_assert_uint_eq(result.tick, 77);
+    ck_assert_int_eq(result.stage, REPLAY_SPEED);
+    ck_assert_str_eq(result.field, "speed");
+    record_of_tick(77)->speed_ev_on = 1;
+
+    // Something else wrote the VMU block between two ticks
+    record_of_tick(300)->before.fuel -= 1.0;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 1);
+    ck_assert_uint_eq(result.tick, 300);
+    ck_assert_int_eq(result.stage, REPLAY_STATE);
+    ck_assert_str_eq(result.field, "fuel");
+}
+END_TEST
+
+// Rewrites the log without `tick`, as if the recorder had dropped it
+static void drop_tick(uint64_t tick) {
+    TelemetryHeader header = *log_file.header;
+    uint64_t first = telemetry_first(&log_file);
+    uint64_t count = telemetry_count(&log_file);
+    TelemetryRecord *records = malloc((count - first) * sizeof(TelemetryRecord));
+    uint64_t kept = 0;
+    ck_assert_ptr_nonnull(records);
+    for (uint64_t i = first; i < count; i++) {
+        if (telemetry_get(&log_file, i)->tick != tick) {
+            records[kept++] = *telemetry_get(&log_file, i);
+        }
+    }
+    telemetry_close(&log_file);
+    ck_assert_int_eq(telemetry_create(&log_file, path, header.capacity, header.period_ns, header.engine_period_ns), 0);
+    for (uint64_t i = 0; i < kept; i++) {
+        telemetry_append(&log_file, &records[i]);
+    }
+    free(records);
+}
+
+START_TEST(test_replay_restarts_after_gap)
+{
+    telemetry_close(&log_file);
+    ck_assert_int_eq(telemetry_create(&log_file, path, 1000, VMU_PERIOD_NS, 0), 0);
+    record_live(500);
+    drop_tick(250);
+
+    // The state recorded after the gap is not compared with the one before it
+    ReplayResult result;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 0);
+    ck_assert(!result.diverged);
+    ck_assert_uint_eq(result.ticks, 499);
+    ck_assert_uint_eq(result.gaps, 1);
+    ck_assert_uint_eq(result.ticks_missing, 1);
+    ck_assert_uint_eq(result.first_gap_tick, 251);
+
+    // Divergences after the gap are still found
+    drop_tick(260);
+    drop_tick(261);
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 0);
+    ck_assert_uint_eq(result.gaps, 2);
+    ck_assert_uint_eq(result.ticks_missing, 3);
+    record_of_tick(299 - 3)->before.fuel -= 1.0; // Tick 299, after the three dropped ones
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 1);
+    ck_assert_uint_eq(result.tick, 299);
+    ck_assert_int_eq(result.stage, REPLAY_STATE);
+    ck_assert_uint_eq(result.gaps, 2);
+
+    // A lockstep replay puts the engine steps back in phase after the gap
+    Simulation sim;
+    record_sim("1:60,0:30,2:10", 4096, &sim);
+    drop_tick(100);
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 0);
+    ck_assert_uint_eq(result.gaps, 1);
+    ck_assert_uint_eq(result.ticks, sim.vmu_steps - 1);
+    // The engine steps due between ticks 99 and 101 were not replayed
+    uint64_t skipped = 101 * VMU_PERIOD_NS / ENGINE_PERIOD_NS - 99 * VMU_PERIOD_NS / ENGINE_PERIOD_NS;
+    ck_assert_uint_eq(result.engine_steps, sim.vmu_steps * VMU_PERIOD_NS / ENGINE_PERIOD_NS - VMU_PERIOD_NS / ENGINE_PERIOD_NS - skipped);
+}
+END_TEST
+
+START_TEST(test_replay_empty)
+{
+    ReplayResult result;
+    ck_assert_int_eq(telemetry_replay(&log_file, &result), 0);
+    ck_assert_uint_eq(result.ticks, 0);
+}
+END_TEST
+
+// --- Main Test Suite Creation ---
+
+Suite *telemetry_suite(void) {
+    Suite *s;
+    TCase *tc_summary; // Summary tests
+    TCase *tc_csv;     // CSV export tests
+    TCase *tc_replay;  // Replay tests
+
+    s = suite_create("Telemetry Reader Tests");
+
+    tc_summary = tcase_create("Summary");
+    tcase_add_checked_fixture(tc_summary, setup, teardown);
+    tcase_add_test(tc_summary, test_summary_empty);
+    tcase_add_test(tc_summary, test_summary_intervals);
+    tcase_add_test(tc_summary, test_summary_wrapped_ring);
+    suite_add_tcase(s, tc_summary);
+
+    tc_csv = tcase_create("CSV");
+    tcase_add_checked_fixture(tc_csv, setup, teardown);
+    tcase_add_test(tc_csv, test_csv_rows);
+    suite_add_tcase(s, tc_csv);
+
+    tc_replay = tcase_create("Replay");
+    tcase_add_checked_fixture(tc_replay, setup, teardown);
+    tcase_add_test(tc_replay, test_replay_sim_recording);
+    tcase_add_test(tc_replay, test_replay_wrapped_recording);
+    tcase_add_test(tc_replay, test_replay_flags_first_divergence);
+    tcase_add_test(tc_replay, test_replay_live_recording);
+    tcase_add_test(tc_replay, test_replay_restarts_after_gap);
+    tcase_add_test(tc_replay, test_replay_empty);
+    suite_add_tcase(s, tc_replay);
+
+    return s;
+}
+
+int main(void) {
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = telemetry_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
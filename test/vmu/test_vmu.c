@@ -14,16 +14,27 @@
 #include <stdbool.h>
 #include <pthread.h>
 #include <time.h>
+#include <stddef.h>
+#include <sys/wait.h>
 #include "../../src/vmu/vmu.h"
+#include "../../src/vmu/vmu_model.h"
+#include "../../src/common/transport.h"
+#include "../../src/common/engine_thread.h"
 
 // --- Declare external globals from vmu.c ---
 // These are declared in vmu.c, we need to access them for testing setup/teardown
 extern SystemState *system_state;
 extern sem_t *sem;
-extern mqd_t ev_mq, iec_mq;
+extern Transport vmu_transport; // End of the transport opened by init_communication()
 extern volatile sig_atomic_t running;
 extern volatile sig_atomic_t paused;
 extern pthread_t input_thread;
+extern CommandTransport command_transport;
+extern bool power_mailbox;
+extern unsigned int ev_command_seq;
+extern StateLockMode state_lock_mode;
+extern ModuleRuntime module_runtime;
+extern EngineThread ev_engine, iec_engine;
 
 // --- Declare variables for the resources *created by EV/IEC* (simulating their setup) ---
 
@@ -90,8 +101,10 @@ void vmu_setup(void) {
     // Basic checks that init_communication succeeded
     ck_assert_ptr_ne(system_state, MAP_FAILED);
     ck_assert_ptr_ne(sem, SEM_FAILED);
-    ck_assert_int_ne(ev_mq, (mqd_t)-1);
-    ck_assert_int_ne(iec_mq, (mqd_t)-1);
+    if (command_transport == TRANSPORT_MQ) {
+        ck_assert_int_ne(vmu_transport.queues[TRANSPORT_EV], (mqd_t)-1);
+        ck_assert_int_ne(vmu_transport.queues[TRANSPORT_IEC], (mqd_t)-1);
+    }
     ck_assert_int_eq(running, 1);
     ck_assert_int_eq(paused, 0);
 
@@ -131,6 +144,56 @@ void vmu_teardown(void) {
     printf("Test Teardown VMU: VMU cleanup and dependent resources cleaned.\n");
 }
 
+// --- Fixture for the shared-memory command ring transport ---
+void vmu_ring_setup(void) {
+    command_transport = TRANSPORT_RING;
+    vmu_setup();
+    ck_assert_ptr_ne(vmu_transport.rings[TRANSPORT_EV], NULL);
+    ck_assert_ptr_ne(vmu_transport.rings[TRANSPORT_IEC], NULL);
+}
+
+void vmu_ring_teardown(void) {
+    vmu_teardown();
+    command_transport = TRANSPORT_MQ;
+}
+
+// --- Fixture for the robust state mutex ---
+void vmu_mutex_setup(void) {
+    state_lock_mode = STATE_LOCK_MUTEX;
+    vmu_setup();
+}
+
+void vmu_mutex_teardown(void) {
+    vmu_teardown();
+    state_lock_mode = STATE_LOCK_SEM;
+}
+
+// --- Fixture for the single-process runtime ---
+void vmu_threads_setup(void) {
+    module_runtime = RUNTIME_THREADS;
+    engine_thread_init(&ev_engine, ENGINE_EV, 1000000L, TICK_CATCH_UP, 0, false);
+    engine_thread_init(&iec_engine, ENGINE_IEC, 1000000L, TICK_CATCH_UP, 0, false);
+    running = 1;
+    paused = 0;
+
+    init_communication();
+    fclose(stdin); // The input thread returns at end of file
+
+    ck_assert_int_eq(running, 1);
+    ck_assert_ptr_ne(system_state, MAP_FAILED);
+    ck_assert_ptr_ne(vmu_transport.rings[TRANSPORT_EV], NULL);
+    ck_assert_ptr_ne(vmu_transport.rings[TRANSPORT_IEC], NULL);
+    ck_assert_int_eq(vmu_transport.commands, TRANSPORT_RING);
+    ck_assert_ptr_eq(sem, SEM_FAILED); // Nothing named is created
+}
+
+void vmu_threads_teardown(void) {
+    if (system_state != MAP_FAILED) {
+        cleanup();
+    }
+    module_runtime = RUNTIME_PROCESSES;
+}
+
 // --- Individual Test Cases ---
 
 START_TEST(test_vmu_init_communication_success)
@@ -166,6 +229,32 @@ START_TEST(test_vmu_init_system_state)
 }
 END_TEST
 
+START_TEST(test_vmu_system_state_block_layout)
+{
+    // Each single-writer block must start on its own cache line to avoid false sharing
+    ck_assert_int_eq(offsetof(SystemState, input_seq) % CACHE_LINE_SIZE, 0);
+    ck_assert_int_eq(offsetof(SystemState, vmu_seq) % CACHE_LINE_SIZE, 0);
+    ck_assert_int_eq(offsetof(SystemState, ev_seq) % CACHE_LINE_SIZE, 0);
+    ck_assert_int_eq(offsetof(SystemState, iec_seq) % CACHE_LINE_SIZE, 0);
+    ck_assert_msg(offsetof(SystemState, brake) < offsetof(SystemState, vmu_seq), "Input fields should stay in the input block");
+    ck_assert_msg(offsetof(SystemState, was_accelerating) < offsetof(SystemState, ev_seq), "VMU fields should stay in the VMU block");
+    ck_assert_msg(offsetof(SystemState, temp_ev) < offsetof(SystemState, iec_seq), "EV fields should stay in the EV block");
+}
+END_TEST
+
+START_TEST(test_vmu_set_acceleration_publishes_input_block)
+{
+    seqcount_t input_seq_before = system_state->input_seq;
+    seqcount_t vmu_seq_before = system_state->vmu_seq;
+
+    set_acceleration(true);
+
+    // Pedal updates are published in the input block only
+    ck_assert_msg(system_state->input_seq == input_seq_before + 2, "Input block sequence should advance");
+    ck_assert_msg(system_state->vmu_seq == vmu_seq_before, "VMU block sequence should not change");
+}
+END_TEST
+
 
 START_TEST(test_vmu_set_acceleration)
 {
@@ -509,6 +598,123 @@ START_TEST(test_vmu_control_engines_state_accel_ev_only_low_speed)
 }
 END_TEST
 
+START_TEST(test_vmu_control_engines_ring_sends_start)
+{
+    // Accelerating from standstill with the EV off: the START command must go through the ring
+    sem_wait(sem);
+    system_state->speed = 10.0;
+    system_state->accelerator = true;
+    system_state->brake = false;
+    system_state->ev_on = false;
+    system_state->iec_on = false;
+    sem_post(sem);
+
+    vmu_control_engines();
+
+    EngineCommand cmd;
+    ck_assert_int_eq(cmd_ring_pop(vmu_transport.rings[TRANSPORT_EV], &cmd), 0);
+    ck_assert_int_eq(cmd.type, CMD_START);
+    ck_assert_msg(cmd_ring_pop(vmu_transport.rings[TRANSPORT_IEC], &cmd) == -1, "No IEC command expected in EV-only mode");
+}
+END_TEST
+
+START_TEST(test_vmu_cleanup_ring_sends_end)
+{
+    EngineCommand cmd;
+
+    // cleanup() (run again by the teardown) must leave CMD_END in both rings before unmapping them
+    CommandRing *ev_view = open_command_ring(EV_COMMAND_RING_NAME, false);
+    CommandRing *iec_view = open_command_ring(IEC_COMMAND_RING_NAME, false);
+    ck_assert_ptr_ne(ev_view, NULL);
+    ck_assert_ptr_ne(iec_view, NULL);
+
+    cleanup();
+
+    ck_assert_int_eq(cmd_ring_pop(ev_view, &cmd), 0);
+    ck_assert_int_eq(cmd.type, CMD_END);
+    ck_assert_int_eq(cmd_ring_pop(iec_view, &cmd), 0);
+    ck_assert_int_eq(cmd.type, CMD_END);
+
+    close_command_ring(ev_view);
+    close_command_ring(iec_view);
+    init_communication(); // Give the teardown something to clean up
+}
+END_TEST
+
+START_TEST(test_vmu_threads_engines_follow_commands)
+{
+    struct timespec pause = { 0, 1000000L };
+    bool ev_on = false;
+    int rpm_ev = 0;
+    double temp_ev;
+
+    // Accelerating from standstill: the EV thread receives START and spins up on the published level
+    set_acceleration(true);
+    vmu_control_engines();
+    for (int i = 0; i < 1000 && !(ev_on && rpm_ev > 0); i++) {
+        nanosleep(&pause, NULL);
+        snapshot_ev_block(system_state, &ev_on, &rpm_ev, &temp_ev);
+    }
+    ck_assert(ev_on);
+    ck_assert_int_gt(rpm_ev, 0);
+    ck_assert(!system_state->iec_on);
+
+    // cleanup() sends CMD_END and waits for both threads
+    cleanup();
+    ck_assert_uint_gt(ev_engine.loop.physics.ticks, 0);
+    ck_assert_uint_gt(iec_engine.loop.physics.ticks, 0);
+    ck_assert_uint_eq(ev_engine.loop.commands_lost, 0);
+    ck_assert_ptr_eq(system_state, MAP_FAILED); // Unmapped: nothing left for the teardown
+}
+END_TEST
+
+START_TEST(test_vmu_control_engines_stamps_commands)
+{
+    // Every command sent to an engine carries its next sequence number and the decision time
+    sem_wait(sem);
+    system_state->speed = 10.0;
+    system_state->accelerator = true;
+    system_state->brake = false;
+    system_state->ev_on = false;
+    system_state->iec_on = false;
+    sem_post(sem);
+
+    unsigned int seq_before = ev_command_seq;
+    unsigned long long before_ns = monotonic_ns();
+    vmu_control_engines();
+
+    EngineCommand cmd;
+    ck_assert_int_ne(mq_receive(test_ev_mq_receive_sim, (char *)&cmd, sizeof(cmd), NULL), -1);
+    ck_assert_int_eq(cmd.type, CMD_START);
+    ck_assert_int_eq(cmd.seq, seq_before + 1);
+    ck_assert_msg(cmd.sent_ns >= before_ns && cmd.sent_ns <= monotonic_ns(), "Command should carry its monotonic issue time");
+}
+END_TEST
+
+START_TEST(test_vmu_control_engines_mailbox_set_power)
+{
+    // EV already running: its power setpoint goes to the mailbox and nothing is queued
+    power_mailbox = true;
+    sem_wait(sem);
+    system_state->speed = 10.0;
+    system_state->accelerator = true;
+    system_state->brake = false;
+    system_state->ev_on = true;
+    system_state->iec_on = false;
+    sem_post(sem);
+
+    vmu_control_engines();
+    vmu_control_engines();
+    power_mailbox = false;
+
+    struct mq_attr attr;
+    mq_getattr(test_ev_mq_receive_sim, &attr);
+    ck_assert_int_eq(attr.mq_curmsgs, 0);
+    ck_assert_int_eq(system_state->ev_mailbox.version, 2);
+    ck_assert_msg(system_state->ev_mailbox.power_level == system_state->ev_power_level, "Mailbox should hold the latest commanded power");
+}
+END_TEST
+
 START_TEST(test_vmu_control_engines_state_accel_hybrid_medium_speed)
 {
     // Setup: Accelerating, medium speed (>40), EV/IEC should be on, battery/fuel OK
@@ -709,6 +915,18 @@ START_TEST(test_vmu_calculate_speed_engine_braking_effect)
 }
 END_TEST
 
+START_TEST(test_vmu_calculate_speed_publishes_sequence)
+{
+    // Writers must leave the sequence counter even (no write in progress) and advance it
+    seqcount_t seq_before = system_state->vmu_seq;
+    ck_assert_msg((seq_before & 1U) == 0, "Sequence should be even before the update");
+
+    calculate_speed(system_state);
+
+    ck_assert_msg(system_state->vmu_seq == seq_before + 2, "Sequence should advance by one write section");
+}
+END_TEST
+
 START_TEST(test_vmu_control_engines_state_accel_high_speed_hybrid)
 {
     // Test high speed (close to MAX) situation in hybrid mode
@@ -1007,8 +1225,180 @@ START_TEST(test_vmu_control_engines_power_ramping)
 }
 END_TEST
 
+// --- Tests for the state lock ---
+
+START_TEST(test_vmu_state_mutex_write_sections)
+{
+    ck_assert_int_eq(system_state->lock_mode, STATE_LOCK_MUTEX);
+
+    set_acceleration(true);
+    vmu_control_engines();
+    calculate_speed(system_state);
+
+    // Every section has ended and released the mutex
+    ck_assert_uint_eq(system_state->input_seq % 2, 0);
+    ck_assert_uint_eq(system_state->vmu_seq % 2, 0);
+    ck_assert_int_eq(pthread_mutex_trylock(&system_state->state_mutex), 0);
+    pthread_mutex_unlock(&system_state->state_mutex);
+    ck_assert_uint_eq(system_state->state_recoveries, 0);
+}
+END_TEST
+
+START_TEST(test_vmu_state_repair)
+{
+    SystemState state;
+    memset(&state, 0, sizeof(state));
+    init_system_state(&state);
+    ck_assert_int_eq(system_state_repair(&state), 0); // A consistent state is left as it is
+
+    state.input_seq = 7; // Writers that died inside their sections
+    state.iec_seq = 3;
+    state.accelerator = true;
+    state.brake = true;
+    state.speed = NAN;
+    state.battery = 150.0;
+    state.power_mode = 9;
+    state.ev_power_level = -0.5;
+    state.rpm_iec = MAX_IEC_RPM + 1;
+    state.temp_ev = NAN;
+
+    ck_assert_int_eq(system_state_repair(&state), 9);
+    ck_assert_uint_eq(state.input_seq % 2, 0);
+    ck_assert_uint_eq(state.iec_seq % 2, 0);
+    ck_assert(!state.accelerator && state.brake);
+    ck_assert(state.speed == MIN_SPEED);
+    ck_assert(state.battery == MAX_BATTERY);
+    ck_assert_int_eq(state.power_mode, 4);
+    ck_assert(state.ev_power_level == 0.0);
+    ck_assert_int_eq(state.rpm_iec, 0);
+    ck_assert(state.temp_ev == 25.0);
+    ck_assert(state.fuel == MAX_FUEL); // In range, untouched
+}
+END_TEST
+
+START_TEST(test_vmu_state_mutex_recovers_dead_writer)
+{
+    SystemState *state = mmap(NULL, sizeof(SystemState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ck_assert_ptr_ne(state, MAP_FAILED);
+    init_system_state(state);
+    ck_assert_int_eq(state_lock_init(state, STATE_LOCK_MUTEX), 0);
+
+    // An engine dies in the middle of publishing its block
+    pid_t child = fork();
+    if (child == 0) {
+        state_write_begin(state, &state->ev_seq);
+        state->rpm_ev = -1234;
+        _exit(EXIT_SUCCESS);
+    }
+    ck_assert_int_ne(child, -1);
+    waitpid(child, NULL, 0);
+    ck_assert_uint_eq(state->ev_seq % 2, 1);
+
+    // A reader neither spins forever nor sees the torn block
+    bool ev_on;
+    int rpm_ev;
+    double temp_ev;
+    snapshot_ev_block(state, &ev_on, &rpm_ev, &temp_ev);
+    ck_assert_int_eq(rpm_ev, 0);
+    ck_assert(temp_ev == 25.0);
+    ck_assert_uint_eq(state->state_recoveries, 1);
+
+    // The mutex is consistent again for the next writer
+    bool locked = state_write_begin(state, &state->ev_seq);
+    state->rpm_ev = 1500;
+    state_write_end(state, &state->ev_seq, locked);
+    snapshot_ev_block(state, &ev_on, &rpm_ev, &temp_ev);
+    ck_assert_int_eq(rpm_ev, 1500);
+    ck_assert_uint_eq(state->state_recoveries, 1);
+    munmap(state, sizeof(SystemState));
+}
+END_TEST
+
+START_TEST(test_vmu_state_mutex_unrecoverable_stops)
+{
+    SystemState *state = mmap(NULL, sizeof(SystemState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ck_assert_ptr_ne(state, MAP_FAILED);
+    init_system_state(state);
+    ck_assert_int_eq(state_lock_init(state, STATE_LOCK_MUTEX), 0);
+
+    // A holder dies and the next one releases the mutex without making it consistent
+    pid_t child = fork();
+    if (child == 0) {
+        pthread_mutex_lock(&state->state_mutex);
+        _exit(EXIT_SUCCESS);
+    }
+    ck_assert_int_ne(child, -1);
+    waitpid(child, NULL, 0);
+    ck_assert_int_eq(pthread_mutex_lock(&state->state_mutex), EOWNERDEAD);
+    pthread_mutex_unlock(&state->state_mutex);
+    ck_assert_int_eq(state_mutex_lock(state), -1);
+    ck_assert_int_eq(errno, ENOTRECOVERABLE);
+
+    // A writer stops instead of publishing unlocked
+    int status;
+    child = fork();
+    if (child == 0) {
+        bool locked = state_write_begin(state, &state->ev_seq);
+        state->rpm_ev = 1234;
+        state_write_end(state, &state->ev_seq, locked);
+        _exit(EXIT_SUCCESS);
+    }
+    ck_assert_int_ne(child, -1);
+    waitpid(child, &status, 0);
+    ck_assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    ck_assert_uint_eq(state->ev_seq % 2, 0);
+    ck_assert_int_eq(state->rpm_ev, 0);
+
+    // So does a reader left waiting on a section that can never end
+    state->ev_seq = 1;
+    child = fork();
+    if (child == 0) {
+        bool ev_on;
+        int rpm_ev;
+        double temp_ev;
+        snapshot_ev_block(state, &ev_on, &rpm_ev, &temp_ev);
+        _exit(EXIT_SUCCESS);
+    }
+    ck_assert_int_ne(child, -1);
+    waitpid(child, &status, 0);
+    ck_assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    munmap(state, sizeof(SystemState));
+}
+END_TEST
+
 // --- Tests for display_status ---
 
+START_TEST(test_vmu_load_vehicle_state)
+{
+    // The one SystemState -> VehicleState copy used by the control tick, the screen and the telemetry
+    init_system_state(system_state);
+    system_state->speed = 42.0;
+    system_state->battery = 55.0;
+    system_state->fuel = 33.0;
+    system_state->power_mode = 0;
+    system_state->ev_power_level = 0.4;
+    system_state->iec_power_level = 0.2;
+    system_state->was_accelerating = true;
+    set_acceleration(true);
+    system_state->ev_on = true;
+    system_state->rpm_ev = 3000;
+    system_state->temp_ev = 40.0;
+    system_state->iec_on = true;
+    system_state->rpm_iec = 1500;
+    system_state->temp_iec = 60.0;
+
+    VehicleState vehicle;
+    load_vehicle_state(system_state, &vehicle);
+    ck_assert(vehicle.accelerator && !vehicle.brake);
+    ck_assert(vehicle.speed == 42.0 && vehicle.battery == 55.0 && vehicle.fuel == 33.0);
+    ck_assert_int_eq(vehicle.power_mode, 0);
+    ck_assert(vehicle.ev_power_level == 0.4 && vehicle.iec_power_level == 0.2);
+    ck_assert(vehicle.was_accelerating);
+    ck_assert(vehicle.ev_on && vehicle.rpm_ev == 3000 && vehicle.temp_ev == 40.0);
+    ck_assert(vehicle.iec_on && vehicle.rpm_iec == 1500 && vehicle.temp_iec == 60.0);
+}
+END_TEST
+
 START_TEST(test_vmu_display_status_runs)
 {
     // Test calling display_status with various representative states.
@@ -1309,6 +1699,10 @@ Suite *vmu_suite(void) {
     TCase *tc_engine_control_state; // Engine control logic state tests
     TCase *tc_display; // Display function tests
     TCase *tc_transitions; // State transition and edge case tests
+    TCase *tc_ring; // Shared-memory command ring transport tests
+    TCase *tc_state_lock; // Robust state mutex tests
+    TCase *tc_state_repair; // Owner-death recovery tests
+    TCase *tc_threads; // Single-process runtime tests
 
     s = suite_create("VMU Module Tests");
 
@@ -1317,6 +1711,8 @@ Suite *vmu_suite(void) {
     tcase_add_checked_fixture(tc_core, vmu_setup, vmu_teardown);
     tcase_add_test(tc_core, test_vmu_init_communication_success);
     tcase_add_test(tc_core, test_vmu_init_system_state); 
+    tcase_add_test(tc_core, test_vmu_system_state_block_layout);
+    tcase_add_test(tc_core, test_vmu_set_acceleration_publishes_input_block);
     suite_add_tcase(s, tc_core);
 
     // Control tests (set_acceleration, set_braking)
@@ -1341,6 +1737,7 @@ Suite *vmu_suite(void) {
     tcase_add_test(tc_speed, test_vmu_calculate_speed_exact_at_min_speed);
     tcase_add_test(tc_speed, test_vmu_calculate_speed_near_max_speed);
     tcase_add_test(tc_speed, test_vmu_calculate_speed_engine_braking_effect);
+    tcase_add_test(tc_speed, test_vmu_calculate_speed_publishes_sequence);
     suite_add_tcase(s, tc_speed);
 
 
@@ -1355,6 +1752,8 @@ Suite *vmu_suite(void) {
     tc_engine_control_state = tcase_create("EngineControlState");
     tcase_add_checked_fixture(tc_engine_control_state, vmu_setup, vmu_teardown);
     tcase_add_test(tc_engine_control_state, test_vmu_control_engines_state_accel_ev_only_low_speed);
+    tcase_add_test(tc_engine_control_state, test_vmu_control_engines_mailbox_set_power);
+    tcase_add_test(tc_engine_control_state, test_vmu_control_engines_stamps_commands);
     tcase_add_test(tc_engine_control_state, test_vmu_control_engines_state_accel_ok_fuel_ok_battery_low_speed_ev_only);
     tcase_add_test(tc_engine_control_state, test_vmu_control_engines_state_accel_hybrid_medium_speed);
     tcase_add_test(tc_engine_control_state, test_vmu_control_engines_state_braking_regen);
@@ -1381,9 +1780,33 @@ Suite *vmu_suite(void) {
     tcase_add_test(tc_transitions, test_vmu_control_engines_power_ramping);
     suite_add_tcase(s, tc_transitions);
 
+    // Shared-memory command ring transport
+    tc_ring = tcase_create("RingTransport");
+    tcase_add_checked_fixture(tc_ring, vmu_ring_setup, vmu_ring_teardown);
+    tcase_add_test(tc_ring, test_vmu_control_engines_ring_sends_start);
+    tcase_add_test(tc_ring, test_vmu_cleanup_ring_sends_end);
+    suite_add_tcase(s, tc_ring);
+
+    tc_threads = tcase_create("ThreadedRuntime");
+    tcase_add_checked_fixture(tc_threads, vmu_threads_setup, vmu_threads_teardown);
+    tcase_add_test(tc_threads, test_vmu_threads_engines_follow_commands);
+    suite_add_tcase(s, tc_threads);
+
     // Display function tests
+    tc_state_lock = tcase_create("StateMutex");
+    tcase_add_checked_fixture(tc_state_lock, vmu_mutex_setup, vmu_mutex_teardown);
+    tcase_add_test(tc_state_lock, test_vmu_state_mutex_write_sections);
+    suite_add_tcase(s, tc_state_lock);
+
+    tc_state_repair = tcase_create("StateRepair");
+    tcase_add_test(tc_state_repair, test_vmu_state_repair);
+    tcase_add_test(tc_state_repair, test_vmu_state_mutex_recovers_dead_writer);
+    tcase_add_test(tc_state_repair, test_vmu_state_mutex_unrecoverable_stops);
+    suite_add_tcase(s, tc_state_repair);
+
     tc_display = tcase_create("Display");
     tcase_add_checked_fixture(tc_display, vmu_setup, vmu_teardown);
+    tcase_add_test(tc_display, test_vmu_load_vehicle_state);
     tcase_add_test(tc_display, test_vmu_display_status_runs);
     suite_add_tcase(s, tc_display);
 